@@ -3,14 +3,93 @@
 #include "Solvers.h"
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <algorithm>
 #include <cmath>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <set>
+#include <functional>
+#include "ResultCache.h"
+#include "ExponentialIntegrator.h"
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/map.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/string.hpp>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
+// --- CachedResult ---
+size_t CachedResult::byteSize() const {
+    size_t bytes = sizeof(*this) + analysis.size() + axis.size() * sizeof(double);
+    for (const auto& pair : real) bytes += pair.first.size() + pair.second.size() * sizeof(double);
+    for (const auto& pair : complex) bytes += pair.first.size() + pair.second.size() * sizeof(Complex);
+    return bytes;
+}
+
+// --- Element classification ---
+namespace {
+// Elements whose MNA stamps do not depend on the solution
+bool isLinearElementType(const std::string& type) {
+    static const std::set<std::string> linear_types = {
+        "Resistor", "Capacitor", "Inductor", "MutualInductance", "Ground", "Wire",
+        "IndependentVoltageSource", "PulseVoltageSource", "WaveformVoltageSource", "PhaseVoltageSource",
+        "SinusoidalVoltageSource", "ACVoltageSource", "IndependentCurrentSource", "PulseCurrentSource",
+        "VoltageControlledVoltageSource", "CurrentControlledCurrentSource", "CurrentControlledVoltageSource"};
+    return linear_types.count(type) > 0;
+}
+}
+
+// --- TransientCheckpoint ---
+namespace {
+const char CHECKPOINT_MAGIC[8] = {'C', 'K', 'T', 'T', 'R', 'A', 'N', '\0'};
+}
+
+void TransientCheckpoint::save(const std::string& path) const {
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream os(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!os) throw std::runtime_error("Could not open checkpoint file for writing: " + temp_path);
+        os.write(CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+        cereal::PortableBinaryOutputArchive archive(os);
+        uint32_t version = VERSION;
+        archive(version, *this, source_currents);
+        os.flush();
+        if (!os) throw std::runtime_error("Failed writing checkpoint file: " + temp_path);
+    }
+    // A crash while writing leaves the previous checkpoint intact
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error("Could not replace checkpoint file: " + path);
+    }
+}
+
+TransientCheckpoint TransientCheckpoint::load(const std::string& path) {
+    std::ifstream is(path, std::ios::in | std::ios::binary);
+    if (!is) throw std::runtime_error("Could not open checkpoint file: " + path);
+    char magic[sizeof(CHECKPOINT_MAGIC)] = {};
+    is.read(magic, sizeof(magic));
+    if (!is || !std::equal(magic, magic + sizeof(magic), CHECKPOINT_MAGIC)) {
+        throw std::runtime_error("Not a transient checkpoint file: " + path);
+    }
+    TransientCheckpoint checkpoint;
+    try {
+        cereal::PortableBinaryInputArchive archive(is);
+        uint32_t version = 0;
+        archive(version);
+        if (version < 1 || version > VERSION) throw std::runtime_error("unsupported version " + std::to_string(version));
+        archive(checkpoint);
+        if (version >= 2) archive(checkpoint.source_currents);
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Corrupt checkpoint file " + path + ": " + e.what());
+    }
+    return checkpoint;
+}
+
 // --- TransientAnalysis Implementation ---
 TransientAnalysis::TransientAnalysis(double t_step, double t_stop, bool uic_flag)
     : Tstep(t_step), Tstop(t_stop), use_uic(uic_flag) {
@@ -22,16 +101,29 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
     results.clear();
     time_points.clear();
     plot_vars.clear();
+    complete = false;
+    topology_hits = topology_factorisations = 0;
+    mna_matrix.invalidateCaches();
 
     NodeIndexMap node_map;
     std::vector<Node*> non_ground_nodes;
     circuit.getNonGroundNodes(non_ground_nodes, node_map);
 
+    // Switches start from their initial state; the operating point uses it too
+    std::vector<Switch*> switches;
+    for (const auto& elem : circuit.getElements()) {
+        if (elem->getType() == "Switch") {
+            switches.push_back(static_cast<Switch*>(elem.get()));
+            switches.back()->resetState();
+        }
+    }
+    TopologyLUCache lu_cache;
+
     std::map<std::string, int> vs_map, l_map;
     int vs_counter = 0, l_counter = 0;
     for (const auto& elem : circuit.getElements()) {
         const std::string& type = elem->getType();
-        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource" || type == "CurrentControlledVoltageSource") {
+        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource" || type == "BehavioralVoltageSource" || type == "CurrentControlledVoltageSource") {
             vs_map[elem->getName()] = vs_counter++;
         } else if (type == "Inductor") {
             l_map[elem->getName()] = l_counter++;
@@ -39,15 +131,30 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
     }
     initializeResults(circuit, node_map, vs_map, l_map);
 
+    if (method == TransientMethod::EXPONENTIAL) {
+        if (resume_state || !checkpoint_path.empty()) {
+            ErrorManager::info("[TRAN] checkpoint/resume uses the companion-model loop; exponential integrator not used");
+        } else if (analyzeExponential(circuit, mna_matrix, solver, node_map, vs_map, l_map)) {
+            logCompletion(analysis_start);
+            return;
+        }
+    }
+
     Vector x_current;
+    double t_begin = 0.0;
+    bool op_converged = true, solver_failed = false;
 
-    if (use_uic) {
+    if (resume_state) {
+        restoreCheckpoint(circuit, mna_matrix, *resume_state, x_current);
+        t_begin = resume_state->t + Tstep;
+    } else if (use_uic) {
         x_current.assign(node_map.size() + vs_map.size() + l_map.size(), 0.0);
         std::map<std::string, double> zero_voltages;
         for(const auto& pair : node_map) zero_voltages[pair.first] = 0.0;
         if(circuit.checkGroundNodeExists()) zero_voltages[circuit.getGroundNodeId()] = 0.0;
         circuit.updatePreviousNodeVoltages(zero_voltages);
         circuit.updatePreviousInductorCurrents({});
+        circuit.updatePreviousSourceCurrents({});
         ErrorManager::info("[TRAN] Using UIC: Zero initial conditions");
     } else {
         std::map<std::string, double> initial_guess;
@@ -55,6 +162,7 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
         if (circuit.checkGroundNodeExists()) initial_guess[circuit.getGroundNodeId()] = 0.0;
         circuit.updatePreviousNodeVoltages(initial_guess);
         circuit.updatePreviousInductorCurrents({});
+        circuit.updatePreviousSourceCurrents({});
 
         const int max_dc_iterations = 100;
         const double dc_tolerance = 1e-6;
@@ -77,6 +185,7 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
                 }
 
                 circuit.updatePreviousNodeVoltages(new_voltages);
+                mna_matrix.recordSourceCurrents(circuit, x_current);
 
                 if (max_delta < dc_tolerance) {
                     converged = true;
@@ -89,11 +198,53 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
         }
         if (!converged) {
             ErrorManager::displayError("DC operating point did not converge. Proceeding with zero initial conditions.");
+            op_converged = false;
+        }
+    }
+
+    // Transmission lines keep a history of port waves seeded from the operating point
+    std::vector<TransmissionLine*> lines;
+    for (const auto& elem : circuit.getElements()) {
+        if (elem->getType() == "TransmissionLine") {
+            lines.push_back(static_cast<TransmissionLine*>(elem.get()));
+            lines.back()->beginTransient(Tstep, circuit.previous_node_voltages);
+        }
+    }
+    if (resume_state) {
+        // Lines and switches were reset above; their run-time state comes from the checkpoint
+        for (const auto& elem : circuit.getElements()) {
+            auto it = resume_state->element_states.find(elem->getName());
+            if (it != resume_state->element_states.end()) elem->restoreTransientState(it->second);
         }
     }
 
-    for (double t = 0; t <= Tstop + Tstep/2.0 + 1e-12; t += Tstep) {
+    // Checkpoints record the loop time of the last completed step, so a resumed run
+    // continues on exactly the same time grid
+    double t_done = resume_state ? resume_state->t : -1.0;
+    auto last_checkpoint = std::chrono::steady_clock::now();
+    auto writeCheckpoint = [&]() {
+        if (checkpoint_path.empty() || t_done < 0.0) return;
         try {
+            makeCheckpoint(circuit, mna_matrix, t_done, x_current).save(checkpoint_path);
+            ErrorManager::info("[TRAN] checkpoint written at t=" + std::to_string(t_done) + " to " + checkpoint_path);
+        } catch (const std::exception& e) {
+            ErrorManager::warn("[TRAN] checkpoint failed: " + std::string(e.what()));
+        }
+        last_checkpoint = std::chrono::steady_clock::now();
+    };
+    auto checkpointDue = [&]() {
+        return !checkpoint_path.empty() &&
+               std::chrono::duration<double>(std::chrono::steady_clock::now() - last_checkpoint).count() >= checkpoint_interval;
+    };
+
+    for (double t = t_begin; t <= Tstop + Tstep/2.0 + 1e-12; t += Tstep) {
+        try {
+            if (t > 0 && !switches.empty()) {
+                advanceSwitchedStep(circuit, mna_matrix, solver, switches, lines, lu_cache, t, node_map, vs_map, l_map, x_current);
+                t_done = t;
+                if (checkpointDue()) writeCheckpoint();
+                continue;
+            }
             if (t > 0) {
                 mna_matrix.build(circuit, true, t, Tstep);
                 x_current = solver.solve(mna_matrix.getA(), mna_matrix.getRHS());
@@ -113,11 +264,31 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
             }
             time_points.push_back(t);
             extractResults(x_current, circuit, node_map, vs_map, l_map);
+            mna_matrix.recordSourceCurrents(circuit, x_current);
+            for (auto* line : lines) line->acceptStep(t, circuit.previous_node_voltages);
+            if (t == 0) {
+                // Voltage-controlled switches settle to the operating point before the first step
+                for (auto* sw : switches) {
+                    if (sw->wantsToggle(circuit.previous_node_voltages)) sw->toggle();
+                }
+            }
+            t_done = t;
+            if (checkpointDue()) writeCheckpoint();
         } catch (const std::runtime_error& e) {
             ErrorManager::displayError("Solver failed at t=" + std::to_string(t) + "s: " + e.what());
+            solver_failed = true;
             break;
         }
     }
+    writeCheckpoint();
+    complete = op_converged && !solver_failed;
+    topology_hits = lu_cache.hits();
+    topology_factorisations = lu_cache.misses();
+
+    if (!switches.empty()) {
+        ErrorManager::info("[TRAN] switch topology LU cache: " + std::to_string(lu_cache.hits()) + " hits, " +
+                           std::to_string(lu_cache.misses()) + " factorisations");
+    }
 
     // Safety: if nothing was produced, generate a minimal time axis and zeros so UI can render
     if (time_points.empty()) {
@@ -127,6 +298,10 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
         }
     }
     
+    logCompletion(analysis_start);
+}
+
+void TransientAnalysis::logCompletion(std::chrono::high_resolution_clock::time_point analysis_start) const {
     // Log analysis completion time and summary
     auto analysis_end = std::chrono::high_resolution_clock::now();
     auto analysis_duration = std::chrono::duration_cast<std::chrono::milliseconds>(analysis_end - analysis_start);
@@ -148,6 +323,179 @@ void TransientAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const L
     }
 }
 
+bool TransientAnalysis::analyzeExponential(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const NodeIndexMap& node_map,
+                                           const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map) {
+    std::vector<const WaveformVoltageSource*> waveforms;
+    for (const auto& elem : circuit.getElements()) {
+        const std::string& type = elem->getType();
+        if (!isLinearElementType(type)) {
+            ErrorManager::info("[TRAN] exponential integrator needs a linear circuit (" + elem->getName() + " is " + type + "); using backward Euler");
+            return false;
+        }
+        if (type == "WaveformVoltageSource") waveforms.push_back(static_cast<const WaveformVoltageSource*>(elem.get()));
+    }
+
+    // The transient build is A(h) = G + C/h, so builds at h = Tstep and h = Tstep/2 give
+    // C/Tstep as their difference. At h = Tstep the C/h terms are on the scale of G, so
+    // the difference keeps C's digits; at h = 1 it would cancel them against G.
+    // With zero history the right-hand side is the input b(t) alone.
+    auto input = [&](double t) {
+        circuit.updatePreviousNodeVoltages({});
+        circuit.updatePreviousInductorCurrents({});
+        circuit.updatePreviousSourceCurrents({});
+        mna_matrix.build(circuit, true, t, Tstep);
+        return mna_matrix.getRHS();
+    };
+    circuit.updatePreviousNodeVoltages({});
+    circuit.updatePreviousInductorCurrents({});
+    circuit.updatePreviousSourceCurrents({});
+    mna_matrix.build(circuit, true, 0.0, Tstep);
+    Matrix G = mna_matrix.getA();
+    mna_matrix.build(circuit, true, 0.0, 0.5 * Tstep);
+    const Matrix& A_half = mna_matrix.getA();
+    Matrix C = G;
+    for (size_t i = 0; i < G.size(); ++i) {
+        for (size_t j = 0; j < G.size(); ++j) {
+            const double c_over_h = A_half[i][j] - G[i][j];
+            C[i][j] = c_over_h * Tstep;
+            G[i][j] -= c_over_h;
+        }
+    }
+    std::unique_ptr<ExponentialIntegrator> integrator;
+    try {
+        integrator = std::make_unique<ExponentialIntegrator>(C, G);
+    } catch (const std::runtime_error& e) {
+        ErrorManager::warn("[TRAN] " + std::string(e.what()) + " Using backward Euler.");
+        return false;
+    }
+    ErrorManager::info("[TRAN] exponential integrator: " + std::to_string(integrator->size()) + " unknowns, " +
+                       std::to_string(integrator->order()) + " dynamic states");
+
+    Vector x0(G.size(), 0.0);
+    bool op_converged = true;
+    if (!use_uic) {
+        try {
+            mna_matrix.build(circuit, false, 0.0, 0.0);
+            x0 = solver.solve(mna_matrix.getA(), mna_matrix.getRHS());
+        } catch (const std::exception& e) {
+            ErrorManager::displayError("DC operating point analysis failed: " + std::string(e.what()) + ". Proceeding with zero initial conditions.");
+            x0.assign(G.size(), 0.0);
+            op_converged = false;
+        }
+    }
+    Vector y = integrator->reduce(x0);
+
+    // Input kinks inside a step split it so b stays linear on every piece. Offsets are
+    // snapped to 2^-36 of a step so periodic edges reuse the same cached propagators.
+    const double quantum = std::ldexp(Tstep, -36);
+    std::vector<double> cuts;
+    auto collectCuts = [&](double t_from, double t_to) {
+        cuts.clear();
+        for (double bp : mna_matrix.getSourceBank().getBreakpoints(t_from, t_to)) cuts.push_back(bp - t_from);
+        for (const auto* wave : waveforms) {
+            const double fs = wave->getSamplingRate();
+            if (wave->isStreamed() || fs <= 0.0 || fs * Tstep > 16.0) continue; // Band-limited or dense: linear per step
+            cuts.push_back(wave->getStartTime() - t_from);
+            for (double k = std::ceil((t_from - wave->getStartTime()) * fs); ; k += 1.0) {
+                const double bp = wave->getStartTime() + k / fs;
+                if (bp > t_to) break;
+                cuts.push_back(bp - t_from);
+            }
+        }
+        for (double& offset : cuts) offset = std::round(offset / quantum) * quantum;
+        cuts.erase(std::remove_if(cuts.begin(), cuts.end(), [&](double offset) { return offset <= 0.0 || offset >= Tstep; }), cuts.end());
+        std::sort(cuts.begin(), cuts.end());
+        cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+        cuts.push_back(Tstep);
+    };
+
+    Vector b_prev = input(0.0);
+    time_points.push_back(0.0);
+    extractResults(integrator->expand(y, b_prev), circuit, node_map, vs_map, l_map);
+    double t_prev = 0.0;
+    size_t substeps = 0;
+    for (double t = Tstep; t <= Tstop + Tstep/2.0 + 1e-12; t += Tstep) {
+        collectCuts(t_prev, t);
+        double offset = 0.0;
+        for (double cut : cuts) {
+            Vector b_cut = (cut == Tstep) ? input(t) : input(t_prev + cut);
+            y = integrator->step(y, cut - offset, b_prev, b_cut);
+            b_prev = std::move(b_cut);
+            offset = cut;
+            ++substeps;
+        }
+        time_points.push_back(t);
+        extractResults(integrator->expand(y, b_prev), circuit, node_map, vs_map, l_map);
+        t_prev = t;
+    }
+    ErrorManager::info("[TRAN] exponential integrator: " + std::to_string(substeps) + " substeps, " +
+                       std::to_string(integrator->cachedSteps()) + " cached propagators");
+    complete = op_converged;
+    return true;
+}
+
+void TransientAnalysis::advanceSwitchedStep(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const std::vector<Switch*>& switches,
+                                            const std::vector<TransmissionLine*>& lines, TopologyLUCache& lu_cache, double t,
+                                            const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map,
+                                            const std::map<std::string, int>& l_map, Vector& x_current) {
+    const int MAX_LOCATED_EVENTS = 16;         // Per step; further crossings toggle at the step end
+    const double EVENT_TOLERANCE = 1e-6 * Tstep; // Bisection stops at this interval width
+
+    // Only full steps repeat, so only they go through the cache (keyed on the switch
+    // configuration); bisection midpoints and post-event remainders are one-off solves
+    auto solveTo = [&](double t_from, double t_to) {
+        if (std::abs((t_to - t_from) - Tstep) <= EVENT_TOLERANCE) {
+            mna_matrix.build(circuit, true, t_to, Tstep);
+            std::ostringstream key;
+            for (const auto* sw : switches) key << (sw->isOn() ? '1' : '0');
+            key << '@' << std::hexfloat << Tstep;
+            return lu_cache.solve(key.str(), mna_matrix.getA(), mna_matrix.getRHS());
+        }
+        mna_matrix.build(circuit, true, t_to, t_to - t_from);
+        return solver.solve(mna_matrix.getA(), mna_matrix.getRHS());
+    };
+    auto anyVoltageToggle = [&](const Vector& x) {
+        std::map<std::string, double> voltages;
+        for (const auto& pair : node_map) voltages[pair.first] = x[pair.second];
+        for (const auto* sw : switches) {
+            if (sw->wantsToggle(voltages)) return true;
+        }
+        return false;
+    };
+
+    double t_from = time_points.back();
+    for (int events = 0; ; ++events) {
+        double t_to = t;
+        for (const auto* sw : switches) t_to = std::min(t_to, sw->nextToggleTime(t_from));
+
+        Vector x = solveTo(t_from, t_to);
+        if (events < MAX_LOCATED_EVENTS && anyVoltageToggle(x)) {
+            // Bisection on "some switch wants to toggle": lo never crossed, hi has
+            double lo = t_from, hi = t_to;
+            while (hi - lo > EVENT_TOLERANCE) {
+                double mid = 0.5 * (lo + hi);
+                Vector x_mid = solveTo(t_from, mid);
+                if (anyVoltageToggle(x_mid)) { hi = mid; x = std::move(x_mid); }
+                else lo = mid;
+            }
+            t_to = hi;
+            if (hi != t) ErrorManager::info("[TRAN] switch event located at t=" + std::to_string(hi));
+        }
+
+        time_points.push_back(t_to);
+        extractResults(x, circuit, node_map, vs_map, l_map);
+        mna_matrix.recordSourceCurrents(circuit, x);
+        for (auto* line : lines) line->acceptStep(t_to, circuit.previous_node_voltages);
+        x_current = x;
+
+        for (auto* sw : switches) {
+            if (sw->wantsToggle(circuit.previous_node_voltages) || sw->nextToggleTime(t_from) <= t_to) sw->toggle();
+        }
+        if (t - t_to <= EVENT_TOLERANCE) break;
+        t_from = t_to;
+    }
+}
+
 void TransientAnalysis::initializeResults(const Circuit& circuit, const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map) {
     plot_vars.push_back("Time");
     std::vector<std::string> voltage_vars, current_vars;
@@ -360,6 +708,93 @@ void TransientAnalysis::displayResults() const {}
 const std::map<std::string, std::vector<double>>& TransientAnalysis::getResults() const { return results; }
 const std::vector<double>& TransientAnalysis::getTimePoints() const { return time_points; }
 
+void TransientAnalysis::setCheckpointing(const std::string& path, double interval_s) {
+    if (interval_s < 0) throw std::runtime_error("Checkpoint interval must not be negative.");
+    checkpoint_path = path;
+    checkpoint_interval = interval_s;
+}
+
+void TransientAnalysis::resumeFrom(const TransientCheckpoint& checkpoint) {
+    if (std::abs(checkpoint.t_step - Tstep) > 1e-12 * std::max(1.0, std::abs(Tstep))) {
+        throw std::runtime_error("Checkpoint was written with Tstep=" + std::to_string(checkpoint.t_step) +
+                                 ", cannot resume with Tstep=" + std::to_string(Tstep) + ".");
+    }
+    resume_state = std::make_unique<TransientCheckpoint>(checkpoint);
+}
+
+void TransientAnalysis::resumeFrom(const std::string& checkpoint_file) {
+    resumeFrom(TransientCheckpoint::load(checkpoint_file));
+    ErrorManager::info("[TRAN] resuming from " + checkpoint_file + " at t=" + std::to_string(resume_state->t));
+}
+
+TransientCheckpoint TransientAnalysis::makeCheckpoint(const Circuit& circuit, const MNAMatrix& mna_matrix, double t, const Vector& x) const {
+    TransientCheckpoint checkpoint;
+    checkpoint.t_step = Tstep;
+    checkpoint.t_stop = Tstop;
+    checkpoint.circuit_hash = ResultCache::contentHash(circuit);
+    checkpoint.t = t;
+    checkpoint.x = x;
+    checkpoint.node_voltages = circuit.previous_node_voltages;
+    checkpoint.inductor_currents = circuit.previous_inductor_currents;
+    checkpoint.source_currents = circuit.previous_source_currents;
+    std::vector<double> state;
+    for (const auto& elem : circuit.getElements()) {
+        state.clear();
+        elem->saveTransientState(state);
+        if (!state.empty()) checkpoint.element_states[elem->getName()] = state;
+    }
+    checkpoint.device_state = mna_matrix.getDeviceState();
+    checkpoint.source_state = mna_matrix.getSourceState();
+    checkpoint.time_points = time_points;
+    checkpoint.results = results;
+    return checkpoint;
+}
+
+void TransientAnalysis::restoreCheckpoint(Circuit& circuit, MNAMatrix& mna_matrix, const TransientCheckpoint& checkpoint, Vector& x) {
+    if (checkpoint.circuit_hash != ResultCache::contentHash(circuit)) {
+        ErrorManager::warn("[TRAN] circuit differs from the checkpointed one; continuing as a what-if run from t=" +
+                           std::to_string(checkpoint.t));
+    }
+    circuit.updatePreviousNodeVoltages(checkpoint.node_voltages);
+    circuit.updatePreviousInductorCurrents(checkpoint.inductor_currents);
+    circuit.updatePreviousSourceCurrents(checkpoint.source_currents);
+    mna_matrix.restoreDeviceState(checkpoint.device_state);
+    mna_matrix.restoreSourceState(checkpoint.source_state);
+    x = checkpoint.x;
+
+    // Keep the checkpointed curves; variables that did not exist before are NaN up to the resume point
+    time_points = checkpoint.time_points;
+    const double missing = std::numeric_limits<double>::quiet_NaN();
+    for (auto& pair : results) {
+        auto it = checkpoint.results.find(pair.first);
+        if (it != checkpoint.results.end() && it->second.size() == time_points.size()) pair.second = it->second;
+        else pair.second.assign(time_points.size(), missing);
+    }
+    if (!time_points.empty()) ErrorManager::info("[TRAN] restored " + std::to_string(time_points.size()) + " time points from checkpoint");
+}
+
+std::string TransientAnalysis::getSettingsKey() const {
+    if (resume_state) return ""; // Depends on the checkpoint, not only on the circuit
+    std::stringstream ss;
+    ss << std::setprecision(17) << "TRAN " << Tstep << " " << Tstop << " " << (use_uic ? 1 : 0);
+    if (method == TransientMethod::EXPONENTIAL) ss << " EXP";
+    return ss.str();
+}
+
+void TransientAnalysis::exportResults(CachedResult& out) const {
+    out.analysis = getSettingsKey();
+    out.axis = time_points;
+    out.real = results;
+    out.complex.clear();
+    out.complete = complete;
+}
+
+void TransientAnalysis::importResults(const CachedResult& in) {
+    time_points = in.axis;
+    results = in.real;
+    complete = in.complete;
+}
+
 // --- DCSweepAnalysis Implementation ---
 DCSweepAnalysis::DCSweepAnalysis(const std::string& src, double start, double end, double inc)
     : source_name(src), start_value(start), end_value(end), increment(inc) {
@@ -368,35 +803,58 @@ DCSweepAnalysis::DCSweepAnalysis(const std::string& src, double start, double en
     }
 }
 
+std::string DCSweepAnalysis::getSettingsKey() const {
+    std::stringstream ss;
+    ss << std::setprecision(17) << "DC " << source_name << " " << start_value << " " << end_value << " " << increment;
+    return ss.str();
+}
+
+void DCSweepAnalysis::exportResults(CachedResult& out) const {
+    out.analysis = getSettingsKey();
+    out.axis = sweep_values;
+    out.real = results;
+    out.complex.clear();
+    out.complete = complete;
+}
+
+void DCSweepAnalysis::importResults(const CachedResult& in) {
+    sweep_values = in.axis;
+    results = in.real;
+    complete = in.complete;
+}
+
+void DCSweepAnalysis::collectBranches(const Circuit& circuit, std::map<std::string, int>& vs_map, std::map<std::string, int>& l_map) const {
+    vs_map.clear();
+    l_map.clear();
+    int vs_counter = 0, l_counter = 0;
+    for (const auto& elem : circuit.getElements()) {
+        const std::string& type = elem->getType();
+        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource" || type == "BehavioralVoltageSource" || type == "CurrentControlledVoltageSource") {
+            vs_map[elem->getName()] = vs_counter++;
+        } else if (type == "Inductor") {
+            l_map[elem->getName()] = l_counter++;
+        }
+    }
+}
+
 void DCSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) {
+    stopLiveTuning();
     results.clear();
     sweep_values.clear();
+    complete = false;
+    mna_matrix.invalidateCaches();
     
     NodeIndexMap node_map;
     std::vector<Node*> non_ground_nodes;
     circuit.getNonGroundNodes(non_ground_nodes, node_map);
     
     std::map<std::string, int> vs_map, l_map;
-    int vs_counter = 0, l_counter = 0;
-    for (const auto& elem : circuit.getElements()) {
-        const std::string& type = elem->getType();
-        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource" || type == "CurrentControlledVoltageSource") {
-            vs_map[elem->getName()] = vs_counter++;
-        } else if (type == "Inductor") {
-            l_map[elem->getName()] = l_counter++;
-        }
-    }
+    collectBranches(circuit, vs_map, l_map);
     
     initializeResults(circuit, node_map, vs_map, l_map);
     
     // Find the source to sweep
-    Element* sweep_source = nullptr;
-    for (const auto& elem : circuit.getElements()) {
-        if (elem->getName() == source_name) {
-            sweep_source = elem.get();
-            break;
-        }
-    }
+    Element* sweep_source = circuit.getElement(source_name);
     
     if (!sweep_source) {
         ErrorManager::displayError("Source " + source_name + " not found for DC sweep.");
@@ -422,12 +880,104 @@ void DCSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const Lin
             
             sweep_values.push_back(value);
             extractResults(solution, circuit, node_map, vs_map, l_map);
+            mna_matrix.recordSourceCurrents(circuit, solution);
             
         } catch (const std::runtime_error& e) {
             ErrorManager::displayError("DC sweep failed at value " + std::to_string(value) + ": " + e.what());
-            break;
+            return;
         }
     }
+    complete = true;
+}
+
+void DCSweepAnalysis::startLiveTuning(Circuit& circuit, MNAMatrix& mna_matrix) {
+    stopLiveTuning();
+    const Element* sweep_source = circuit.getElement(source_name);
+    if (!sweep_source) throw std::runtime_error("Source " + source_name + " not found for DC sweep.");
+    if (sweep_source->getType() != "IndependentVoltageSource" && sweep_source->getType() != "IndependentCurrentSource") {
+        throw std::runtime_error("Live tuning sweeps an independent source; " + source_name + " is " + sweep_source->getType());
+    }
+    for (const auto& elem : circuit.getElements()) {
+        if (!isLinearElementType(elem->getType())) {
+            throw std::runtime_error("Live tuning needs a linear circuit (" + elem->getName() + " is " + elem->getType() + ")");
+        }
+    }
+
+    mna_matrix.invalidateCaches();
+    std::vector<Node*> non_ground_nodes;
+    circuit.getNonGroundNodes(non_ground_nodes, live.node_map);
+    collectBranches(circuit, live_vs_map, live_l_map);
+    buildLiveRHS(circuit, mna_matrix); // Leaves the matrix built; the swept source only moves the RHS
+    live_solver = std::make_unique<LowRankUpdater>(mna_matrix.getA());
+    live_start = live_solver->baseSolve(live_start);
+    live_slope = live_solver->baseSolve(live_slope);
+
+    for (const auto& elem : circuit.getElements()) live.base_values[elem->getName()] = elem->getValue();
+    live.element_count = circuit.getElements().size();
+    live.active = true;
+    refreshLiveResults(circuit);
+}
+
+// RHS at the start value into live_start and its change per unit of source into live_slope
+void DCSweepAnalysis::buildLiveRHS(Circuit& circuit, MNAMatrix& mna_matrix) {
+    Element* sweep_source = circuit.getElement(source_name);
+    const double original = sweep_source->getValue();
+    sweep_source->setValue(start_value + 1.0);
+    mna_matrix.build(circuit, false, 0.0, 0.0);
+    live_slope = mna_matrix.getRHS();
+    sweep_source->setValue(start_value);
+    mna_matrix.build(circuit, false, 0.0, 0.0);
+    live_start = mna_matrix.getRHS();
+    sweep_source->setValue(original);
+    for (size_t i = 0; i < live_slope.size(); ++i) live_slope[i] -= live_start[i];
+}
+
+bool DCSweepAnalysis::retune(Circuit& circuit, MNAMatrix& mna_matrix, const Element& edited) {
+    if (!live.active || circuit.getElements().size() != live.element_count) return false;
+    const std::string& name = edited.getName();
+    auto base = live.base_values.find(name);
+    if (base == live.base_values.end()) return false;
+
+    const std::string& type = edited.getType();
+    if (type == "Resistor") {
+        if (edited.getValue() == 0.0) return false;
+        auto port = live.ports.find(name);
+        if (port == live.ports.end()) {
+            port = live.ports.emplace(name, live_solver->addPort(edited.node1Row(live.node_map), edited.node2Row(live.node_map))).first;
+        }
+        live_solver->setDelta(port->second, 1.0 / edited.getValue() - 1.0 / base->second);
+    } else if (type == "Capacitor" || type == "Inductor") {
+        // Open and short at DC whatever the value
+    } else if (type == "IndependentVoltageSource" || type == "IndependentCurrentSource") {
+        // Other sources only move the RHS: two builds and base solves, no factorisation
+        if (name != source_name) {
+            buildLiveRHS(circuit, mna_matrix);
+            live_start = live_solver->baseSolve(live_start);
+            live_slope = live_solver->baseSolve(live_slope);
+        }
+    } else {
+        return false;
+    }
+    refreshLiveResults(circuit);
+    return true;
+}
+
+void DCSweepAnalysis::refreshLiveResults(const Circuit& circuit) {
+    results.clear();
+    sweep_values.clear();
+    initializeResults(circuit, live.node_map, live_vs_map, live_l_map);
+
+    // The sweep is affine in the source value, so two updated solutions give every point
+    const Vector x_start = live_solver->apply(live_start);
+    const Vector x_slope = live_solver->apply(live_slope);
+    Vector x(x_start.size());
+    for (double value = start_value;
+         (start_value < end_value && value <= end_value) || (start_value > end_value && value >= end_value);
+         value += increment) {
+        for (size_t i = 0; i < x.size(); ++i) x[i] = x_start[i] + (value - start_value) * x_slope[i];
+        sweep_values.push_back(value);
+        extractResults(x, circuit, live.node_map, live_vs_map, live_l_map);
+    }
 }
 
 void DCSweepAnalysis::displayResults() const {
@@ -480,8 +1030,9 @@ void DCSweepAnalysis::extractResults(const Vector& x, const Circuit& circuit, co
 
     for (const auto& elem : circuit.getElements()) {
         if (elem->getType() == "Resistor") {
-            double v1 = x[node_map.at(elem->getNode1Id())];
-            double v2 = x[node_map.at(elem->getNode2Id())];
+            const int n1 = elem->node1Row(node_map), n2 = elem->node2Row(node_map);
+            double v1 = (n1 != -1) ? x[n1] : 0.0;
+            double v2 = (n2 != -1) ? x[n2] : 0.0;
             results.at("I(" + elem->getName() + ")").push_back((v1 - v2) / elem->getValue());
         }
     }
@@ -511,26 +1062,33 @@ void DCSweepAnalysis::initializeResults(const Circuit& circuit, const NodeIndexM
 ACSweepAnalysis::ACSweepAnalysis(const std::string& src, double start_freq, double end_freq, int points, const std::string& type)
     : source_name(src), start_freq_hz(start_freq), end_freq_hz(end_freq), num_points(points), sweep_type(type) {}
 
-void ACSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) {
-    results.clear();
-    frequency_points.clear();
-    ComplexMNAMatrix complex_mna;
-    ComplexLinearSolver complex_solver;
-
+std::vector<double> ACSweepAnalysis::frequencies() const {
+    std::vector<double> points;
     double step;
     if (sweep_type == "DEC") {
         step = pow(end_freq_hz / start_freq_hz, 1.0 / (num_points - 1));
     } else { // LIN
         step = (end_freq_hz - start_freq_hz) / (num_points - 1);
     }
-
     for (int i = 0; i < num_points; ++i) {
-        double freq;
         if (sweep_type == "DEC") {
-            freq = start_freq_hz * pow(step, i);
+            points.push_back(start_freq_hz * pow(step, i));
         } else { // LIN
-            freq = start_freq_hz + i * step;
+            points.push_back(start_freq_hz + i * step);
         }
+    }
+    return points;
+}
+
+void ACSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) {
+    stopLiveTuning();
+    results.clear();
+    frequency_points.clear();
+    complete = false;
+    ComplexMNAMatrix complex_mna;
+    ComplexLinearSolver complex_solver;
+
+    for (double freq : frequencies()) {
         double omega = 2 * M_PI * freq;
         frequency_points.push_back(freq);
 
@@ -555,16 +1113,501 @@ void ACSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const Lin
             return;
         }
     }
+    complete = true;
+}
+void ACSweepAnalysis::startLiveTuning(Circuit& circuit) {
+    stopLiveTuning();
+    frequency_points = frequencies();
+    ComplexMNAMatrix complex_mna;
+    std::map<std::string, int> ac_source_map;
+    for (double freq : frequency_points) {
+        complex_mna.build(circuit, 2 * M_PI * freq, live.node_map, ac_source_map);
+        if (ac_source_map.count(source_name)) {
+            complex_mna.getRHS()[live.node_map.size() + ac_source_map.at(source_name)] = 1.0;
+        }
+        live_solvers.emplace_back(complex_mna.getA());
+        live_base.push_back(live_solvers.back().baseSolve(complex_mna.getRHS()));
+    }
+
+    for (const auto& elem : circuit.getElements()) live.base_values[elem->getName()] = elem->getValue();
+    live.element_count = circuit.getElements().size();
+    live.active = true;
+    refreshLiveResults();
+}
+
+bool ACSweepAnalysis::retune(const Circuit& circuit, const Element& edited) {
+    if (!live.active || circuit.getElements().size() != live.element_count) return false;
+    const std::string& name = edited.getName();
+    auto base = live.base_values.find(name);
+    if (base == live.base_values.end()) return false;
+
+    const std::string& type = edited.getType();
+    if (type == "IndependentVoltageSource" || type == "IndependentCurrentSource") return true; // No AC stimulus
+    if (type != "Resistor" && type != "Capacitor" && type != "Inductor") return false;
+    if (type == "Inductor") {
+        // Coupled inductors are branch unknowns with mutual terms, not a two-terminal admittance
+        for (const auto& elem : circuit.getElements()) {
+            if (elem->getType() != "MutualInductance") continue;
+            const auto& names = static_cast<const MutualInductance*>(elem.get())->getInductorNames();
+            if (std::find(names.begin(), names.end(), name) != names.end()) return false;
+        }
+    }
+    const double value = edited.getValue(), base_value = base->second;
+    if (value == 0.0 && type != "Capacitor") return false;
+
+    auto port = live.ports.find(name);
+    if (port == live.ports.end()) {
+        const int a = edited.node1Row(live.node_map), b = edited.node2Row(live.node_map);
+        size_t index = 0;
+        for (auto& solver : live_solvers) index = solver.addPort(a, b);
+        port = live.ports.emplace(name, index).first;
+    }
+    // Same admittances as ComplexMNAMatrix::build
+    const Complex j(0.0, 1.0);
+    for (size_t i = 0; i < live_solvers.size(); ++i) {
+        const double omega = 2 * M_PI * frequency_points[i];
+        Complex delta = 0.0;
+        if (type == "Resistor") delta = 1.0 / value - 1.0 / base_value;
+        else if (type == "Capacitor") delta = j * omega * (value - base_value);
+        else if (omega > 1e-9) delta = 1.0 / (j * omega * value) - 1.0 / (j * omega * base_value);
+        live_solvers[i].setDelta(port->second, delta);
+    }
+    refreshLiveResults();
+    return true;
 }
+
+void ACSweepAnalysis::refreshLiveResults() {
+    results.clear();
+    for (size_t i = 0; i < live_solvers.size(); ++i) {
+        const ComplexVector solution = live_solvers[i].apply(live_base[i]);
+        for (const auto& pair : live.node_map) {
+            results["V(" + pair.first + ")"].push_back(solution[pair.second]);
+        }
+    }
+}
+
 void ACSweepAnalysis::displayResults() const {}
 const std::map<std::string, std::vector<Complex>>& ACSweepAnalysis::getComplexResults() const { return results; }
 const std::vector<double>& ACSweepAnalysis::getFrequencyPoints() const { return frequency_points; }
 
+std::string ACSweepAnalysis::getSettingsKey() const {
+    std::stringstream ss;
+    ss << std::setprecision(17) << "AC " << source_name << " " << start_freq_hz << " " << end_freq_hz << " " << num_points << " " << sweep_type;
+    return ss.str();
+}
+
+void ACSweepAnalysis::exportResults(CachedResult& out) const {
+    out.analysis = getSettingsKey();
+    out.axis = frequency_points;
+    out.real.clear();
+    out.complex = results;
+    out.complete = complete;
+}
+
+void ACSweepAnalysis::importResults(const CachedResult& in) {
+    frequency_points = in.axis;
+    results = in.complex;
+    complete = in.complete;
+}
+
 // --- PhaseSweepAnalysis Implementation ---
 PhaseSweepAnalysis::PhaseSweepAnalysis(const std::string& src, double start_phase, double end_phase, double base_freq, int points)
     : source_name(src), start_phase_deg(start_phase), end_phase_deg(end_phase), base_freq_hz(base_freq), num_points(points) {}
 
-void PhaseSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) {}
+void PhaseSweepAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) {
+    results.clear();
+    phase_points.clear();
+    complete = false;
+    if (num_points < 1) throw std::runtime_error("Invalid number of points for Phase Sweep.");
+    const Element* source = circuit.getElement(source_name);
+    if (!source) throw std::runtime_error("Phase sweep source '" + source_name + "' not found.");
+
+    // Amplitude the swept source keeps while its phase moves
+    double magnitude = 1.0;
+    const std::string& type = source->getType();
+    if (type == "PhaseVoltageSource") magnitude = static_cast<const PhaseVoltageSource*>(source)->getMagnitude();
+    else if (type == "ACVoltageSource") magnitude = std::abs(static_cast<const ACVoltageSource*>(source)->getComplexVoltage());
+
+    ComplexMNAMatrix complex_mna;
+    NodeIndexMap node_map;
+    std::map<std::string, int> ac_source_map;
+    complex_mna.build(circuit, 2 * M_PI * base_freq_hz, node_map, ac_source_map);
+    if (!ac_source_map.count(source_name)) {
+        throw std::runtime_error("Phase sweep source '" + source_name + "' is not a voltage source in the AC system.");
+    }
+    const int source_idx = node_map.size() + ac_source_map.at(source_name);
+
+    ComplexVector rest_rhs = complex_mna.getRHS();
+    rest_rhs[source_idx] = 0.0;
+    ComplexVector unit_rhs(rest_rhs.size(), 0.0);
+    unit_rhs[source_idx] = 1.0;
+
+    ComplexVector rest, unit;
+    try {
+        ComplexLUFactors factors = ComplexLUFactors::factor(complex_mna.getA());
+        rest = factors.solve(rest_rhs);
+        unit = factors.solve(unit_rhs);
+    } catch (const std::runtime_error& e) {
+        ErrorManager::displayError("Phase analysis failed at " + std::to_string(base_freq_hz) + " Hz: " + e.what());
+        return;
+    }
+
+    const double step = (num_points > 1) ? (end_phase_deg - start_phase_deg) / (num_points - 1) : 0.0;
+    for (const auto& pair : node_map) results["V(" + pair.first + ")"].reserve(num_points);
+    for (int i = 0; i < num_points; ++i) {
+        const double phase_deg = start_phase_deg + i * step;
+        phase_points.push_back(phase_deg);
+        const Complex drive = std::polar(magnitude, phase_deg * M_PI / 180.0);
+        for (const auto& pair : node_map) {
+            results["V(" + pair.first + ")"].push_back(rest[pair.second] + drive * unit[pair.second]);
+        }
+    }
+    complete = true;
+}
 void PhaseSweepAnalysis::displayResults() const {}
 const std::map<std::string, std::vector<Complex>>& PhaseSweepAnalysis::getComplexResults() const { return results; }
 const std::vector<double>& PhaseSweepAnalysis::getPhasePoints() const { return phase_points; }
+
+std::string PhaseSweepAnalysis::getSettingsKey() const {
+    std::stringstream ss;
+    ss << std::setprecision(17) << "PHASE " << source_name << " " << start_phase_deg << " " << end_phase_deg << " " << base_freq_hz << " " << num_points;
+    return ss.str();
+}
+
+void PhaseSweepAnalysis::exportResults(CachedResult& out) const {
+    out.analysis = getSettingsKey();
+    out.axis = phase_points;
+    out.real.clear();
+    out.complex = results;
+    out.complete = complete;
+}
+
+void PhaseSweepAnalysis::importResults(const CachedResult& in) {
+    phase_points = in.axis;
+    results = in.complex;
+    complete = in.complete;
+}
+
+// --- PSSAnalysis Implementation ---
+namespace {
+double norm2(const Vector& v) {
+    double sum = 0.0;
+    for (double value : v) sum += value * value;
+    return std::sqrt(sum);
+}
+
+double normInf(const Vector& v) {
+    double m = 0.0;
+    for (double value : v) m = std::max(m, std::abs(value));
+    return m;
+}
+
+// Restarted GMRES(m) for A x = b with A available only as a product; stops once
+// ||b - A x|| <= rel_tol * ||b|| or after max_iterations products.
+Vector gmresSolve(const std::function<Vector(const Vector&)>& apply, const Vector& b, double rel_tol,
+                  int restart, int max_iterations, int& iterations) {
+    const size_t n = b.size();
+    Vector x(n, 0.0);
+    const double b_norm = norm2(b);
+    iterations = 0;
+    if (b_norm == 0.0) return x;
+    const double target = rel_tol * b_norm;
+
+    while (iterations < max_iterations) {
+        Vector r = b;
+        if (iterations > 0) {
+            Vector ax = apply(x);
+            ++iterations;
+            for (size_t i = 0; i < n; ++i) r[i] -= ax[i];
+        }
+        double beta = norm2(r);
+        if (beta <= target) break;
+
+        const int m = std::max(1, std::min(restart, max_iterations - iterations));
+        std::vector<Vector> basis(1, r);
+        for (double& value : basis[0]) value /= beta;
+        std::vector<Vector> h(m + 1, Vector(m, 0.0)); // Hessenberg, h[row][col]
+        Vector cs(m, 0.0), sn(m, 0.0), g(m + 1, 0.0);
+        g[0] = beta;
+
+        int k = 0;
+        for (; k < m; ++k) {
+            Vector w = apply(basis[k]);
+            ++iterations;
+            // Modified Gram-Schmidt
+            for (int j = 0; j <= k; ++j) {
+                double dot = 0.0;
+                for (size_t i = 0; i < n; ++i) dot += w[i] * basis[j][i];
+                h[j][k] = dot;
+                for (size_t i = 0; i < n; ++i) w[i] -= dot * basis[j][i];
+            }
+            h[k + 1][k] = norm2(w);
+            for (int j = 0; j < k; ++j) {
+                const double temp = cs[j] * h[j][k] + sn[j] * h[j + 1][k];
+                h[j + 1][k] = -sn[j] * h[j][k] + cs[j] * h[j + 1][k];
+                h[j][k] = temp;
+            }
+            const double denom = std::hypot(h[k][k], h[k + 1][k]);
+            cs[k] = (denom == 0.0) ? 1.0 : h[k][k] / denom;
+            sn[k] = (denom == 0.0) ? 0.0 : h[k + 1][k] / denom;
+            const double next_norm = h[k + 1][k];
+            h[k][k] = denom;
+            h[k + 1][k] = 0.0;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+
+            if (std::abs(g[k + 1]) <= target || next_norm == 0.0 || iterations >= max_iterations) { ++k; break; }
+            basis.push_back(w);
+            for (double& value : basis.back()) value /= next_norm;
+        }
+
+        // Back-substitute the k x k triangular system and update x
+        Vector y(k, 0.0);
+        for (int i = k - 1; i >= 0; --i) {
+            double sum = g[i];
+            for (int j = i + 1; j < k; ++j) sum -= h[i][j] * y[j];
+            y[i] = (h[i][i] != 0.0) ? sum / h[i][i] : 0.0;
+        }
+        for (int j = 0; j < k; ++j) {
+            for (size_t i = 0; i < n; ++i) x[i] += y[j] * basis[j][i];
+        }
+        if (std::abs(g[k]) <= target) break;
+    }
+    return x;
+}
+}
+
+PSSAnalysis::PSSAnalysis(double period, int steps_per_period, int warmup_periods)
+    : period(period), steps_per_period(steps_per_period), warmup_periods(warmup_periods) {
+    if (period <= 0 || steps_per_period < 2 || warmup_periods < 0) {
+        throw std::runtime_error("Invalid parameters for PSS Analysis.");
+    }
+}
+
+void PSSAnalysis::analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) {
+    auto analysis_start = std::chrono::high_resolution_clock::now();
+    results.clear();
+    time_points.clear();
+    converged = false;
+    newton_iterations = gmres_iterations = periods_integrated = 0;
+    lu_cache.clear();
+    periodic_state.clear();
+
+    for (const auto& elem : circuit.getElements()) {
+        const std::string& type = elem->getType();
+        if (type == "Switch" || type == "TransmissionLine") {
+            throw std::runtime_error("PSS analysis does not support " + type + " " + elem->getName() + ".");
+        }
+    }
+
+    // A short transient settles the start-up transient and supplies the initial guess
+    const double h = period / steps_per_period;
+    if (warmup_periods > 0) {
+        TransientAnalysis warmup(h, warmup_periods * period);
+        warmup.analyze(circuit, mna_matrix, solver);
+    } else {
+        circuit.updatePreviousNodeVoltages({});
+        circuit.updatePreviousInductorCurrents({});
+        circuit.updatePreviousSourceCurrents({});
+    }
+    // The warm-up's junction limiting state, taken before invalidateCaches() empties the banks
+    const std::vector<double> warm_device_state = (warmup_periods > 0) ? mna_matrix.getDeviceState() : std::vector<double>();
+    mna_matrix.invalidateCaches();
+
+    std::vector<Node*> non_ground_nodes;
+    node_map.clear();
+    circuit.getNonGroundNodes(non_ground_nodes, node_map);
+    vs_map.clear();
+    l_map.clear();
+    int vs_counter = 0, l_counter = 0;
+    for (const auto& elem : circuit.getElements()) {
+        const std::string& type = elem->getType();
+        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource" || type == "BehavioralVoltageSource" || type == "CurrentControlledVoltageSource") {
+            vs_map[elem->getName()] = vs_counter++;
+        } else if (type == "Inductor") {
+            l_map[elem->getName()] = l_counter++;
+        }
+    }
+
+    // Junction limiting state and source branch currents are frozen so that Phi is a
+    // function of the state alone. One build binds the device banks to this circuit.
+    element_states.clear();
+    std::vector<double> element_state;
+    for (const auto& elem : circuit.getElements()) {
+        element_state.clear();
+        elem->saveTransientState(element_state);
+        if (!element_state.empty()) element_states[elem->getName()] = element_state;
+    }
+    source_currents = circuit.previous_source_currents;
+    mna_matrix.restoreDeviceState(warm_device_state);
+    mna_matrix.build(circuit, true, 0.0, h);
+    device_state = mna_matrix.getDeviceState();
+
+    const size_t num_nodes = node_map.size();
+    Vector state(num_nodes + l_map.size(), 0.0);
+    for (const auto& pair : node_map) {
+        auto it = circuit.previous_node_voltages.find(pair.first);
+        if (it != circuit.previous_node_voltages.end()) state[pair.second] = it->second;
+    }
+    for (const auto& pair : l_map) {
+        auto it = circuit.previous_inductor_currents.find(pair.first);
+        if (it != circuit.previous_inductor_currents.end()) state[num_nodes + pair.second] = it->second;
+    }
+
+    const int KRYLOV_RESTART = 30;
+    const int MAX_KRYLOV_ITERATIONS = 60;
+    const double FORCING_TERM = 1e-3; // Inexact Newton: GMRES only needs a few digits
+    const int MAX_BACKTRACKS = 5;
+
+    try {
+        Vector phi = integratePeriod(circuit, mna_matrix, solver, state);
+        Vector residual(state.size());
+        for (size_t i = 0; i < state.size(); ++i) residual[i] = phi[i] - state[i];
+
+        for (newton_iterations = 0; newton_iterations <= max_newton_iterations; ++newton_iterations) {
+            const double residual_norm = normInf(residual);
+            std::stringstream progress;
+            progress << "[PSS] Newton " << newton_iterations << ": |Phi(s) - s| = " << std::scientific << residual_norm;
+            ErrorManager::info(progress.str());
+            if (residual_norm <= abs_tol + rel_tol * normInf(state)) { converged = true; break; }
+            if (newton_iterations == max_newton_iterations) break;
+
+            // Directional derivative of Phi by a forward difference around the current period
+            auto apply = [&](const Vector& v) {
+                const double v_norm = norm2(v);
+                if (v_norm == 0.0) return Vector(v.size(), 0.0);
+                const double eps = std::sqrt(std::numeric_limits<double>::epsilon()) * (1.0 + norm2(state)) / v_norm;
+                Vector perturbed(state.size());
+                for (size_t i = 0; i < state.size(); ++i) perturbed[i] = state[i] + eps * v[i];
+                Vector phi_perturbed = integratePeriod(circuit, mna_matrix, solver, perturbed);
+                Vector out(v.size());
+                for (size_t i = 0; i < v.size(); ++i) out[i] = (phi_perturbed[i] - phi[i]) / eps - v[i];
+                return out;
+            };
+            Vector rhs(residual.size());
+            for (size_t i = 0; i < residual.size(); ++i) rhs[i] = -residual[i];
+            int krylov_iterations = 0;
+            Vector delta = gmresSolve(apply, rhs, FORCING_TERM, KRYLOV_RESTART, MAX_KRYLOV_ITERATIONS, krylov_iterations);
+            gmres_iterations += krylov_iterations;
+
+            // Halve the step while it does not reduce the periodicity error
+            double lambda = 1.0;
+            Vector trial(state.size()), phi_trial, residual_trial(state.size());
+            for (int backtrack = 0; ; ++backtrack) {
+                for (size_t i = 0; i < state.size(); ++i) trial[i] = state[i] + lambda * delta[i];
+                phi_trial = integratePeriod(circuit, mna_matrix, solver, trial);
+                for (size_t i = 0; i < state.size(); ++i) residual_trial[i] = phi_trial[i] - trial[i];
+                if (normInf(residual_trial) < residual_norm || backtrack == MAX_BACKTRACKS) break;
+                lambda *= 0.5;
+            }
+            state = trial;
+            phi = phi_trial;
+            residual = residual_trial;
+        }
+
+        periodic_state = state;
+        std::vector<Vector> trajectory;
+        integratePeriod(circuit, mna_matrix, solver, state, &trajectory);
+        recordPeriod(circuit, trajectory);
+    } catch (const std::runtime_error& e) {
+        ErrorManager::displayError("PSS analysis failed: " + std::string(e.what()));
+    }
+    if (!converged) {
+        ErrorManager::warn("[PSS] shooting did not converge in " + std::to_string(max_newton_iterations) +
+                           " Newton iterations; showing the last iterate");
+    }
+
+    auto analysis_end = std::chrono::high_resolution_clock::now();
+    auto analysis_duration = std::chrono::duration_cast<std::chrono::milliseconds>(analysis_end - analysis_start);
+    std::stringstream summary;
+    summary << "[PSS] Analysis complete: " << newton_iterations << " Newton iterations, " << gmres_iterations
+            << " GMRES iterations, " << periods_integrated << " periods integrated (+" << warmup_periods
+            << " warm-up), " << analysis_duration.count() << "ms";
+    ErrorManager::info(summary.str());
+}
+
+void PSSAnalysis::applyState(Circuit& circuit, MNAMatrix& mna_matrix, const Vector& state) {
+    std::map<std::string, double> voltages, currents;
+    for (const auto& pair : node_map) voltages[pair.first] = state[pair.second];
+    if (circuit.checkGroundNodeExists()) voltages[circuit.getGroundNodeId()] = 0.0;
+    const size_t num_nodes = node_map.size();
+    for (const auto& pair : l_map) currents[pair.first] = state[num_nodes + pair.second];
+    circuit.updatePreviousNodeVoltages(voltages);
+    circuit.updatePreviousInductorCurrents(currents);
+    circuit.updatePreviousSourceCurrents(source_currents);
+
+    for (const auto& elem : circuit.getElements()) {
+        auto it = element_states.find(elem->getName());
+        if (it != element_states.end()) elem->restoreTransientState(it->second);
+    }
+    mna_matrix.restoreDeviceState(device_state);
+}
+
+Vector PSSAnalysis::integratePeriod(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const Vector& state,
+                                    std::vector<Vector>* trajectory) {
+    applyState(circuit, mna_matrix, state);
+    const bool cached_lu = dynamic_cast<const LUDecompositionSolver*>(&solver) != nullptr;
+    const double h = period / steps_per_period;
+    const size_t num_nodes = node_map.size();
+    std::map<std::string, double> voltages, currents;
+    Vector x;
+    for (int k = 1; k <= steps_per_period; ++k) {
+        mna_matrix.build(circuit, true, k * h, h);
+        x = cached_lu ? lu_cache.solve("PSS", mna_matrix.getA(), mna_matrix.getRHS())
+                      : solver.solve(mna_matrix.getA(), mna_matrix.getRHS());
+        for (const auto& pair : node_map) voltages[pair.first] = x[pair.second];
+        if (circuit.checkGroundNodeExists()) voltages[circuit.getGroundNodeId()] = 0.0;
+        for (const auto& pair : l_map) currents[pair.first] = x[num_nodes + vs_map.size() + pair.second];
+        circuit.updatePreviousNodeVoltages(voltages);
+        circuit.updatePreviousInductorCurrents(currents);
+        mna_matrix.recordSourceCurrents(circuit, x);
+        if (trajectory) trajectory->push_back(x);
+    }
+    ++periods_integrated;
+
+    Vector end_state(state.size());
+    for (const auto& pair : node_map) end_state[pair.second] = x[pair.second];
+    for (const auto& pair : l_map) end_state[num_nodes + pair.second] = x[num_nodes + vs_map.size() + pair.second];
+    return end_state;
+}
+
+void PSSAnalysis::recordPeriod(const Circuit& circuit, const std::vector<Vector>& trajectory) {
+    if (trajectory.empty()) return;
+    const double h = period / steps_per_period;
+    const size_t num_nodes = node_map.size();
+    // The waveform is periodic, so the end of the period doubles as t = 0
+    for (size_t k = 0; k <= trajectory.size(); ++k) {
+        const Vector& x = (k == 0) ? trajectory.back() : trajectory[k - 1];
+        time_points.push_back(k * h);
+        for (const auto& pair : circuit.getNodes()) {
+            double v = 0.0;
+            if (!pair.second->getIsGround() && node_map.count(pair.first)) v = x[node_map.at(pair.first)];
+            results["V(" + pair.first + ")"].push_back(v);
+        }
+        for (const auto& pair : vs_map) results["I(" + pair.first + ")"].push_back(x[num_nodes + pair.second]);
+        for (const auto& pair : l_map) results["I(" + pair.first + ")"].push_back(x[num_nodes + vs_map.size() + pair.second]);
+    }
+}
+
+void PSSAnalysis::displayResults() const {}
+
+std::string PSSAnalysis::getSettingsKey() const {
+    std::stringstream ss;
+    ss << std::setprecision(17) << "PSS " << period << " " << steps_per_period << " " << warmup_periods << " "
+       << abs_tol << " " << rel_tol << " " << max_newton_iterations;
+    return ss.str();
+}
+
+void PSSAnalysis::exportResults(CachedResult& out) const {
+    out.analysis = getSettingsKey();
+    out.axis = time_points;
+    out.real = results;
+    out.complex.clear();
+    out.complete = converged;
+}
+
+void PSSAnalysis::importResults(const CachedResult& in) {
+    time_points = in.axis;
+    results = in.real;
+    converged = in.complete;
+}
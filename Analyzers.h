@@ -3,8 +3,61 @@
 #include <vector>
 #include <string>
 #include <complex>
+#include <memory>
+#include <cstdint>
+#include <chrono>
 #include "Circuit.h"
 #include "Solvers.h"
+#include <cereal/types/complex.hpp>
+
+// --- CachedResult (Portable copy of an analyzer's output, for ResultCache) ---
+struct CachedResult {
+    std::string analysis;                                   // Settings key of the producing analysis
+    std::vector<double> axis;                               // Time, sweep value or frequency points
+    std::map<std::string, std::vector<double>> real;
+    std::map<std::string, std::vector<Complex>> complex;
+    bool complete = true;                                   // False: stopped early or did not converge
+
+    size_t byteSize() const;
+
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(CEREAL_NVP(analysis), CEREAL_NVP(axis), CEREAL_NVP(real), CEREAL_NVP(complex), CEREAL_NVP(complete));
+    }
+};
+
+// --- TransientCheckpoint (Resumable state of a TransientAnalysis) ---
+// Everything the time loop carries from one step to the next: the last
+// accepted loop time, the companion-model history held by the circuit, the
+// run-time state of switches, lines, limited junctions and sinusoid phasors, and the results
+// recorded so far. Written atomically (temporary file + rename). Version 2 added the
+// source branch currents that behavioural sources linearise at; version 1 files load
+// without them.
+struct TransientCheckpoint {
+    static constexpr uint32_t VERSION = 2;
+    double t_step = 0.0, t_stop = 0.0;
+    uint64_t circuit_hash = 0;          // ResultCache::contentHash of the circuit that wrote it
+    double t = 0.0;                     // Last accepted loop time
+    std::vector<double> x;              // MNA solution at t
+    std::map<std::string, double> node_voltages;     // Circuit::previous_node_voltages
+    std::map<std::string, double> inductor_currents; // Circuit::previous_inductor_currents
+    std::map<std::string, double> source_currents;   // Circuit::previous_source_currents (version 2)
+    std::map<std::string, std::vector<double>> element_states; // Element::saveTransientState, non-empty only
+    std::vector<double> device_state;   // MNAMatrix::getDeviceState
+    std::vector<double> source_state;   // MNAMatrix::getSourceState
+    std::vector<double> time_points;
+    std::map<std::string, std::vector<double>> results;
+
+    void save(const std::string& path) const;
+    static TransientCheckpoint load(const std::string& path);
+
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(CEREAL_NVP(t_step), CEREAL_NVP(t_stop), CEREAL_NVP(circuit_hash), CEREAL_NVP(t), CEREAL_NVP(x),
+                CEREAL_NVP(node_voltages), CEREAL_NVP(inductor_currents), CEREAL_NVP(element_states),
+                CEREAL_NVP(device_state), CEREAL_NVP(source_state), CEREAL_NVP(time_points), CEREAL_NVP(results));
+    }
+};
 
 // --- Analyzer Classes ---
 
@@ -13,15 +66,31 @@ public:
     virtual ~Analyzer() = default;
     virtual void analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) = 0;
     virtual void displayResults() const = 0;
+
+    // Result caching: every setting that, together with the circuit, determines
+    // the results. Empty means the analysis does not support caching.
+    virtual std::string getSettingsKey() const { return ""; }
+    virtual void exportResults(CachedResult&) const {}
+    virtual void importResults(const CachedResult&) {}
 };
 
+// Backward Euler companion models work for every element; the exponential
+// integrator steps linear circuits exactly and falls back otherwise.
+enum class TransientMethod { BACKWARD_EULER, EXPONENTIAL };
+
 class TransientAnalysis : public Analyzer {
 private:
     double Tstep, Tstop;
     bool use_uic;
+    TransientMethod method = TransientMethod::BACKWARD_EULER;
     std::map<std::string, std::vector<double>> results;
     std::vector<double> time_points;
     std::vector<std::string> plot_vars;
+    bool complete = false;              // Ran to Tstop from a converged operating point
+    size_t topology_hits = 0, topology_factorisations = 0;
+    std::string checkpoint_path;
+    double checkpoint_interval = 60.0;  // Wall-clock seconds
+    std::unique_ptr<TransientCheckpoint> resume_state;
 
 public:
     TransientAnalysis(double t_step, double t_stop, bool uic_flag = false);
@@ -29,9 +98,55 @@ public:
     void displayResults() const override;
     const std::map<std::string, std::vector<double>>& getResults() const;
     const std::vector<double>& getTimePoints() const;
+    std::string getSettingsKey() const override;
+    void exportResults(CachedResult& out) const override;
+    void importResults(const CachedResult& in) override;
+
+    // Checkpoints go to `path` every `interval_s` seconds of wall-clock time and when
+    // the run ends, including when it stops on a solver failure. Empty path disables.
+    void setCheckpointing(const std::string& path, double interval_s = 60.0);
+    // The next analyze() continues after the checkpoint instead of starting from the
+    // operating point. Tstop may differ, and the circuit may have been edited to fork a
+    // what-if continuation; Tstep must match.
+    void resumeFrom(const TransientCheckpoint& checkpoint);
+    void resumeFrom(const std::string& checkpoint_file);
+
+    // EXPONENTIAL needs R, L, C, linear controlled and independent sources only; pulse and
+    // in-memory waveform inputs are exact, sinusoids are taken piecewise linear per step.
+    void setMethod(TransientMethod m) { method = m; }
+    TransientMethod getMethod() const { return method; }
+    // Switch topology LU cache use in the last run: full steps solved from cached
+    // factors, and factorisations (one per switch configuration seen)
+    size_t getTopologyCacheHits() const { return topology_hits; }
+    size_t getTopologyFactorisations() const { return topology_factorisations; }
 private:
+    // Returns false (and leaves the results empty) when the circuit is not linear index-1
+    bool analyzeExponential(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const NodeIndexMap& node_map,
+                            const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map);
+    void logCompletion(std::chrono::high_resolution_clock::time_point analysis_start) const;
+    TransientCheckpoint makeCheckpoint(const Circuit& circuit, const MNAMatrix& mna_matrix, double t, const Vector& x) const;
+    void restoreCheckpoint(Circuit& circuit, MNAMatrix& mna_matrix, const TransientCheckpoint& checkpoint, Vector& x);
     void initializeResults(const Circuit& circuit, const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map);
     void extractResults(const Vector& x, Circuit& circuit, const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map);
+    // Advances to t, inserting extra time points at switching events.
+    void advanceSwitchedStep(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const std::vector<Switch*>& switches,
+                             const std::vector<TransmissionLine*>& lines, TopologyLUCache& lu_cache, double t,
+                             const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map,
+                             const std::map<std::string, int>& l_map, Vector& x_current);
+};
+
+// --- LiveTuningState (Factorisation kept for interactive value edits) ---
+// A value edit on a two-terminal passive is a rank-1 change of the MNA matrix, so
+// analyses that support live tuning keep their factorisation and refresh results
+// through a LowRankUpdater. Edits of other elements, or a changed element list,
+// need a full analysis.
+struct LiveTuningState {
+    bool active = false;
+    size_t element_count = 0;
+    NodeIndexMap node_map;
+    std::map<std::string, double> base_values; // Element values when factored
+    std::map<std::string, size_t> ports;       // Edited element -> updater port
+    void clear() { *this = LiveTuningState(); }
 };
 
 class DCSweepAnalysis : public Analyzer {
@@ -41,13 +156,33 @@ private:
     std::map<std::string, std::vector<double>> results;
     std::vector<double> sweep_values;
     std::vector<std::string> plot_vars;
+    bool complete = false;  // Every sweep point solved
 public:
     DCSweepAnalysis(const std::string& src, double start, double end, double inc);
     void analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) override;
     void displayResults() const override;
     const std::map<std::string, std::vector<double>>& getResults() const { return results; }
     const std::vector<double>& getSweepValues() const { return sweep_values; }
+    std::string getSettingsKey() const override;
+    void exportResults(CachedResult& out) const override;
+    void importResults(const CachedResult& in) override;
+
+    // Live tuning (linear circuits, swept independent source): one factorisation,
+    // after which retune() refreshes every sweep point from two base solutions.
+    void startLiveTuning(Circuit& circuit, MNAMatrix& mna_matrix);
+    // False when the edit cannot be applied in place; run analyze() again then.
+    bool retune(Circuit& circuit, MNAMatrix& mna_matrix, const Element& edited);
+    void stopLiveTuning() { live.clear(); live_solver.reset(); }
+    bool isLiveTuning() const { return live.active; }
 private:
+    LiveTuningState live;
+    std::unique_ptr<LowRankUpdater> live_solver;
+    Vector live_start, live_slope;            // Base solutions at the start value and per unit of source
+    std::map<std::string, int> live_vs_map, live_l_map;
+
+    void collectBranches(const Circuit& circuit, std::map<std::string, int>& vs_map, std::map<std::string, int>& l_map) const;
+    void buildLiveRHS(Circuit& circuit, MNAMatrix& mna_matrix);
+    void refreshLiveResults(const Circuit& circuit);
     void extractResults(const Vector& solution, const Circuit& circuit, const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map);
     void initializeResults(const Circuit& circuit, const NodeIndexMap& node_map, const std::map<std::string, int>& vs_map, const std::map<std::string, int>& l_map);
 };
@@ -60,6 +195,7 @@ private:
     std::string sweep_type;
     std::map<std::string, std::vector<Complex>> results;
     std::vector<double> frequency_points;
+    bool complete = false;  // Every frequency point solved
 public:
     ACSweepAnalysis(const std::string& src, double start_freq, double end_freq, int points, const std::string& type);
     // Corrected: This now overrides the base class method correctly. The solver param will be ignored.
@@ -67,6 +203,23 @@ public:
     void displayResults() const override;
     const std::map<std::string, std::vector<Complex>>& getComplexResults() const;
     const std::vector<double>& getFrequencyPoints() const;
+    std::string getSettingsKey() const override;
+    void exportResults(CachedResult& out) const override;
+    void importResults(const CachedResult& in) override;
+
+    // Live tuning: keeps one factorisation per frequency point, after which
+    // retune() refreshes the Bode data with low-rank updates.
+    void startLiveTuning(Circuit& circuit);
+    bool retune(const Circuit& circuit, const Element& edited); // False: run analyze() again
+    void stopLiveTuning() { live.clear(); live_solvers.clear(); live_base.clear(); }
+    bool isLiveTuning() const { return live.active; }
+private:
+    LiveTuningState live;
+    std::vector<ComplexLowRankUpdater> live_solvers; // One per frequency point
+    std::vector<ComplexVector> live_base;            // A0^{-1} b per frequency point
+
+    std::vector<double> frequencies() const;
+    void refreshLiveResults();
 };
 
 class PhaseSweepAnalysis : public Analyzer {
@@ -77,10 +230,75 @@ private:
     int num_points;
     std::map<std::string, std::vector<Complex>> results;
     std::vector<double> phase_points;
+    bool complete = false;  // The base-frequency system factored
 public:
     PhaseSweepAnalysis(const std::string& src, double start_phase, double end_phase, double base_freq, int points);
+    // The circuit is linear at base_freq_hz, so only the swept source's RHS entry
+    // changes with phase: one factorisation, one solve for every other source and one
+    // for the swept source at unit amplitude, then x(phi) = x_rest + V e^(j phi) x_unit.
     void analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) override;
     void displayResults() const override;
     const std::map<std::string, std::vector<Complex>>& getComplexResults() const;
     const std::vector<double>& getPhasePoints() const;
+    std::string getSettingsKey() const override;
+    void exportResults(CachedResult& out) const override;
+    void importResults(const CachedResult& in) override;
+};
+
+// --- PSSAnalysis (Periodic steady state by shooting Newton) ---
+// Finds the state s (non-ground node voltages, then inductor currents) whose
+// one-period transient returns to itself, Phi(s) = s. Each Newton step solves
+// (dPhi/ds - I) d = s - Phi(s) with restarted GMRES; the Jacobian is never
+// formed, its product with a vector is a finite difference of two periods.
+// The transient uses the circuit's own fixed-step companion models, so the
+// answer matches what `tran` would settle to after enough cycles.
+class PSSAnalysis : public Analyzer {
+private:
+    double period;
+    int steps_per_period;
+    int warmup_periods;
+    double abs_tol = 1e-9, rel_tol = 1e-6; // On |Phi(s) - s|, relative to |s|
+    int max_newton_iterations = 25;
+    std::map<std::string, std::vector<double>> results;
+    std::vector<double> time_points;
+    bool converged = false;
+    int newton_iterations = 0, gmres_iterations = 0, periods_integrated = 0;
+
+    // Bindings of the circuit being analysed
+    NodeIndexMap node_map;
+    std::map<std::string, int> vs_map, l_map;
+    std::map<std::string, std::vector<double>> element_states; // Restored before every period
+    std::vector<double> device_state;
+    std::map<std::string, double> source_currents;
+    Vector periodic_state;                                      // Last shooting iterate
+    TopologyLUCache lu_cache;
+
+public:
+    PSSAnalysis(double period, int steps_per_period, int warmup_periods = 2);
+    void analyze(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver) override;
+    void displayResults() const override;
+    void setTolerances(double abs_tolerance, double rel_tolerance) { abs_tol = abs_tolerance; rel_tol = rel_tolerance; }
+    const std::map<std::string, std::vector<double>>& getResults() const { return results; }
+    const std::vector<double>& getTimePoints() const { return time_points; }
+    bool hasConverged() const { return converged; }
+    int getNewtonIterations() const { return newton_iterations; }
+    int getPeriodsIntegrated() const { return periods_integrated; }
+    // Phi(s) for the circuit of the last analyze(): node voltages and inductor currents
+    // one period after `state`, laid out like getPeriodicState()
+    Vector periodMap(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const Vector& state) {
+        return integratePeriod(circuit, mna_matrix, solver, state);
+    }
+    const Vector& getPeriodicState() const { return periodic_state; }
+    std::string getSettingsKey() const override;
+    void exportResults(CachedResult& out) const override;
+    void importResults(const CachedResult& in) override;
+private:
+    void applyState(Circuit& circuit, MNAMatrix& mna_matrix, const Vector& state);
+    // Integrates one period from `state` and returns the state at its end; every
+    // step's MNA solution is appended to `trajectory` when given. Steps go through
+    // `solver`, except that an LUDecompositionSolver is replaced by lu_cache: another
+    // direct LU (with pivoting) whose factors are reused while the matrix is unchanged.
+    Vector integratePeriod(Circuit& circuit, MNAMatrix& mna_matrix, const LinearSolver& solver, const Vector& state,
+                           std::vector<Vector>* trajectory = nullptr);
+    void recordPeriod(const Circuit& circuit, const std::vector<Vector>& trajectory);
 };
@@ -11,6 +11,7 @@
 CEREAL_REGISTER_TYPE(Resistor)
 CEREAL_REGISTER_TYPE(Capacitor)
 CEREAL_REGISTER_TYPE(Inductor)
+CEREAL_REGISTER_TYPE(MutualInductance)
 CEREAL_REGISTER_TYPE(IndependentVoltageSource)
 CEREAL_REGISTER_TYPE(IndependentCurrentSource)
 CEREAL_REGISTER_TYPE(PulseVoltageSource)
@@ -25,6 +26,12 @@ CEREAL_REGISTER_TYPE(VoltageControlledCurrentSource) // Temporarily disabled to
 CEREAL_REGISTER_TYPE(CurrentControlledCurrentSource) // Temporarily disabled to fix linker issues
 CEREAL_REGISTER_TYPE(CurrentControlledVoltageSource) // Temporarily disabled to fix linker issues
 CEREAL_REGISTER_TYPE(Diode)                          // Temporarily disabled to fix linker issues
+CEREAL_REGISTER_TYPE(Mosfet)
+CEREAL_REGISTER_TYPE(BipolarTransistor)
+CEREAL_REGISTER_TYPE(TableDevice)
+CEREAL_REGISTER_TYPE(TransmissionLine)
+CEREAL_REGISTER_TYPE(Switch)
+CEREAL_REGISTER_TYPE(BehavioralSource)
 CEREAL_REGISTER_TYPE(Ground)                         // Temporarily disabled to fix linker issues
 // CEREAL_REGISTER_TYPE(Subcircuit) // Commented out due to circular dependency with Circuit
 CEREAL_REGISTER_TYPE(CircuitWire)
@@ -40,6 +47,7 @@ CEREAL_REGISTER_TYPE(DifferentialProbe)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Resistor)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Capacitor)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Inductor)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, MutualInductance)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, IndependentVoltageSource)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, IndependentCurrentSource)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, PulseVoltageSource)
@@ -54,6 +62,12 @@ CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, VoltageControlledCurrentSource) //
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, CurrentControlledCurrentSource) // Temporarily disabled
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, CurrentControlledVoltageSource) // Temporarily disabled
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Diode)                          // Temporarily disabled
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Mosfet)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, BipolarTransistor)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, TableDevice)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, TransmissionLine)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Switch)
+CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, BehavioralSource)
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Ground)                         // Temporarily disabled
 // CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, Subcircuit) // Commented out due to circular dependency with Circuit
 CEREAL_REGISTER_POLYMORPHIC_RELATION(Element, CircuitWire)
@@ -12,12 +12,14 @@
 Circuit::Circuit() : ground_node_id("") { LOG_INFO("[Circuit] constructed"); }
 Circuit::~Circuit() = default;
 
-Node* Circuit::getOrCreateNode(const std::string& node_id) {
-    if (nodes.find(node_id) == nodes.end()) {
-        nodes[node_id] = std::make_unique<Node>(node_id);
-        LOG_INFO(std::string("[Circuit] create node ") + node_id);
+Node* Circuit::getOrCreateNode(const std::string& node_id, bool quiet) {
+    auto it = nodes.find(node_id);
+    if (it == nodes.end()) {
+        it = nodes.emplace(node_id, std::make_unique<Node>(node_id)).first;
+        node_symbols.intern(node_id);
+        if (!quiet) LOG_INFO(std::string("[Circuit] create node ") + node_id);
     }
-    return nodes[node_id].get();
+    return it->second.get();
 }
 
 void Circuit::addElement(std::unique_ptr<Element> element) {
@@ -26,39 +28,81 @@ void Circuit::addElement(std::unique_ptr<Element> element) {
         throw std::runtime_error("Element with name '" + element->getName() + "' already exists.");
     }
     LOG_INFO(std::string("[Circuit] add element ") + element->getName() + " (" + element->getType() + ") " + element->getNode1Id() + "," + element->getNode2Id());
-    getOrCreateNode(element->getNode1Id());
+    registerNodes(*element, false);
+    element_index.emplace(element->getName(), elements.size());
+    elements.push_back(std::move(element));
+}
+
+size_t Circuit::addElements(std::vector<std::unique_ptr<Element>>& batch, size_t first) {
+    size_t i = first;
+    const size_t node_count = nodes.size();
+    elements.reserve(elements.size() + batch.size() - first);
+    element_index.reserve(elements.size() + batch.size() - first);
+    for (; i < batch.size(); ++i) {
+        if (!batch[i] || !element_index.emplace(batch[i]->getName(), elements.size()).second) break;
+        registerNodes(*batch[i], true);
+        elements.push_back(std::move(batch[i]));
+    }
+    LOG_INFO("[Circuit] add " + std::to_string(i - first) + " elements in bulk, " + std::to_string(nodes.size() - node_count) + " new nodes");
+    return i;
+}
 
-    if (element->getType() == "VoltageControlledVoltageSource" || element->getType() == "VoltageControlledCurrentSource") {
-        auto* vcvs = static_cast<VoltageControlledVoltageSource*>(element.get());
-        getOrCreateNode(vcvs->getControlNode1Id());
-        getOrCreateNode(vcvs->getControlNode2Id());
+void Circuit::registerNodes(Element& element, bool quiet) {
+    if (!element.getNode1Id().empty()) {
+        getOrCreateNode(element.getNode1Id(), quiet);
     }
 
-    if (!element->getNode2Id().empty()) {
-        getOrCreateNode(element->getNode2Id());
+    if (element.getType() == "VoltageControlledVoltageSource" || element.getType() == "VoltageControlledCurrentSource") {
+        auto& vcvs = static_cast<const VoltageControlledVoltageSource&>(element);
+        getOrCreateNode(vcvs.getControlNode1Id(), quiet);
+        getOrCreateNode(vcvs.getControlNode2Id(), quiet);
+    } else if (element.getType() == "Mosfet") {
+        getOrCreateNode(static_cast<const Mosfet&>(element).getGateId(), quiet);
+    } else if (element.getType() == "BipolarTransistor") {
+        getOrCreateNode(static_cast<const BipolarTransistor&>(element).getBaseId(), quiet);
+    } else if (element.getType() == "Switch") {
+        auto& sw = static_cast<const Switch&>(element);
+        if (sw.getControl() == Switch::Control::VOLTAGE) {
+            getOrCreateNode(sw.getControlPosId(), quiet);
+            getOrCreateNode(sw.getControlNegId(), quiet);
+        }
+    } else if (element.getType() == "TransmissionLine") {
+        auto& line = static_cast<const TransmissionLine&>(element);
+        getOrCreateNode(line.getPort2PosId(), quiet);
+        getOrCreateNode(line.getPort2NegId(), quiet);
     }
-    if (element->getType() == "Ground") {
-        setGroundNode(element->getNode1Id());
+
+    if (!element.getNode2Id().empty()) {
+        getOrCreateNode(element.getNode2Id(), quiet);
+    }
+    element.bindNodeSymbols(node_symbols.find(element.getNode1Id()), node_symbols.find(element.getNode2Id()));
+    if (element.getType() == "Ground") {
+        setGroundNode(element.getNode1Id());
     }
-    elements.push_back(std::move(element));
 }
 
 void Circuit::deleteElement(const std::string& name) {
-    auto it = std::remove_if(elements.begin(), elements.end(),
-        [&](const std::unique_ptr<Element>& elem) { return elem->getName() == name; });
-    if (it != elements.end()) {
-        LOG_INFO(std::string("[Circuit] delete element ") + name);
-        elements.erase(it, elements.end());
-    } else {
-        throw std::runtime_error("Element not found.");
+    auto found = element_index.find(name);
+    if (found == element_index.end()) throw std::runtime_error("Element not found.");
+    const size_t pos = found->second;
+    LOG_INFO(std::string("[Circuit] delete element ") + name);
+    element_index.erase(found);
+    // Swap-and-pop: the last element takes the freed slot, so only its index changes
+    if (pos + 1 != elements.size()) {
+        elements[pos] = std::move(elements.back());
+        element_index[elements[pos]->getName()] = pos;
     }
+    elements.pop_back();
 }
 
 void Circuit::clear() {
     LOG_WARN("[Circuit] clear all");
     elements.clear();
+    element_index.clear();
     nodes.clear();
+    node_symbols.clear();
     node_labels.clear();
+    model_cards.clear();
     ground_node_id = "";
 }
 
@@ -73,10 +117,8 @@ const std::vector<std::unique_ptr<Element>>& Circuit::getElements() const { retu
 const std::map<std::string, std::unique_ptr<Node>>& Circuit::getNodes() const { return nodes; }
 
 Element* Circuit::getElement(const std::string& name) const {
-    for (const auto& elem : elements) {
-        if (elem->getName() == name) return elem.get();
-    }
-    return nullptr;
+    auto it = element_index.find(name);
+    return (it != element_index.end()) ? elements[it->second].get() : nullptr;
 }
 
 bool Circuit::hasElement(const std::string& name) const {
@@ -116,9 +158,11 @@ void Circuit::renameNode(const std::string& old_name, const std::string& new_nam
 
     if (ground_node_id == old_name) ground_node_id = new_name;
 
+    node_symbols.intern(new_name);
     for (const auto& elem : elements) {
         if (elem->getNode1Id() == old_name) elem->setNode1Id(new_name);
         if (elem->getNode2Id() == old_name) elem->setNode2Id(new_name);
+        elem->bindNodeSymbols(node_symbols.find(elem->getNode1Id()), node_symbols.find(elem->getNode2Id()));
     }
     LOG_INFO(std::string("[Circuit] rename node ") + old_name + " -> " + new_name);
 }
@@ -152,12 +196,12 @@ bool Circuit::checkConnectivity() const {
 
 void Circuit::getNonGroundNodes(std::vector<Node*>& non_ground_nodes, NodeIndexMap& node_map) const {
     non_ground_nodes.clear();
-    node_map.clear();
+    node_map.bind(&node_symbols);
     int index = 0;
     for (const auto& pair : nodes) {
         if (!pair.second->getIsGround()) {
             non_ground_nodes.push_back(pair.second.get());
-            node_map[pair.first] = index++;
+            node_map.set(pair.first, index++);
         }
     }
 }
@@ -182,6 +226,14 @@ const std::map<std::string, double>& Circuit::getPreviousInductorCurrents() cons
     return previous_inductor_currents;
 }
 
+void Circuit::updatePreviousSourceCurrents(const std::map<std::string, double>& current_source_currents) {
+    previous_source_currents = current_source_currents;
+}
+
+const std::map<std::string, double>& Circuit::getPreviousSourceCurrents() const {
+    return previous_source_currents;
+}
+
 void Circuit::saveToFile(const std::string& filename) const {
     std::ofstream outfile(filename);
     if (!outfile.is_open()) throw std::runtime_error("Could not save circuit to file '" + filename + "'.");
@@ -198,3 +250,23 @@ void Circuit::addNodeLabel(const std::string& node_id, const std::string& label)
 const std::map<std::string, std::string>& Circuit::getNodeLabels() const {
     return node_labels;
 }
+
+// --- Device model cards ---
+void Circuit::addModelCard(const DeviceModelCard& model) {
+    model_cards[model.name] = model;
+    LOG_INFO(std::string("[Circuit] model ") + model.name + " (" + model.type + ")");
+}
+
+bool Circuit::hasModelCard(const std::string& name) const {
+    return model_cards.count(name) > 0;
+}
+
+const DeviceModelCard& Circuit::getModelCard(const std::string& name) const {
+    auto it = model_cards.find(name);
+    if (it == model_cards.end()) throw std::runtime_error("Model '" + name + "' is not defined.");
+    return it->second;
+}
+
+const std::map<std::string, DeviceModelCard>& Circuit::getModelCards() const {
+    return model_cards;
+}
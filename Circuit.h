@@ -3,6 +3,7 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <cereal/types/map.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/vector.hpp>
@@ -15,9 +16,13 @@ class Circuit {
 private:
     std::map<std::string, std::unique_ptr<Node>> nodes;
     std::vector<std::unique_ptr<Element>> elements;
+    std::unordered_map<std::string, size_t> element_index; // Name -> position in elements
     std::string ground_node_id;
     std::map<std::string, std::string> node_labels; // <-- NEW: To store node labels
-    Node* getOrCreateNode(const std::string& node_id);
+    std::map<std::string, DeviceModelCard> model_cards; // .model definitions by name
+    SymbolTable node_symbols; // Dense node IDs, never reused until clear()
+    Node* getOrCreateNode(const std::string& node_id, bool quiet = false);
+    void registerNodes(Element& element, bool quiet); // Also binds the element's node symbols
 
 public:
     Circuit();
@@ -26,12 +31,17 @@ public:
     Circuit& operator=(const Circuit&) = delete;
 
     void addElement(std::unique_ptr<Element> element);
+    // Appends batch[first..] in order and stops at the first null entry or duplicate name;
+    // returns the index it stopped at (batch.size() when everything was added).
+    size_t addElements(std::vector<std::unique_ptr<Element>>& batch, size_t first = 0);
+    // O(1): the last element is moved into the freed slot, so element order is not preserved
     void deleteElement(const std::string& name);
     void clear();
     void setGroundNode(const std::string& node_id);
     std::string getGroundNodeId() const;
     const std::vector<std::unique_ptr<Element>>& getElements() const;
     const std::map<std::string, std::unique_ptr<Node>>& getNodes() const;
+    const SymbolTable& getNodeSymbols() const { return node_symbols; }
     Element* getElement(const std::string& name) const;
     bool hasElement(const std::string& name) const;
     Node* getNode(const std::string& node_id) const;
@@ -46,18 +56,27 @@ public:
     void updatePreviousNodeVoltages(const std::map<std::string, double>& current_voltages);
     void updatePreviousInductorCurrents(const std::map<std::string, double>& current_inductor_currents);
     const std::map<std::string, double>& getPreviousInductorCurrents() const;
+    void updatePreviousSourceCurrents(const std::map<std::string, double>& current_source_currents);
+    const std::map<std::string, double>& getPreviousSourceCurrents() const;
     void saveToFile(const std::string& filename) const;
 
     // --- NEW: Methods for node labels ---
     void addNodeLabel(const std::string& node_id, const std::string& label);
     const std::map<std::string, std::string>& getNodeLabels() const;
 
+    // --- Device model cards (.model) ---
+    void addModelCard(const DeviceModelCard& model);
+    bool hasModelCard(const std::string& name) const;
+    const DeviceModelCard& getModelCard(const std::string& name) const;
+    const std::map<std::string, DeviceModelCard>& getModelCards() const;
+
     // State for transient analysis
     std::map<std::string, double> previous_node_voltages;
     std::map<std::string, double> previous_inductor_currents;
+    std::map<std::string, double> previous_source_currents; // Voltage-source branch currents
 
     template<class Archive>
     void serialize(Archive& archive) {
-        archive(CEREAL_NVP(elements), CEREAL_NVP(ground_node_id), CEREAL_NVP(node_labels));
+        archive(CEREAL_NVP(elements), CEREAL_NVP(ground_node_id), CEREAL_NVP(node_labels), CEREAL_NVP(model_cards));
     }
 };
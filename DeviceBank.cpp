@@ -0,0 +1,312 @@
+#include "DeviceBank.h"
+#include "ErrorManager.h"
+
+// --- DiodeBank Implementation ---
+bool DiodeBank::isBoundTo(const std::vector<const Diode*>& diodes, int num_nodes) const {
+    return num_nodes == bound_nodes && diodes == devices;
+}
+
+void DiodeBank::clear() {
+    devices.clear();
+    anode_idx.clear(); cathode_idx.clear();
+    sat_current.clear(); inv_nvt.clear(); nvt.clear(); v_crit.clear();
+    vd.clear(); vd_last.clear(); exp_vd.clear(); id.clear(); gd.clear(); ieq.clear();
+    bound_nodes = -1;
+}
+
+void DiodeBank::bind(const std::vector<const Diode*>& diodes, const NodeIndexMap& node_map) {
+    clear();
+    devices = diodes;
+    bound_nodes = static_cast<int>(node_map.size());
+    const size_t n = diodes.size();
+    anode_idx.resize(n); cathode_idx.resize(n);
+    sat_current.resize(n); inv_nvt.resize(n); nvt.resize(n); v_crit.resize(n);
+    vd.assign(n, 0.0); vd_last.assign(n, 0.0); exp_vd.assign(n, 1.0);
+    id.assign(n, 0.0); gd.assign(n, 0.0); ieq.assign(n, 0.0);
+
+    for (size_t i = 0; i < n; ++i) {
+        const Diode* d = diodes[i];
+        anode_idx[i] = d->node1Row(node_map);
+        cathode_idx[i] = d->node2Row(node_map);
+        sat_current[i] = d->getSaturationCurrent();
+        nvt[i] = d->getIdealityFactor() * d->getThermalVoltage();
+        inv_nvt[i] = 1.0 / nvt[i];
+        v_crit[i] = DeviceMath::criticalVoltage(nvt[i], sat_current[i]);
+    }
+    ErrorManager::info("[DiodeBank] bound " + std::to_string(n) + " diodes");
+}
+
+void DiodeBank::gatherNodeVoltages(const NodeIndexMap& node_map,
+                                   const std::map<std::string, double>& prev_node_voltages,
+                                   Vector& dense_out) {
+    dense_out.assign(node_map.size(), 0.0);
+    // Both maps are ordered by node name, so a single merge walk replaces
+    // one string lookup per device terminal.
+    auto prev_it = prev_node_voltages.begin();
+    for (const auto& pair : node_map) {
+        while (prev_it != prev_node_voltages.end() && prev_it->first < pair.first) ++prev_it;
+        if (prev_it == prev_node_voltages.end()) break;
+        if (prev_it->first == pair.first) dense_out[pair.second] = prev_it->second;
+    }
+}
+
+void DiodeBank::evaluate(const Vector& node_voltages) {
+    const size_t n = devices.size();
+    const double* v = node_voltages.data();
+    const int nv = static_cast<int>(node_voltages.size());
+
+    // Gather junction voltages
+    for (size_t i = 0; i < n; ++i) {
+        double va = (anode_idx[i] >= 0 && anode_idx[i] < nv) ? v[anode_idx[i]] : 0.0;
+        double vc = (cathode_idx[i] >= 0 && cathode_idx[i] < nv) ? v[cathode_idx[i]] : 0.0;
+        vd[i] = va - vc;
+    }
+
+    // Junction voltage limiting against the previous linearisation point
+    for (size_t i = 0; i < n; ++i) {
+        vd[i] = DeviceMath::limitJunction(vd[i], vd_last[i], nvt[i], v_crit[i]);
+        vd_last[i] = vd[i];
+    }
+
+    // Exponentials and companion model, straight-line loops over contiguous arrays
+    for (size_t i = 0; i < n; ++i) {
+        exp_vd[i] = DeviceMath::fastExp(vd[i] * inv_nvt[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        id[i] = sat_current[i] * (exp_vd[i] - 1.0);
+        gd[i] = sat_current[i] * exp_vd[i] * inv_nvt[i];
+        ieq[i] = id[i] - gd[i] * vd[i];
+    }
+}
+
+void DiodeBank::stamp(Matrix& G, Vector& J) const {
+    const size_t n = devices.size();
+    for (size_t i = 0; i < n; ++i) {
+        const int a = anode_idx[i];
+        const int c = cathode_idx[i];
+        const double g = gd[i];
+        if (a != -1) { G[a][a] += g; J[a] -= ieq[i]; }
+        if (c != -1) { G[c][c] += g; J[c] += ieq[i]; }
+        if (a != -1 && c != -1) {
+            G[a][c] -= g;
+            G[c][a] -= g;
+        }
+    }
+}
+
+// --- TimeSourceBank Implementation ---
+namespace {
+    // Rotations between exact re-synchronisations of a sinusoid's phasor.
+    constexpr int PHASOR_SYNC_INTERVAL = 64;
+}
+
+bool TimeSourceBank::isTimeSource(const std::string& type) {
+    return type == "PulseVoltageSource" || type == "PulseCurrentSource" || type == "SinusoidalVoltageSource" ||
+           type == "ACVoltageSource" || type == "PhaseVoltageSource";
+}
+
+bool TimeSourceBank::isBoundTo(const std::vector<const Element*>& sources) const {
+    return sources == devices;
+}
+
+void TimeSourceBank::clear() {
+    devices.clear();
+    pulse_slot.clear(); sine_slot.clear();
+    pulses.clear(); sines.clear();
+    values.clear();
+}
+
+void TimeSourceBank::addSegment(PulseProgram& p, double start, double value, double slope) {
+    // Zero-length segments are dropped; anything past the period is truncated,
+    // matching the fmod-based evaluation of the source classes.
+    if (p.period > 0 && start >= p.period) return;
+    if (!p.seg_start.empty() && start <= p.seg_start.back()) {
+        p.seg_value.back() = value;
+        p.seg_slope.back() = slope;
+        return;
+    }
+    p.seg_start.push_back(start);
+    p.seg_value.push_back(value);
+    p.seg_slope.push_back(slope);
+}
+
+void TimeSourceBank::bind(const std::vector<const Element*>& sources) {
+    clear();
+    devices = sources;
+    const size_t n = sources.size();
+    pulse_slot.assign(n, -1);
+    sine_slot.assign(n, -1);
+    values.assign(n, 0.0);
+
+    for (size_t i = 0; i < n; ++i) {
+        const Element* elem = sources[i];
+        const std::string type = elem->getType();
+        if (type == "PulseVoltageSource") {
+            auto* src = static_cast<const PulseVoltageSource*>(elem);
+            const double v1 = src->getV1(), v2 = src->getV2();
+            const double tr = src->getTr(), pw = src->getPw(), tf = src->getTf();
+            PulseProgram p;
+            p.origin = src->getTd();
+            p.period = src->getPer();
+            p.pre_value = v1;
+            // Segments: rise, high, fall, low
+            addSegment(p, 0.0, v1, tr > 0 ? (v2 - v1) / tr : 0.0);
+            addSegment(p, tr, v2, 0.0);
+            addSegment(p, tr + pw, v2, tf > 0 ? (v1 - v2) / tf : 0.0);
+            addSegment(p, tr + pw + tf, v1, 0.0);
+            pulse_slot[i] = static_cast<int>(pulses.size());
+            pulses.push_back(std::move(p));
+        } else if (type == "PulseCurrentSource") {
+            auto* src = static_cast<const PulseCurrentSource*>(elem);
+            const double i1 = src->getI1(), i2 = src->getI2();
+            const double td = src->getTd(), tr = src->getTr(), pw = src->getPw(), tf = src->getTf();
+            PulseProgram p;
+            // The current source repeats from t = 0 with the delay inside each period
+            p.origin = 0.0;
+            p.period = src->getPer();
+            p.pre_value = i1;
+            if (p.period > 0) {
+                addSegment(p, 0.0, i1, 0.0);
+                addSegment(p, td, i1, tr > 0 ? (i2 - i1) / tr : 0.0);
+                addSegment(p, td + tr, i2, 0.0);
+                addSegment(p, td + tr + pw, i2, tf > 0 ? (i1 - i2) / tf : 0.0);
+                addSegment(p, td + tr + pw + tf, i1, 0.0);
+            } else {
+                addSegment(p, 0.0, i1, 0.0); // No period: constant initial value
+            }
+            pulse_slot[i] = static_cast<int>(pulses.size());
+            pulses.push_back(std::move(p));
+        } else {
+            SinePhasor s;
+            if (type == "SinusoidalVoltageSource") {
+                auto* src = static_cast<const SinusoidalVoltageSource*>(elem);
+                s.offset = src->getDCOffset();
+                s.amplitude = src->getFrequency() > 0 ? src->getAmplitude() : 0.0;
+                s.omega = 2.0 * M_PI * src->getFrequency();
+                s.phase = -M_PI / 2.0; // sin(x) = cos(x - pi/2)
+            } else if (type == "ACVoltageSource") {
+                auto* src = static_cast<const ACVoltageSource*>(elem);
+                s.amplitude = src->getMagnitude();
+                s.omega = 2.0 * M_PI * src->getFrequency();
+                s.phase = src->getPhase() * M_PI / 180.0; // Stored in degrees
+            } else if (type == "PhaseVoltageSource") {
+                auto* src = static_cast<const PhaseVoltageSource*>(elem);
+                s.amplitude = src->getMagnitude();
+                s.omega = src->getBaseFrequency(); // Already rad/s
+                s.phase = src->getPhase();
+            }
+            sine_slot[i] = static_cast<int>(sines.size());
+            sines.push_back(s);
+        }
+    }
+    ErrorManager::info("[TimeSourceBank] compiled " + std::to_string(pulses.size()) + " pulse and " +
+                       std::to_string(sines.size()) + " sinusoidal sources");
+}
+
+double TimeSourceBank::evaluatePulse(PulseProgram& p, double t) {
+    if (t < p.origin) return p.pre_value;
+    const bool periodic = p.period > 0;
+
+    double tc = t - p.cycle_start;
+    if (!p.cursor_valid || tc < 0.0 || (periodic && tc >= p.period)) {
+        // Entering a new cycle (or time moved backwards): one floor per cycle
+        double k = periodic ? std::floor((t - p.origin) / p.period) : 0.0;
+        p.cycle_start = p.origin + k * p.period;
+        tc = t - p.cycle_start;
+        if (periodic && tc >= p.period) { p.cycle_start += p.period; tc -= p.period; }
+        if (tc < 0.0) tc = 0.0;
+        p.seg = 0;
+        p.cursor_valid = true;
+    }
+
+    size_t seg = p.seg;
+    const size_t n = p.seg_start.size();
+    if (tc < p.seg_start[seg]) seg = 0;
+    while (seg + 1 < n && tc >= p.seg_start[seg + 1]) ++seg;
+    p.seg = seg;
+    return p.seg_value[seg] + p.seg_slope[seg] * (tc - p.seg_start[seg]);
+}
+
+double TimeSourceBank::evaluateSine(SinePhasor& s, double t) {
+    if (s.amplitude == 0.0) return s.offset;
+    const double dt = t - s.last_t;
+    if (s.valid && dt == 0.0) return s.offset + s.amplitude * s.c;
+
+    if (!s.valid || dt < 0.0 || s.steps_since_sync >= PHASOR_SYNC_INTERVAL) {
+        const double theta = s.omega * t + s.phase;
+        s.c = std::cos(theta);
+        s.s = std::sin(theta);
+        s.steps_since_sync = 0;
+        s.valid = true;
+    } else {
+        // Rotate the phasor by omega*dt; the rotation is recomputed only when the step changes
+        if (std::abs(dt - s.step_dt) > 1e-9 * s.step_dt) {
+            s.step_dt = dt;
+            s.rot_c = std::cos(s.omega * dt);
+            s.rot_s = std::sin(s.omega * dt);
+        }
+        const double c = s.c * s.rot_c - s.s * s.rot_s;
+        s.s = s.s * s.rot_c + s.c * s.rot_s;
+        s.c = c;
+        ++s.steps_since_sync;
+    }
+    s.last_t = t;
+    return s.offset + s.amplitude * s.c;
+}
+
+// Layout: (last_t, c, s, step_dt, rot_c, rot_s, steps_since_sync, valid) per sinusoid
+std::vector<double> TimeSourceBank::getPhasorState() const {
+    std::vector<double> state;
+    state.reserve(8 * sines.size());
+    for (const auto& s : sines) {
+        state.insert(state.end(), {s.last_t, s.c, s.s, s.step_dt, s.rot_c, s.rot_s,
+                                   static_cast<double>(s.steps_since_sync), s.valid ? 1.0 : 0.0});
+    }
+    return state;
+}
+
+void TimeSourceBank::setPhasorState(const std::vector<double>& state) {
+    if (state.size() != 8 * sines.size()) return; // Different set of sources: resynchronise instead
+    for (size_t i = 0; i < sines.size(); ++i) {
+        const double* p = &state[8 * i];
+        SinePhasor& s = sines[i];
+        s.last_t = p[0]; s.c = p[1]; s.s = p[2];
+        s.step_dt = p[3]; s.rot_c = p[4]; s.rot_s = p[5];
+        s.steps_since_sync = static_cast<int>(p[6]);
+        s.valid = p[7] != 0.0;
+    }
+}
+
+void TimeSourceBank::evaluate(double t) {
+    const size_t n = devices.size();
+    for (size_t i = 0; i < n; ++i) {
+        values[i] = (pulse_slot[i] >= 0) ? evaluatePulse(pulses[pulse_slot[i]], t)
+                                         : evaluateSine(sines[sine_slot[i]], t);
+    }
+}
+
+std::vector<double> TimeSourceBank::getBreakpoints(double t_start, double t_stop, size_t max_points) const {
+    std::vector<double> points;
+    for (const auto& p : pulses) {
+        if (p.seg_start.size() < 2 && p.origin <= t_start) continue; // Constant over the window
+        if (p.origin >= t_start && p.origin <= t_stop) points.push_back(p.origin);
+        const bool periodic = p.period > 0;
+        double k = (periodic && t_start > p.origin) ? std::floor((t_start - p.origin) / p.period) : 0.0;
+        for (;; k += 1.0) {
+            const double cycle = p.origin + (periodic ? k * p.period : 0.0);
+            if (cycle > t_stop || points.size() >= max_points) break;
+            for (double s : p.seg_start) {
+                double bp = cycle + s;
+                if (bp >= t_start && bp <= t_stop) points.push_back(bp);
+            }
+            if (!periodic) break;
+        }
+        if (points.size() >= max_points) {
+            ErrorManager::warn("[TimeSourceBank] breakpoint list truncated at " + std::to_string(max_points));
+            break;
+        }
+    }
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    return points;
+}
@@ -0,0 +1,164 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "Element.h"
+
+// --- Fast math kernels for batched device evaluation ---
+// Branch-free polynomial approximations that the compiler can vectorise when
+// they are applied over contiguous arrays. Relative error of fastExp is below
+// 1e-14 over the clamped input range, fastLog below 3e-15 for x > 0 (subnormals included).
+namespace DeviceMath {
+    constexpr double EXP_ARG_LIMIT = 708.0;
+
+    inline double fastExp(double x) {
+        x = std::min(std::max(x, -EXP_ARG_LIMIT), EXP_ARG_LIMIT);
+        const double LOG2E = 1.4426950408889634;
+        const double LN2_HI = 6.93147180369123816490e-01;
+        const double LN2_LO = 1.90821492927058770002e-10;
+        double k = std::floor(x * LOG2E + 0.5);
+        double r = (x - k * LN2_HI) - k * LN2_LO; // |r| <= ln2/2
+        // Degree-11 Taylor polynomial in Horner form
+        double p = 1.0 + r * (1.0 + r * (1.0 / 2 + r * (1.0 / 6 + r * (1.0 / 24 + r * (1.0 / 120 + r * (1.0 / 720
+                 + r * (1.0 / 5040 + r * (1.0 / 40320 + r * (1.0 / 362880 + r * (1.0 / 3628800 + r * (1.0 / 39916800)))))))))));
+        int64_t bits = (static_cast<int64_t>(k) + 1023) << 52;
+        double scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+    inline double fastLog(double x) {
+        const double LN2 = 0.69314718055994530942;
+        const double SQRT2 = 1.41421356237309504880;
+        int64_t e_bias = 1023;
+        if (x < std::numeric_limits<double>::min()) { x *= 18014398509481984.0; e_bias += 54; } // Subnormal: scale by 2^54
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        int64_t e = static_cast<int64_t>((bits >> 52) & 0x7ff) - e_bias;
+        bits = (bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL;
+        double m;
+        std::memcpy(&m, &bits, sizeof(m)); // m in [1, 2)
+        if (m > SQRT2) { m *= 0.5; e += 1; }
+        // log(m) = 2*atanh(s), s = (m-1)/(m+1), |s| <= 0.1716
+        double s = (m - 1.0) / (m + 1.0);
+        double s2 = s * s;
+        double series = 1.0 + s2 * (1.0 / 3 + s2 * (1.0 / 5 + s2 * (1.0 / 7 + s2 * (1.0 / 9 + s2 * (1.0 / 11 + s2 * (1.0 / 13
+                      + s2 * (1.0 / 15 + s2 * (1.0 / 17 + s2 * (1.0 / 19)))))))));
+        return 2.0 * s * series + static_cast<double>(e) * LN2;
+    }
+
+    // SPICE pnjlim: limit the step of a junction voltage against the previous
+    // linearisation point so the exponential cannot overshoot.
+    inline double limitJunction(double vnew, double vold, double nvt, double vcrit) {
+        if (vnew > vcrit && std::abs(vnew - vold) > 2.0 * nvt) {
+            if (vold > 0.0) {
+                double arg = 1.0 + (vnew - vold) / nvt;
+                return (arg > 0.0) ? vold + nvt * fastLog(arg) : vcrit;
+            }
+            return nvt * fastLog(vnew / nvt);
+        }
+        return vnew;
+    }
+
+    inline double criticalVoltage(double nvt, double is) {
+        return nvt * std::log(nvt / (std::sqrt(2.0) * is));
+    }
+}
+
+// --- DiodeBank (Structure-of-arrays batch evaluator for diodes) ---
+// Gathers every Diode of a circuit into contiguous arrays so that the junction
+// voltages, exponentials and companion stamps are computed in one pass instead
+// of one virtual contributeToMNA call (and two std::exp calls) per device.
+// The bank is bound once per topology and then re-evaluated every build.
+class DiodeBank {
+private:
+    std::vector<const Diode*> devices;     // Binding signature
+    std::vector<int> anode_idx, cathode_idx; // -1 for ground
+    std::vector<double> sat_current, inv_nvt, nvt, v_crit;
+    std::vector<double> vd, vd_last, exp_vd, id, gd, ieq;
+    int bound_nodes = -1;
+
+public:
+    bool isBoundTo(const std::vector<const Diode*>& diodes, int num_nodes) const;
+    void bind(const std::vector<const Diode*>& diodes, const NodeIndexMap& node_map);
+    void clear();
+    size_t size() const { return devices.size(); }
+
+    // Gather prior node voltages into a dense array indexed like node_map.
+    static void gatherNodeVoltages(const NodeIndexMap& node_map,
+                                   const std::map<std::string, double>& prev_node_voltages,
+                                   Vector& dense_out);
+
+    // Evaluate all junctions at the given dense node voltages (with pn-junction limiting).
+    void evaluate(const Vector& node_voltages);
+    // Scatter the linearised companion model into the MNA system.
+    void stamp(Matrix& G, Vector& J) const;
+
+    // Junction voltages of the last evaluation, the limiting reference for the next one
+    const std::vector<double>& getLimitState() const { return vd_last; }
+    void setLimitState(const std::vector<double>& state) { if (state.size() == vd_last.size()) vd_last = state; }
+
+    const std::vector<double>& getCurrents() const { return id; }
+    const std::vector<double>& getConductances() const { return gd; }
+};
+
+// --- TimeSourceBank (Compiled evaluator for time-dependent sources) ---
+// Compiled once per analysis from the pulse and sinusoidal sources of a circuit.
+// Pulses become a segment table (start, value, slope) walked by a cursor that
+// only moves forward with simulation time, so no fmod or phase branching is
+// done per step. Sinusoids become phase accumulators that rotate (cos, sin) by
+// a cached step angle and re-synchronise periodically to bound drift.
+// evaluate(t) refreshes every source value in one pass; values are read back
+// by slot in element order.
+class TimeSourceBank {
+private:
+    struct PulseProgram {
+        double origin = 0.0;    // Start of the first cycle
+        double period = 0.0;    // <= 0 means a single cycle
+        double pre_value = 0.0; // Value before origin
+        std::vector<double> seg_start, seg_value, seg_slope; // Relative to the cycle start
+        double cycle_start = 0.0;
+        size_t seg = 0;
+        bool cursor_valid = false;
+    };
+    struct SinePhasor {
+        double offset = 0.0, amplitude = 0.0, omega = 0.0, phase = 0.0;
+        double last_t = 0.0, c = 1.0, s = 0.0;
+        double step_dt = 0.0, rot_c = 1.0, rot_s = 0.0;
+        int steps_since_sync = 0;
+        bool valid = false;
+    };
+
+    std::vector<const Element*> devices;
+    std::vector<int> pulse_slot;  // Index into pulses, or -1
+    std::vector<int> sine_slot;   // Index into sines, or -1
+    std::vector<PulseProgram> pulses;
+    std::vector<SinePhasor> sines;
+    Vector values;
+
+    static void addSegment(PulseProgram& p, double start, double value, double slope);
+    static double evaluatePulse(PulseProgram& p, double t);
+    static double evaluateSine(SinePhasor& s, double t);
+
+public:
+    static bool isTimeSource(const std::string& type);
+    bool isBoundTo(const std::vector<const Element*>& sources) const;
+    void bind(const std::vector<const Element*>& sources);
+    void clear();
+    size_t size() const { return devices.size(); }
+
+    void evaluate(double t);
+    double value(size_t slot) const { return values[slot]; }
+
+    // Sinusoid phasor accumulators, so a restarted transient rotates exactly like the original run
+    std::vector<double> getPhasorState() const;
+    void setPhasorState(const std::vector<double>& state);
+
+    // Times within [t_start, t_stop] where any compiled pulse changes slope.
+    std::vector<double> getBreakpoints(double t_start, double t_stop, size_t max_points = 100000) const;
+};
@@ -2,11 +2,15 @@
 #include "Circuit.h"
 #include "TcpSocket.h"
 #include "ErrorManager.h"
+#include "DeviceBank.h"
 #include <stdexcept>
 #include <cmath>
 #include <limits>
 #include <utility>
 #include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -18,11 +22,12 @@ Element::Element() : name(""), node1_id(""), node2_id("") {}
 Element::Element(const std::string& name, const std::string& node1, const std::string& node2)
     : name(name), node1_id(node1), node2_id(node2) {}
 
-std::string Element::getName() const { return name; }
-std::string Element::getNode1Id() const { return node1_id; }
-std::string Element::getNode2Id() const { return node2_id; }
-void Element::setNode1Id(const std::string& new_id) { node1_id = new_id; }
-void Element::setNode2Id(const std::string& new_id) { node2_id = new_id; }
+const std::string& Element::getName() const { return name; }
+const std::string& Element::getNode1Id() const { return node1_id; }
+const std::string& Element::getNode2Id() const { return node2_id; }
+void Element::setNode1Id(const std::string& new_id) { node1_id = new_id; node1_sym = NO_SYMBOL; }
+void Element::setNode2Id(const std::string& new_id) { node2_id = new_id; node2_sym = NO_SYMBOL; }
+void Element::bindNodeSymbols(SymbolId node1, SymbolId node2) { node1_sym = node1; node2_sym = node2; }
 
 // --- Wire Implementation ---
 CircuitWire::CircuitWire() : Element() {}
@@ -56,13 +61,14 @@ std::string Resistor::getAddCommandString() const {
 }
 
 void Resistor::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
+    // Either side may be ground (-1), which has no row or column
+    double conductance = 1.0 / resistance;
+    if (n1 != -1) G[n1][n1] += conductance;
+    if (n2 != -1) G[n2][n2] += conductance;
     if (n1 != -1 && n2 != -1) {
-        double conductance = 1.0 / resistance;
-        G[n1][n1] += conductance;
-        G[n2][n2] += conductance;
         G[n1][n2] -= conductance;
         G[n2][n1] -= conductance;
     }
@@ -87,20 +93,22 @@ void Capacitor::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeI
         return;
     }
 
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
-    if (n1 != -1 && n2 != -1) {
+    if (n1 != -1 || n2 != -1) {
         // For transient analysis, use backward Euler: C*dV/dt = I
         // Discretized: C*(V[n] - V[n-1])/dt = I[n]
         // Rearranged: C/dt * V[n] = I[n] + C/dt * V[n-1]
         double conductance = capacitance / timestep;
         
-        // Add conductance matrix contributions
-        G[n1][n1] += conductance;
-        G[n2][n2] += conductance;
-        G[n1][n2] -= conductance;
-        G[n2][n1] -= conductance;
+        // Add conductance matrix contributions (ground side has no row or column)
+        if (n1 != -1) G[n1][n1] += conductance;
+        if (n2 != -1) G[n2][n2] += conductance;
+        if (n1 != -1 && n2 != -1) {
+            G[n1][n2] -= conductance;
+            G[n2][n1] -= conductance;
+        }
 
         // Add current source from previous voltage step
         double v1_prev = prev_voltages.count(node1_id) ? prev_voltages.at(node1_id) : 0.0;
@@ -135,8 +143,8 @@ std::string Inductor::getAddCommandString() const {
 }
 
 void Inductor::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>& prev_inductor_currents, bool is_transient, double timestep) {
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     if (n1 != -1 && n2 != -1) {
         if (is_transient && timestep > 0) {
@@ -156,6 +164,32 @@ void Inductor::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIn
     }
 }
 
+// --- Mutual Inductance Implementation ---
+MutualInductance::MutualInductance() : Element(), coupling(0.0) {}
+
+MutualInductance::MutualInductance(const std::string& name, const std::vector<std::string>& inductors, double k)
+    : Element(name, "", ""), inductor_names(inductors), coupling(0.0) {
+    if (inductor_names.size() < 2) throw std::runtime_error("Mutual inductance " + name + " needs at least two inductors.");
+    setValue(k);
+}
+
+std::string MutualInductance::getType() const { return "MutualInductance"; }
+double MutualInductance::getValue() const { return coupling; }
+void MutualInductance::setValue(double value) {
+    if (!(value > 0.0 && value <= 1.0)) throw std::runtime_error("Coupling coefficient must be in (0, 1].");
+    coupling = value;
+}
+std::string MutualInductance::getAddCommandString() const {
+    std::string cmd = "K " + name;
+    for (const auto& l : inductor_names) cmd += " " + l;
+    return cmd + " " + std::to_string(coupling);
+}
+const std::vector<std::string>& MutualInductance::getInductorNames() const { return inductor_names; }
+
+void MutualInductance::contributeToMNA(Matrix&, Vector&, int, const NodeIndexMap&, const std::map<std::string, double>&, bool, double) {
+    // Coupling terms live in the inductor branch rows and are stamped in MNAMatrix::build
+}
+
 // --- Independent Voltage Source Implementation ---
 IndependentVoltageSource::IndependentVoltageSource() : Element(), voltage_value(0.0) {}
 
@@ -172,8 +206,8 @@ std::string IndependentVoltageSource::getAddCommandString() const {
 void IndependentVoltageSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
     // For voltage sources, we need to add a current variable to the MNA matrix
     // This is handled in MNAMatrix::build by adding extra rows/columns
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     if (n1 != -1 && n2 != -1) {
         // The voltage difference constraint will be handled in MNAMatrix::build
@@ -194,8 +228,8 @@ std::string IndependentCurrentSource::getAddCommandString() const {
 }
 
 void IndependentCurrentSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     if (n1 != -1) J[n1] -= current_value;
     if (n2 != -1) J[n2] += current_value;
@@ -265,8 +299,8 @@ void PulseVoltageSource::setPer(double new_per) { per_val = new_per; }
 void PulseVoltageSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
     // For time-dependent voltage sources, we need to add a current variable to the MNA matrix
     // This is handled in MNAMatrix::build by adding extra rows/columns
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
     
     if (n1 != -1 && n2 != -1) {
         // The voltage difference constraint will be handled in MNAMatrix::build
@@ -287,6 +321,10 @@ std::string SinusoidalVoltageSource::getAddCommandString() const {
     return "Vsin " + name + " " + node1_id + " " + node2_id + " " + std::to_string(dc_offset) + " " + std::to_string(amplitude) + " " + std::to_string(frequency);
 }
 
+double SinusoidalVoltageSource::getDCOffset() const { return dc_offset; }
+double SinusoidalVoltageSource::getAmplitude() const { return amplitude; }
+double SinusoidalVoltageSource::getFrequency() const { return frequency; }
+
 double SinusoidalVoltageSource::getVoltageAtTime(double current_time) const {
     if (frequency <= 0) return dc_offset;
     return dc_offset + amplitude * std::sin(2.0 * M_PI * frequency * current_time);
@@ -295,8 +333,8 @@ double SinusoidalVoltageSource::getVoltageAtTime(double current_time) const {
 void SinusoidalVoltageSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
     // For time-dependent voltage sources, we need to add a current variable to the MNA matrix
     // This is handled in MNAMatrix::build by adding extra rows/columns
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     if (n1 != -1 && n2 != -1) {
         // The voltage difference constraint will be handled in MNAMatrix::build
@@ -330,8 +368,8 @@ std::complex<double> ACVoltageSource::getComplexVoltage() const {
 
 void ACVoltageSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
     // For AC voltage sources, the contribution is handled in ComplexMNAMatrix::build
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     if (n1 != -1 && n2 != -1) {
         // The voltage difference constraint will be handled in ComplexMNAMatrix::build
@@ -384,8 +422,8 @@ double PulseCurrentSource::getCurrentAtTime(double current_time) const {
 }
 
 void PulseCurrentSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool is_transient, double currentTime) {
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     double current_value = is_transient ? getCurrentAtTime(currentTime) : i1; // Use initial value for DC
     
@@ -396,22 +434,82 @@ void PulseCurrentSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, co
 // --- Waveform Voltage Source Implementation ---
 
 // --- Waveform Voltage Source Implementation ---
-WaveformVoltageSource::WaveformVoltageSource() : Element(), sampling_rate(1000.0), signal_duration(1.0), start_time(0.0), repeat(false) {}
+// --- Deferred project payloads ---
+ProjectPayloadContext*& ProjectPayloadContext::active() {
+    thread_local ProjectPayloadContext* context = nullptr;
+    return context;
+}
+
+std::vector<double> DeferredSamples::read() const {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    const uint64_t size = fs::file_size(path, ec);
+    const auto time = fs::last_write_time(path, ec);
+    if (ec || size != file_size || time.time_since_epoch().count() != file_time) {
+        throw std::runtime_error("Project file '" + path + "' changed since it was loaded; waveform samples are unavailable.");
+    }
+    std::ifstream is(path, std::ios::in | std::ios::binary);
+    is.seekg(static_cast<std::streamoff>(offset));
+    std::vector<double> samples(count);
+    is.read(reinterpret_cast<char*>(samples.data()), static_cast<std::streamsize>(count * sizeof(double)));
+    if (!is) throw std::runtime_error("Could not read waveform samples from project file '" + path + "'.");
+    if (!cereal::portable_binary_detail::is_little_endian()) {
+        for (double& v : samples) {
+            auto* bytes = reinterpret_cast<unsigned char*>(&v);
+            std::reverse(bytes, bytes + sizeof(double));
+        }
+    }
+    return samples;
+}
+
+void WaveformVoltageSource::loadDeferredSamples() const {
+    voltage_values = deferred->read();
+    deferred.reset();
+    ErrorManager::info("[Waveform] " + name + ": loaded " + std::to_string(voltage_values.size()) + " deferred samples");
+}
+
+WaveformVoltageSource::WaveformVoltageSource() : Element(), sampling_rate(1000.0), signal_duration(1.0), start_time(0.0), repeat(false), sample_format("F64") {}
 
 WaveformVoltageSource::WaveformVoltageSource(const std::string& name, const std::string& node1, const std::string& node2,
                                              const std::vector<double>& values, double fs, double duration, double start_time, bool repeat)
-    : Element(name, node1, node2), voltage_values(values), sampling_rate(fs), signal_duration(duration), start_time(start_time), repeat(repeat) {}
+    : Element(name, node1, node2), voltage_values(values), sampling_rate(fs), signal_duration(duration), start_time(start_time), repeat(repeat), sample_format("F64") {}
+
+WaveformVoltageSource::WaveformVoltageSource(const std::string& name, const std::string& node1, const std::string& node2,
+                                             const std::string& sample_file, double fs, const std::string& sample_format,
+                                             double start_time, bool repeat)
+    : Element(name, node1, node2), sampling_rate(fs), signal_duration(0.0), start_time(start_time), repeat(repeat),
+      sample_file(sample_file), sample_format(SampleStream::formatName(SampleStream::parseFormat(sample_format))) {
+    if (fs <= 0) throw std::runtime_error("Waveform sampling rate must be positive.");
+    signal_duration = static_cast<double>(getStream().size()) / fs; // Opens the file, throws if missing
+}
+
+SampleStream& WaveformVoltageSource::getStream() const {
+    if (!stream) stream = std::make_shared<SampleStream>(sample_file, SampleStream::parseFormat(sample_format));
+    return *stream;
+}
+
+bool WaveformVoltageSource::isStreamed() const { return !sample_file.empty(); }
+const std::string& WaveformVoltageSource::getSampleFile() const { return sample_file; }
 
 std::string WaveformVoltageSource::getType() const { return "WaveformVoltageSource"; }
 double WaveformVoltageSource::getValue() const { 
+    if (isStreamed()) return getStream().sample(0);
+    ensureSamples();
     return voltage_values.empty() ? 0.0 : voltage_values[0]; 
 }
 void WaveformVoltageSource::setValue(double value) { 
+    ensureSamples();
     if (!voltage_values.empty()) voltage_values[0] = value; 
 }
 
 std::string WaveformVoltageSource::getAddCommandString() const {
     std::stringstream ss;
+    if (isStreamed()) {
+        ss << "add " << name << " " << node1_id << " " << node2_id << " FILE " << sample_file << " "
+           << sampling_rate << " " << sample_format;
+        return ss.str();
+    }
+    ensureSamples();
     ss << "VWAVEFORM " << name << " " << node1_id << " " << node2_id << " " 
        << sampling_rate << " " << signal_duration << " " << start_time << " " << (repeat ? 1 : 0) << " [";
     for (size_t i = 0; i < voltage_values.size(); ++i) {
@@ -422,7 +520,14 @@ std::string WaveformVoltageSource::getAddCommandString() const {
     return ss.str();
 }
 
-double WaveformVoltageSource::getVoltageAtTime(double time) const {
+double WaveformVoltageSource::getVoltageAtTime(double time, double sim_step) const {
+    if (isStreamed()) {
+        if (time < start_time) return 0.0;
+        double relative_time = time - start_time;
+        if (repeat && signal_duration > 0.0) relative_time = fmod(relative_time, signal_duration);
+        return getStream().valueAt(relative_time * sampling_rate, sim_step * sampling_rate);
+    }
+    ensureSamples();
     if (voltage_values.empty()) return 0.0;
     
     // Check if we're before the start time
@@ -457,13 +562,13 @@ double WaveformVoltageSource::getVoltageAtTime(double time) const {
     return voltage_values[index_floor] * (1.0 - fraction) + voltage_values[index_ceil] * fraction;
 }
 
-const std::vector<double>& WaveformVoltageSource::getVoltageValues() const { return voltage_values; }
+const std::vector<double>& WaveformVoltageSource::getVoltageValues() const { ensureSamples(); return voltage_values; }
 double WaveformVoltageSource::getSamplingRate() const { return sampling_rate; }
 double WaveformVoltageSource::getSignalDuration() const { return signal_duration; }
 double WaveformVoltageSource::getStartTime() const { return start_time; }
 bool WaveformVoltageSource::getRepeat() const { return repeat; }
 
-void WaveformVoltageSource::setVoltageValues(const std::vector<double>& values) { voltage_values = values; }
+void WaveformVoltageSource::setVoltageValues(const std::vector<double>& values) { deferred.reset(); voltage_values = values; }
 void WaveformVoltageSource::setSamplingRate(double fs) { sampling_rate = fs; }
 void WaveformVoltageSource::setSignalDuration(double duration) { signal_duration = duration; }
 void WaveformVoltageSource::setStartTime(double start_time) { this->start_time = start_time; }
@@ -553,8 +658,8 @@ double VoltageControlledVoltageSource::getGain() const { return gain; }
 void VoltageControlledVoltageSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
     // For dependent voltage sources, we need to add a current variable to the MNA matrix
     // This is handled in MNAMatrix::build by adding extra rows/columns
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
     int cn1 = node_map.count(control_node1_id) ? node_map.at(control_node1_id) : -1;
     int cn2 = node_map.count(control_node2_id) ? node_map.at(control_node2_id) : -1;
     
@@ -581,8 +686,8 @@ std::string VoltageControlledCurrentSource::getControlNode2Id() const { return c
 double VoltageControlledCurrentSource::getTransconductance() const { return transconductance; }
 
 void VoltageControlledCurrentSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
     int ctrl_n1 = node_map.count(control_node1_id) ? node_map.at(control_node1_id) : -1;
     int ctrl_n2 = node_map.count(control_node2_id) ? node_map.at(control_node2_id) : -1;
 
@@ -646,10 +751,19 @@ void Diode::setValue(double value) { /* Diodes don't have simple values */ }
 std::string Diode::getAddCommandString() const {
     return "D " + name + " " + node1_id + " " + node2_id + " " + model_type;
 }
+double Diode::getSaturationCurrent() const { return saturation_current; }
+double Diode::getIdealityFactor() const { return ideality_factor; }
+double Diode::getThermalVoltage() const { return thermal_voltage; }
+
+void Diode::applyModelCard(const DeviceModelCard& model) {
+    saturation_current = model.get("IS", saturation_current);
+    ideality_factor = model.get("N", ideality_factor);
+    thermal_voltage = model.get("VT", thermal_voltage);
+}
 
 void Diode::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>& prev_voltages, bool, double) {
-    int n1 = node_map.count(node1_id) ? node_map.at(node1_id) : -1;
-    int n2 = node_map.count(node2_id) ? node_map.at(node2_id) : -1;
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
 
     if (n1 != -1 && n2 != -1) {
         // Get previous voltages for linearization
@@ -674,6 +788,652 @@ void Diode::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndex
     }
 }
 
+// --- MOSFET Implementation ---
+Mosfet::Mosfet() : Element(), gate_id(""), model_name(""), polarity(1), kp(2e-5), vto(1.0), lambda(0.0), width(1e-6), length(1e-6) {}
+
+Mosfet::Mosfet(const std::string& name, const std::string& drain, const std::string& gate, const std::string& source,
+               const DeviceModelCard& model, double w, double l)
+    : Element(name, drain, source), gate_id(gate), model_name(model.name), width(w), length(l) {
+    if (model.type == "NMOS") polarity = 1;
+    else if (model.type == "PMOS") polarity = -1;
+    else throw std::runtime_error("Model '" + model.name + "' is not a MOSFET model (NMOS/PMOS).");
+    if (w <= 0 || l <= 0) throw std::runtime_error("MOSFET " + name + " requires positive W and L.");
+    kp = model.get("KP", 2e-5);
+    vto = std::abs(model.get("VTO", 1.0));
+    lambda = model.get("LAMBDA", 0.0);
+}
+
+std::string Mosfet::getType() const { return "Mosfet"; }
+double Mosfet::getValue() const { return width; }
+void Mosfet::setValue(double value) { if (value > 0) width = value; }
+std::string Mosfet::getAddCommandString() const {
+    return "M " + name + " " + node1_id + " " + gate_id + " " + node2_id + " " + model_name + " W=" + std::to_string(width) + " L=" + std::to_string(length);
+}
+std::string Mosfet::getGateId() const { return gate_id; }
+std::string Mosfet::getModelName() const { return model_name; }
+int Mosfet::getPolarity() const { return polarity; }
+
+void Mosfet::evaluate(double vgs, double vds, double& id, double& gm, double& gds) const {
+    // Polarity-normalised forward mode (vds >= 0) is expected here
+    const double beta = kp * width / length;
+    const double vov = vgs - vto;
+    const double clm = 1.0 + lambda * vds;
+    if (vov <= 0.0) {
+        // Cutoff
+        id = 0.0; gm = 0.0; gds = 0.0;
+    } else if (vds < vov) {
+        // Linear (triode) region
+        double core = vov * vds - 0.5 * vds * vds;
+        id = beta * core * clm;
+        gm = beta * vds * clm;
+        gds = beta * (vov - vds) * clm + beta * core * lambda;
+    } else {
+        // Saturation
+        double core = 0.5 * vov * vov;
+        id = beta * core * clm;
+        gm = beta * vov * clm;
+        gds = beta * core * lambda;
+    }
+}
+
+void Mosfet::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>& prev_voltages, bool, double) {
+    int d = node1Row(node_map);
+    int g = node_map.count(gate_id) ? node_map.at(gate_id) : -1;
+    int s = node2Row(node_map);
+
+    double vd = prev_voltages.count(node1_id) ? prev_voltages.at(node1_id) : 0.0;
+    double vg = prev_voltages.count(gate_id) ? prev_voltages.at(gate_id) : 0.0;
+    double vs = prev_voltages.count(node2_id) ? prev_voltages.at(node2_id) : 0.0;
+
+    // Reverse mode: the terminal at the lower (polarity-adjusted) potential acts as source
+    if (polarity * (vd - vs) < 0.0) {
+        std::swap(d, s);
+        std::swap(vd, vs);
+    }
+    double vgs = vg - vs;
+    double vds = vd - vs;
+
+    double id, gm, gds;
+    evaluate(polarity * vgs, polarity * vds, id, gm, gds);
+    gds += 1e-12; // GMIN across the channel keeps cutoff devices non-singular
+
+    // Linearised drain current i = Ieq + gm*vgs + gds*vds, flowing drain -> source
+    double ieq = polarity * id - gm * vgs - gds * vds;
+
+    if (d != -1) {
+        G[d][d] += gds;
+        if (g != -1) G[d][g] += gm;
+        if (s != -1) G[d][s] -= gds + gm;
+        J[d] -= ieq;
+    }
+    if (s != -1) {
+        G[s][s] += gds + gm;
+        if (g != -1) G[s][g] -= gm;
+        if (d != -1) G[s][d] -= gds;
+        J[s] += ieq;
+    }
+}
+
+// --- Bipolar Transistor Implementation ---
+BipolarTransistor::BipolarTransistor() : Element(), base_id(""), model_name(""), polarity(1), saturation_current(1e-16), beta_f(100.0), beta_r(1.0), thermal_voltage(0.026) {}
+
+BipolarTransistor::BipolarTransistor(const std::string& name, const std::string& collector, const std::string& base, const std::string& emitter,
+                                     const DeviceModelCard& model)
+    : Element(name, collector, emitter), base_id(base), model_name(model.name) {
+    if (model.type == "NPN") polarity = 1;
+    else if (model.type == "PNP") polarity = -1;
+    else throw std::runtime_error("Model '" + model.name + "' is not a BJT model (NPN/PNP).");
+    saturation_current = model.get("IS", 1e-16);
+    beta_f = model.get("BF", 100.0);
+    beta_r = model.get("BR", 1.0);
+    thermal_voltage = model.get("VT", 0.026);
+    if (saturation_current <= 0 || beta_f <= 0 || beta_r <= 0) throw std::runtime_error("BJT " + name + " has invalid model parameters.");
+}
+
+std::string BipolarTransistor::getType() const { return "BipolarTransistor"; }
+double BipolarTransistor::getValue() const { return beta_f; }
+void BipolarTransistor::setValue(double value) { if (value > 0) beta_f = value; }
+std::string BipolarTransistor::getAddCommandString() const {
+    return "Q " + name + " " + node1_id + " " + base_id + " " + node2_id + " " + model_name;
+}
+std::string BipolarTransistor::getBaseId() const { return base_id; }
+std::string BipolarTransistor::getModelName() const { return model_name; }
+
+void BipolarTransistor::saveTransientState(std::vector<double>& state) const {
+    state = {last_vbe, last_vbc};
+}
+
+void BipolarTransistor::restoreTransientState(const std::vector<double>& state) {
+    if (state.size() != 2) throw std::runtime_error("Invalid checkpoint state for BJT " + name + ".");
+    last_vbe = state[0];
+    last_vbc = state[1];
+}
+int BipolarTransistor::getPolarity() const { return polarity; }
+
+void BipolarTransistor::evaluate(double vbe, double vbc, double& ic, double& ib,
+                                 double& dic_dvbe, double& dic_dvbc, double& dib_dvbe, double& dib_dvbc) const {
+    double exp_be = DeviceMath::fastExp(vbe / thermal_voltage);
+    double exp_bc = DeviceMath::fastExp(vbc / thermal_voltage);
+    double i_f = saturation_current * (exp_be - 1.0);
+    double i_r = saturation_current * (exp_bc - 1.0);
+    double g_f = saturation_current * exp_be / thermal_voltage;
+    double g_r = saturation_current * exp_bc / thermal_voltage;
+
+    // Transport model: Ic = If - Ir - Ir/BR, Ib = If/BF + Ir/BR
+    ic = i_f - i_r - i_r / beta_r;
+    ib = i_f / beta_f + i_r / beta_r;
+    dic_dvbe = g_f;
+    dic_dvbc = -g_r - g_r / beta_r;
+    dib_dvbe = g_f / beta_f;
+    dib_dvbc = g_r / beta_r;
+}
+
+void BipolarTransistor::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>& prev_voltages, bool, double) {
+    int c = node1Row(node_map);
+    int b = node_map.count(base_id) ? node_map.at(base_id) : -1;
+    int e = node2Row(node_map);
+
+    double vc = prev_voltages.count(node1_id) ? prev_voltages.at(node1_id) : 0.0;
+    double vb = prev_voltages.count(base_id) ? prev_voltages.at(base_id) : 0.0;
+    double ve = prev_voltages.count(node2_id) ? prev_voltages.at(node2_id) : 0.0;
+
+    // Polarity-normalised junction voltages, limited against the last linearisation point
+    double vcrit = DeviceMath::criticalVoltage(thermal_voltage, saturation_current);
+    double vbe = DeviceMath::limitJunction(polarity * (vb - ve), last_vbe, thermal_voltage, vcrit);
+    double vbc = DeviceMath::limitJunction(polarity * (vb - vc), last_vbc, thermal_voltage, vcrit);
+    last_vbe = vbe;
+    last_vbc = vbc;
+
+    double ic, ib, a1, a2, b1, b2;
+    evaluate(vbe, vbc, ic, ib, a1, a2, b1, b2);
+
+    // Back to circuit polarity: terminal currents flip sign, derivatives do not
+    double vbe_c = polarity * vbe, vbc_c = polarity * vbc;
+    double ic_eq = polarity * ic - a1 * vbe_c - a2 * vbc_c;
+    double ib_eq = polarity * ib - b1 * vbe_c - b2 * vbc_c;
+
+    // Ic(v) = ic_eq + a1*(vb - ve) + a2*(vb - vc), entering the collector
+    if (c != -1) {
+        if (b != -1) G[c][b] += a1 + a2;
+        if (e != -1) G[c][e] -= a1;
+        G[c][c] -= a2;
+        J[c] -= ic_eq;
+    }
+    // Ib(v) = ib_eq + b1*(vb - ve) + b2*(vb - vc), entering the base
+    if (b != -1) {
+        G[b][b] += b1 + b2;
+        if (e != -1) G[b][e] -= b1;
+        if (c != -1) G[b][c] -= b2;
+        J[b] -= ib_eq;
+    }
+    // Ie = -(Ic + Ib), entering the emitter
+    if (e != -1) {
+        if (b != -1) G[e][b] -= (a1 + a2) + (b1 + b2);
+        G[e][e] += a1 + b1;
+        if (c != -1) G[e][c] += a2 + b2;
+        J[e] += ic_eq + ib_eq;
+    }
+}
+
+// --- Table Device Implementation ---
+TableDevice::TableDevice() : Element(), table_path("") {}
+
+TableDevice::TableDevice(const std::string& name, const std::string& node1, const std::string& node2,
+                         const std::vector<double>& voltages, const std::vector<double>& currents,
+                         const std::vector<double>& cv_voltages, const std::vector<double>& capacitances)
+    : Element(name, node1, node2), iv_voltage(voltages), iv_current(currents), cv_voltage(cv_voltages), cv_capacitance(capacitances) {
+    buildSplines();
+}
+
+void TableDevice::buildSplines() {
+    iv_spline.setPoints(iv_voltage, iv_current);
+    if (!cv_voltage.empty()) cv_spline.setPoints(cv_voltage, cv_capacitance);
+}
+
+std::string TableDevice::getType() const { return "TableDevice"; }
+double TableDevice::getValue() const { return std::numeric_limits<double>::quiet_NaN(); }
+void TableDevice::setValue(double value) { /* Tabulated devices don't have simple values */ }
+std::string TableDevice::getAddCommandString() const {
+    return "Y " + name + " " + node1_id + " " + node2_id + " TABLE " + (table_path.empty() ? "<inline>" : table_path);
+}
+void TableDevice::setTablePath(const std::string& path) { table_path = path; }
+
+double TableDevice::getCurrent(double v, double& conductance) {
+    if (iv_spline.empty()) buildSplines(); // After deserialisation
+    return iv_spline.evaluate(v, conductance);
+}
+
+double TableDevice::getCapacitance(double v) {
+    if (cv_voltage.empty()) return 0.0;
+    if (cv_spline.empty()) buildSplines();
+    return std::max(0.0, cv_spline.evaluate(v));
+}
+
+void TableDevice::loadCSV(const std::string& path, std::vector<double>& xs, std::vector<double>& ys) {
+    std::ifstream infile(path);
+    if (!infile.is_open()) throw std::runtime_error("Could not open table file: " + path);
+    xs.clear();
+    ys.clear();
+    std::string line;
+    while (std::getline(infile, line)) {
+        for (char& ch : line) if (ch == ',' || ch == ';' || ch == '\t') ch = ' ';
+        std::istringstream iss(line);
+        double x, y;
+        if (iss >> x >> y) {
+            xs.push_back(x);
+            ys.push_back(y);
+        }
+    }
+    if (xs.size() < 2) throw std::runtime_error("Table file '" + path + "' has fewer than two data rows.");
+}
+
+void TableDevice::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>& prev_voltages, bool is_transient, double timestep) {
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
+
+    double v1_prev = prev_voltages.count(node1_id) ? prev_voltages.at(node1_id) : 0.0;
+    double v2_prev = prev_voltages.count(node2_id) ? prev_voltages.at(node2_id) : 0.0;
+    double v_prev = v1_prev - v2_prev;
+
+    // Same companion model as the diode: conductance plus equivalent current source
+    double g;
+    double i = getCurrent(v_prev, g);
+    g = std::max(g, 1e-12);
+    double i_eq = i - g * v_prev;
+
+    // Voltage-dependent capacitance, backward Euler with C evaluated at the previous step
+    if (is_transient && timestep > 0 && !cv_voltage.empty()) {
+        double gc = getCapacitance(v_prev) / timestep;
+        g += gc;
+        i_eq -= gc * v_prev;
+    }
+
+    if (n1 != -1) { G[n1][n1] += g; J[n1] -= i_eq; }
+    if (n2 != -1) { G[n2][n2] += g; J[n2] += i_eq; }
+    if (n1 != -1 && n2 != -1) {
+        G[n1][n2] -= g;
+        G[n2][n1] -= g;
+    }
+}
+
+// --- Switch Implementation ---
+Switch::Switch() : Element(), control(Control::VOLTAGE), r_on(1.0), r_off(1e6), v_threshold(0.0), v_hysteresis(0.0), initial_on(false) {}
+
+Switch::Switch(const std::string& name, const std::string& node1, const std::string& node2,
+               const std::string& ctrl_pos, const std::string& ctrl_neg, const DeviceModelCard& model, bool initial_on)
+    : Element(name, node1, node2), control(Control::VOLTAGE), ctrl_pos(ctrl_pos), ctrl_neg(ctrl_neg), initial_on(initial_on) {
+    applyModel(model);
+}
+
+Switch::Switch(const std::string& name, const std::string& node1, const std::string& node2,
+               const std::vector<double>& times, const DeviceModelCard& model, bool initial_on)
+    : Element(name, node1, node2), control(Control::TIME), toggle_times(times), initial_on(initial_on) {
+    if (!std::is_sorted(toggle_times.begin(), toggle_times.end())) throw std::runtime_error("Switch " + name + " toggle times must be increasing.");
+    applyModel(model);
+}
+
+void Switch::applyModel(const DeviceModelCard& model) {
+    if (model.type != "SW") throw std::runtime_error("Model " + model.name + " is not a switch (SW) model.");
+    model_name = model.name;
+    r_on = model.get("RON", 1.0);
+    r_off = model.get("ROFF", 1e6);
+    v_threshold = model.get("VT", 0.0);
+    v_hysteresis = std::abs(model.get("VH", 0.0));
+    if (r_on <= 0 || r_off <= 0) throw std::runtime_error("Switch model " + model.name + " needs positive RON and ROFF.");
+    resetState();
+}
+
+std::string Switch::getType() const { return "Switch"; }
+double Switch::getValue() const { return r_on; }
+void Switch::setValue(double value) {
+    if (value <= 0) throw std::runtime_error("Switch on-resistance must be positive.");
+    r_on = value;
+}
+std::string Switch::getAddCommandString() const {
+    std::string cmd = "S " + name + " " + node1_id + " " + node2_id + " ";
+    if (control == Control::VOLTAGE) return cmd + ctrl_pos + " " + ctrl_neg + " " + model_name;
+    cmd += "TIME " + model_name + (initial_on ? " ON" : " OFF");
+    for (double t : toggle_times) cmd += " " + std::to_string(t);
+    return cmd;
+}
+Switch::Control Switch::getControl() const { return control; }
+std::string Switch::getControlPosId() const { return ctrl_pos; }
+std::string Switch::getControlNegId() const { return ctrl_neg; }
+bool Switch::isOn() const { return is_on; }
+
+void Switch::resetState() {
+    is_on = initial_on;
+    next_toggle = 0;
+    while (control == Control::TIME && next_toggle < toggle_times.size() && toggle_times[next_toggle] <= 0.0) {
+        is_on = !is_on;
+        ++next_toggle;
+    }
+}
+
+bool Switch::wantsToggle(const std::map<std::string, double>& node_voltages) const {
+    if (control != Control::VOLTAGE) return false;
+    auto at = [&node_voltages](const std::string& id) {
+        auto it = node_voltages.find(id);
+        return it != node_voltages.end() ? it->second : 0.0;
+    };
+    double vc = at(ctrl_pos) - at(ctrl_neg);
+    return is_on ? (vc < v_threshold - v_hysteresis) : (vc > v_threshold + v_hysteresis);
+}
+
+double Switch::nextToggleTime(double t) const {
+    if (control != Control::TIME) return std::numeric_limits<double>::infinity();
+    auto it = std::upper_bound(toggle_times.begin() + next_toggle, toggle_times.end(), t);
+    return it != toggle_times.end() ? *it : std::numeric_limits<double>::infinity();
+}
+
+void Switch::toggle() {
+    is_on = !is_on;
+    if (control == Control::TIME && next_toggle < toggle_times.size()) ++next_toggle;
+}
+
+void Switch::saveTransientState(std::vector<double>& state) const {
+    state = {is_on ? 1.0 : 0.0, static_cast<double>(next_toggle)};
+}
+
+void Switch::restoreTransientState(const std::vector<double>& state) {
+    if (state.size() != 2) throw std::runtime_error("Invalid checkpoint state for switch " + name + ".");
+    is_on = state[0] != 0.0;
+    next_toggle = std::min(static_cast<size_t>(state[1]), toggle_times.size());
+}
+
+void Switch::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) {
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
+    double g = 1.0 / (is_on ? r_on : r_off);
+    if (n1 != -1) G[n1][n1] += g;
+    if (n2 != -1) G[n2][n2] += g;
+    if (n1 != -1 && n2 != -1) {
+        G[n1][n2] -= g;
+        G[n2][n1] -= g;
+    }
+}
+
+// --- Behavioral Source Implementation ---
+BehavioralSource::BehavioralSource() : Element(), kind(Kind::CURRENT), expression("0") {}
+
+BehavioralSource::BehavioralSource(const std::string& name, const std::string& node1, const std::string& node2, Kind kind, const std::string& expression)
+    : Element(name, node1, node2), kind(kind), expression(expression) {
+    compile();
+}
+
+void BehavioralSource::compile() {
+    tape = ExpressionTape::compile(expression);
+    for (const auto& var : tape.getVariables()) {
+        bool probe = var.size() > 3 && (var.compare(0, 2, "V(") == 0 || var.compare(0, 2, "I(") == 0);
+        if (!probe && var != "time" && var != "TIME" && var != "t") {
+            throw std::runtime_error("Unknown variable '" + var + "' in " + name + ". Use V(node), V(a,b), I(branch) or time.");
+        }
+    }
+    inputs.assign(tape.getVariables().size(), 0.0);
+    gradient.assign(tape.getVariables().size(), 0.0);
+}
+
+std::string BehavioralSource::getType() const {
+    return kind == Kind::VOLTAGE ? "BehavioralVoltageSource" : "BehavioralCurrentSource";
+}
+double BehavioralSource::getValue() const { return std::numeric_limits<double>::quiet_NaN(); }
+void BehavioralSource::setValue(double value) { /* Defined by its expression */ }
+std::string BehavioralSource::getAddCommandString() const {
+    return "B " + name + " " + node1_id + " " + node2_id + (kind == Kind::VOLTAGE ? " V=" : " I=") + expression;
+}
+BehavioralSource::Kind BehavioralSource::getKind() const { return kind; }
+const std::string& BehavioralSource::getExpression() const { return expression; }
+void BehavioralSource::setExpression(const std::string& expr) {
+    std::string previous = expression;
+    expression = expr;
+    try {
+        compile();
+    } catch (...) {
+        expression = previous;
+        compile();
+        throw;
+    }
+}
+
+std::vector<std::string> BehavioralSource::getReferencedNodes() const {
+    std::vector<std::string> nodes;
+    for (const auto& var : tape.getVariables()) {
+        if (var.compare(0, 2, "V(") == 0) nodes.push_back(var.substr(2, var.size() - 3));
+    }
+    return nodes;
+}
+
+void BehavioralSource::stampLinearized(Matrix& G, Vector& J, const NodeIndexMap& node_map, const std::map<std::string, int>& branch_columns,
+                                       const std::map<std::string, double>& prev_node_voltages, const std::map<std::string, double>& prev_branch_currents,
+                                       double t, int branch_row) const {
+    const auto& vars = tape.getVariables();
+    std::vector<int> columns(vars.size(), -1);
+    for (size_t k = 0; k < vars.size(); ++k) {
+        const std::string& var = vars[k];
+        const std::string id = var.size() > 3 ? var.substr(2, var.size() - 3) : "";
+        if (var.compare(0, 2, "V(") == 0) {
+            auto it = node_map.find(id);
+            if (it != node_map.end()) columns[k] = it->second;
+            auto vt = prev_node_voltages.find(id);
+            inputs[k] = (vt != prev_node_voltages.end()) ? vt->second : 0.0;
+        } else if (var.compare(0, 2, "I(") == 0) {
+            auto it = branch_columns.find(id);
+            if (it == branch_columns.end()) throw std::runtime_error(name + ": I(" + id + ") does not name a voltage source or inductor.");
+            columns[k] = it->second;
+            auto it_prev = prev_branch_currents.find(id);
+            inputs[k] = (it_prev != prev_branch_currents.end()) ? it_prev->second : 0.0;
+        } else {
+            inputs[k] = t; // time
+        }
+    }
+
+    const double value = tape.evaluate(inputs.data(), gradient.data());
+    // f(x) ~ f(x0) + sum g_k (x_k - x0_k): constant part goes to the RHS
+    double constant = value;
+    for (size_t k = 0; k < vars.size(); ++k) {
+        if (columns[k] != -1) constant -= gradient[k] * inputs[k];
+    }
+
+    int n1 = node1Row(node_map);
+    int n2 = node2Row(node_map);
+    if (kind == Kind::CURRENT) {
+        // Current flows from node1 through the source to node2
+        for (size_t k = 0; k < vars.size(); ++k) {
+            if (columns[k] == -1 || gradient[k] == 0.0) continue;
+            if (n1 != -1) G[n1][columns[k]] += gradient[k];
+            if (n2 != -1) G[n2][columns[k]] -= gradient[k];
+        }
+        if (n1 != -1) J[n1] -= constant;
+        if (n2 != -1) J[n2] += constant;
+    } else {
+        if (branch_row < 0) throw std::runtime_error(name + ": behavioural voltage source stamped without a branch row.");
+        if (n1 != -1) { G[n1][branch_row] += 1.0; G[branch_row][n1] += 1.0; }
+        if (n2 != -1) { G[n2][branch_row] -= 1.0; G[branch_row][n2] -= 1.0; }
+        for (size_t k = 0; k < vars.size(); ++k) {
+            if (columns[k] != -1) G[branch_row][columns[k]] -= gradient[k];
+        }
+        J[branch_row] = constant;
+    }
+}
+
+void BehavioralSource::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>& prev_voltages, bool, double) {
+    // Standalone use: node voltages only, no branch currents or time. A voltage source
+    // needs a branch row that only MNAMatrix::build allocates.
+    if (kind == Kind::VOLTAGE) throw std::runtime_error(name + ": behavioural voltage sources are stamped by MNAMatrix::build.");
+    stampLinearized(G, J, node_map, {}, prev_voltages, {}, 0.0, -1);
+}
+
+// --- Transmission Line Implementation ---
+TransmissionLine::TransmissionLine() : Element(), port2_pos(""), port2_neg(""), z0(50.0), delay(1e-9) {}
+
+TransmissionLine::TransmissionLine(const std::string& name, const std::string& p1_pos, const std::string& p1_neg,
+                                   const std::string& p2_pos, const std::string& p2_neg, double z0, double delay)
+    : Element(name, p1_pos, p1_neg), port2_pos(p2_pos), port2_neg(p2_neg), z0(z0), delay(delay) {
+    if (z0 <= 0) throw std::runtime_error("Transmission line impedance must be positive.");
+    if (delay <= 0) throw std::runtime_error("Transmission line delay must be positive.");
+}
+
+std::string TransmissionLine::getType() const { return "TransmissionLine"; }
+double TransmissionLine::getValue() const { return z0; }
+void TransmissionLine::setValue(double value) {
+    if (value <= 0) throw std::runtime_error("Transmission line impedance must be positive.");
+    z0 = value;
+}
+std::string TransmissionLine::getAddCommandString() const {
+    return "T " + name + " " + node1_id + " " + node2_id + " " + port2_pos + " " + port2_neg +
+           " Z0=" + std::to_string(z0) + " TD=" + std::to_string(delay);
+}
+std::string TransmissionLine::getPort2PosId() const { return port2_pos; }
+std::string TransmissionLine::getPort2NegId() const { return port2_neg; }
+double TransmissionLine::getImpedance() const { return z0; }
+double TransmissionLine::getDelay() const { return delay; }
+
+const TransmissionLine::WavePoint& TransmissionLine::historyAt(size_t logical) const {
+    return history[(head + logical) % history.size()];
+}
+
+void TransmissionLine::pushHistory(const WavePoint& point) {
+    if (count == history.size()) {
+        // The oldest point may go once the next one is at or before the earliest future query time
+        if (count >= 2 && historyAt(1).t <= point.t - delay) {
+            history[head] = point;
+            head = (head + 1) % history.size();
+            return;
+        }
+        std::vector<WavePoint> grown(std::max<size_t>(4, history.size() * 2));
+        for (size_t i = 0; i < count; ++i) grown[i] = historyAt(i);
+        history.swap(grown);
+        head = 0;
+    }
+    history[(head + count) % history.size()] = point;
+    ++count;
+}
+
+void TransmissionLine::portVoltages(const std::map<std::string, double>& voltages, double& v1, double& v2) const {
+    auto at = [&voltages](const std::string& id) {
+        auto it = voltages.find(id);
+        return it != voltages.end() ? it->second : 0.0;
+    };
+    v1 = at(node1_id) - at(node2_id);
+    v2 = at(port2_pos) - at(port2_neg);
+}
+
+void TransmissionLine::incidentWaves(double t, double& e1, double& e2) const {
+    const double tq = t - delay;
+    if (count == 0 || tq < historyAt(0).t) {
+        e1 = initial_w2;
+        e2 = initial_w1;
+        return;
+    }
+    // Binary search for the last point at or before tq
+    size_t lo = 0, hi = count - 1;
+    while (lo < hi) {
+        size_t mid = (lo + hi + 1) / 2;
+        if (historyAt(mid).t <= tq) lo = mid; else hi = mid - 1;
+    }
+    const WavePoint& a = historyAt(lo);
+    if (lo + 1 >= count) { // Delay shorter than the step: hold the newest wave
+        e1 = a.w2;
+        e2 = a.w1;
+        return;
+    }
+    const WavePoint& b = historyAt(lo + 1);
+    const double f = (b.t > a.t) ? (tq - a.t) / (b.t - a.t) : 0.0;
+    e1 = a.w2 + f * (b.w2 - a.w2);
+    e2 = a.w1 + f * (b.w1 - a.w1);
+}
+
+void TransmissionLine::beginTransient(double timestep, const std::map<std::string, double>& node_voltages) {
+    double v1, v2;
+    portVoltages(node_voltages, v1, v2);
+    // Operating point current through the DC short, into port 1 and out of port 2
+    auto at = [&node_voltages](const std::string& id) {
+        auto it = node_voltages.find(id);
+        return it != node_voltages.end() ? it->second : 0.0;
+    };
+    const double i1 = DC_CONDUCTANCE * (at(node1_id) - at(port2_pos));
+    initial_w1 = v1 + z0 * i1;
+    initial_w2 = v2 - z0 * i1;
+
+    const size_t capacity = static_cast<size_t>(std::ceil(delay / timestep)) + 4;
+    history.assign(capacity, WavePoint{0.0, 0.0, 0.0});
+    head = 0;
+    count = 0;
+    if (delay < timestep) {
+        ErrorManager::warn("[TLINE] " + name + ": delay " + std::to_string(delay) + "s is shorter than the time step; accuracy is reduced");
+    }
+}
+
+void TransmissionLine::acceptStep(double t, const std::map<std::string, double>& node_voltages) {
+    double v1, v2, e1, e2;
+    portVoltages(node_voltages, v1, v2);
+    incidentWaves(t, e1, e2);
+    // i = (v - E)/Z0, so the outgoing wave v + Z0*i = 2v - E
+    pushHistory(WavePoint{t, 2.0 * v1 - e1, 2.0 * v2 - e2});
+}
+
+// Layout: initial_w1, initial_w2, capacity, then (t, w1, w2) for each point from oldest to newest
+void TransmissionLine::saveTransientState(std::vector<double>& state) const {
+    state.clear();
+    state.reserve(3 + 3 * count);
+    state.push_back(initial_w1);
+    state.push_back(initial_w2);
+    state.push_back(static_cast<double>(history.size()));
+    for (size_t i = 0; i < count; ++i) {
+        const WavePoint& p = historyAt(i);
+        state.push_back(p.t);
+        state.push_back(p.w1);
+        state.push_back(p.w2);
+    }
+}
+
+void TransmissionLine::restoreTransientState(const std::vector<double>& state) {
+    if (state.size() < 3 || (state.size() - 3) % 3 != 0) throw std::runtime_error("Invalid checkpoint state for line " + name + ".");
+    initial_w1 = state[0];
+    initial_w2 = state[1];
+    const size_t points = (state.size() - 3) / 3;
+    history.assign(std::max(static_cast<size_t>(state[2]), points), WavePoint{0.0, 0.0, 0.0});
+    head = 0;
+    count = 0;
+    for (size_t i = 0; i < points; ++i) pushHistory(WavePoint{state[3 + 3 * i], state[4 + 3 * i], state[5 + 3 * i]});
+}
+
+void TransmissionLine::stampCompanion(Matrix& G, Vector& J, const NodeIndexMap& node_map, bool is_transient, double t) const {
+    auto index = [&node_map](const std::string& id) {
+        auto it = node_map.find(id);
+        return it != node_map.end() ? it->second : -1;
+    };
+    auto stampConductance = [&G](int a, int b, double g) {
+        if (a != -1) G[a][a] += g;
+        if (b != -1) G[b][b] += g;
+        if (a != -1 && b != -1) { G[a][b] -= g; G[b][a] -= g; }
+    };
+    const int p1 = index(node1_id), n1 = index(node2_id);
+    const int p2 = index(port2_pos), n2 = index(port2_neg);
+
+    if (!is_transient) {
+        stampConductance(p1, p2, DC_CONDUCTANCE);
+        stampConductance(n1, n2, DC_CONDUCTANCE);
+        return;
+    }
+
+    const double g = 1.0 / z0;
+    double e1, e2;
+    incidentWaves(t, e1, e2);
+    stampConductance(p1, n1, g);
+    stampConductance(p2, n2, g);
+    if (p1 != -1) J[p1] += g * e1;
+    if (n1 != -1) J[n1] -= g * e1;
+    if (p2 != -1) J[p2] += g * e2;
+    if (n2 != -1) J[n2] -= g * e2;
+}
+
+void TransmissionLine::contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool is_transient, double timestep) {
+    // Without the current time, use the step after the newest accepted point
+    double t = (count > 0) ? historyAt(count - 1).t + timestep : timestep;
+    stampCompanion(G, J, node_map, is_transient, t);
+}
+
 // --- Ground Implementation ---
 Ground::Ground() : Element() {}
 
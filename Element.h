@@ -5,33 +5,151 @@
 #include <memory>
 #include <complex>
 #include <cereal/archives/json.hpp>
+#include <cereal/archives/portable_binary.hpp>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/types/string.hpp>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/memory.hpp>
 #include <cereal/types/map.hpp>
+#include "MonotoneSpline.h"
+#include "SampleStream.h"
+#include "SignalProcessor.h"
+#include "SymbolTable.h"
+#include "ObjectPool.h"
 
 // --- Type Aliases ---
 using Matrix = std::vector<std::vector<double>>;
 using Vector = std::vector<double>;
-using NodeIndexMap = std::map<std::string, int>;
 using Complex = std::complex<double>;
 
+// --- NodeIndexMap (Node -> MNA row) ---
+// Rows are held in a flat vector indexed by the circuit's node SymbolId, so a
+// bound element terminal resolves with one array load. The name-keyed view used
+// for lookups by name and iteration in node-name order is only built on first
+// use, so a build that stamps through bound IDs never copies the node names.
+// That first use fills a mutable cache: const access is not thread-safe until then.
+class NodeIndexMap {
+private:
+    mutable std::map<std::string, int> by_name; // Complete only while names_built
+    mutable bool names_built = true;
+    std::vector<int> rows;                      // By SymbolId, -1 when the node has no row
+    const SymbolTable* symbols = nullptr;
+    size_t entry_count = 0;
+
+    const std::map<std::string, int>& names() const {
+        if (!names_built) {
+            for (SymbolId id = 0; id < rows.size(); ++id) {
+                if (rows[id] != -1) by_name[symbols->name(id)] = rows[id];
+            }
+            names_built = true;
+        }
+        return by_name;
+    }
+
+public:
+    using const_iterator = std::map<std::string, int>::const_iterator;
+
+    // Drops all entries; rows set afterwards are also indexed by `table` IDs.
+    void bind(const SymbolTable* table) {
+        clear();
+        symbols = table;
+        if (symbols) rows.assign(symbols->size(), -1);
+    }
+    void set(const std::string& name, int row) {
+        SymbolId id = symbols ? symbols->find(name) : NO_SYMBOL;
+        if (id < rows.size()) {
+            if (rows[id] == -1) ++entry_count;
+            rows[id] = row;
+            if (names_built && !by_name.empty()) by_name[name] = row;
+            else names_built = false;
+        } else {
+            auto result = by_name.emplace(name, row);
+            if (result.second) ++entry_count;
+            else result.first->second = row;
+        }
+    }
+    // O(1) for IDs issued before bind(); otherwise falls back to the name.
+    int row(SymbolId id, const std::string& name) const {
+        if (id < rows.size()) return rows[id];
+        auto it = names().find(name);
+        return (it != by_name.end()) ? it->second : -1;
+    }
+
+    size_t count(const std::string& name) const { return names().count(name); }
+    int at(const std::string& name) const { return names().at(name); }
+    const_iterator find(const std::string& name) const { return names().find(name); }
+    const_iterator begin() const { return names().begin(); }
+    const_iterator end() const { return names().end(); }
+    size_t size() const { return entry_count; }
+    bool empty() const { return entry_count == 0; }
+    void clear() { by_name.clear(); names_built = true; rows.clear(); symbols = nullptr; entry_count = 0; }
+};
+
 // Forward declarations
 class Circuit;
 class TcpSocket;
 
+// --- Device Model Card (.model <name> <type> (PARAM=value ...)) ---
+struct DeviceModelCard {
+    std::string name;
+    std::string type; // D, NMOS, PMOS, NPN, PNP, SW
+    std::map<std::string, double> params; // Upper-case parameter names
+
+    double get(const std::string& key, double default_value) const {
+        auto it = params.find(key);
+        return (it != params.end()) ? it->second : default_value;
+    }
+
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(CEREAL_NVP(name), CEREAL_NVP(type), CEREAL_NVP(params));
+    }
+};
+
+// --- Deferred sample payload ---
+// Location of little-endian F64 samples inside a chunked project file. The
+// file's size and write time are recorded at load so a later read can refuse
+// a file that has been replaced in the meantime.
+struct DeferredSamples {
+    std::string path;
+    uint64_t offset = 0; // Byte offset of the first sample
+    uint64_t count = 0;
+    uint64_t file_size = 0;
+    int64_t file_time = 0;
+
+    std::vector<double> read() const;
+};
+
+// --- ProjectPayloadContext ---
+// Installed by ProjectSerializer around a chunked binary save or load. Elements
+// with bulk sample data archive only a payload index and hand the samples over
+// here, so the topology chunk stays small and the samples can load on demand.
+struct ProjectPayloadContext {
+    std::vector<const std::vector<double>*> outgoing; // Save: samples in payload order
+    std::vector<DeferredSamples> locations;           // Load from a file: read lazily
+    std::vector<std::vector<double>> decoded;         // Load from memory: already read
+
+    // Context of the current thread, null outside ProjectSerializer
+    static ProjectPayloadContext*& active();
+};
+
 // --- Element (Abstract Base) ---
 class Element {
 protected:
     std::string name;
     std::string node1_id;
     std::string node2_id;
+    // Circuit node IDs of node1/node2, set when the element is added to a circuit
+    SymbolId node1_sym = NO_SYMBOL;
+    SymbolId node2_sym = NO_SYMBOL;
     Element();
 
 public:
     Element(const std::string& name, const std::string& node1, const std::string& node2);
     virtual ~Element() = default;
+    // Elements of every type are allocated from ObjectPool (sized delete via the virtual destructor)
+    static void* operator new(std::size_t size) { return ObjectPool::allocate(size); }
+    static void operator delete(void* p, std::size_t size) { ObjectPool::release(p, size); }
     virtual std::string getType() const = 0;
     virtual double getValue() const = 0;
     virtual void setValue(double value) = 0;
@@ -39,11 +157,21 @@ public:
     virtual void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map,
                                  const std::map<std::string, double>& prev_node_voltages,
                                  bool is_transient, double timestep) = 0;
-    std::string getName() const;
-    std::string getNode1Id() const;
-    std::string getNode2Id() const;
+    // Run-time state outside the serialised parameters (switch position, line
+    // history, limiting points), packed into doubles for transient checkpoints.
+    virtual void saveTransientState(std::vector<double>&) const {}
+    virtual void restoreTransientState(const std::vector<double>&) {}
+    const std::string& getName() const;
+    const std::string& getNode1Id() const;
+    const std::string& getNode2Id() const;
     void setNode1Id(const std::string& new_id);
     void setNode2Id(const std::string& new_id);
+    void bindNodeSymbols(SymbolId node1, SymbolId node2);
+    SymbolId getNode1Symbol() const { return node1_sym; }
+    SymbolId getNode2Symbol() const { return node2_sym; }
+    // MNA rows of node1/node2, -1 for ground
+    int node1Row(const NodeIndexMap& node_map) const { return node_map.row(node1_sym, node1_id); }
+    int node2Row(const NodeIndexMap& node_map) const { return node_map.row(node2_sym, node2_id); }
 
     template<class Archive>
     void serialize(Archive& archive) {
@@ -126,6 +254,30 @@ public:
     }
 };
 
+// --- MutualInductance (K element) ---
+// Couples two or more inductors with coefficient k, M_ij = k*sqrt(Li*Lj), dots
+// at node1. It has no terminals of its own: MNAMatrix::build stamps M/dt terms
+// between the branch-current rows of the referenced inductors.
+class MutualInductance : public Element {
+private:
+    std::vector<std::string> inductor_names;
+    double coupling;
+    friend class cereal::access;
+    MutualInductance(); // Default constructor for Cereal
+public:
+    MutualInductance(const std::string& name, const std::vector<std::string>& inductors, double k);
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    const std::vector<std::string>& getInductorNames() const;
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(inductor_names), CEREAL_NVP(coupling));
+    }
+};
+
 class IndependentVoltageSource : public Element {
 private:
     double voltage_value;
@@ -208,6 +360,9 @@ public:
     double getValue() const override;
     void setValue(double value) override;
     void setDCOffset(double new_offset);
+    double getDCOffset() const;
+    double getAmplitude() const;
+    double getFrequency() const;
     std::string getAddCommandString() const override;
     double getVoltageAtTime(double current_time) const;
     void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
@@ -289,21 +444,35 @@ public:
 
 class WaveformVoltageSource : public Element {
 private:
-    std::vector<double> voltage_values;  // Voltage values at each sample
+    mutable std::vector<double> voltage_values;  // Voltage values at each sample
+    mutable std::unique_ptr<DeferredSamples> deferred; // Samples still in the project file
     double sampling_rate;                // Samples per second (Hz)
     double signal_duration;              // Total duration of signal (s)
     double start_time;                   // When the waveform starts (s)
     bool repeat;                         // Whether to repeat the waveform
+    std::string sample_file;             // External binary samples; empty = voltage_values
+    std::string sample_format;           // "F64" or "F32"
+    mutable std::shared_ptr<SampleStream> stream; // Opened lazily, not serialised
     friend class cereal::access;
     WaveformVoltageSource(); // Default constructor for Cereal
+    SampleStream& getStream() const;
+    void ensureSamples() const { if (deferred) loadDeferredSamples(); }
+    void loadDeferredSamples() const;
 public:
     WaveformVoltageSource(const std::string& name, const std::string& node1, const std::string& node2,
                           const std::vector<double>& values, double fs, double duration, double start_time = 0.0, bool repeat = false);
+    // Streams samples from a raw binary file instead of holding them in memory
+    WaveformVoltageSource(const std::string& name, const std::string& node1, const std::string& node2,
+                          const std::string& sample_file, double fs, const std::string& sample_format = "F64",
+                          double start_time = 0.0, bool repeat = false);
     std::string getType() const override;
     double getValue() const override;
     void setValue(double value) override;
     std::string getAddCommandString() const override;
-    double getVoltageAtTime(double time) const;
+    // sim_step > 0 enables band-limited resampling of streamed samples when it is coarser than 1/fs
+    double getVoltageAtTime(double time, double sim_step = 0.0) const;
+    bool isStreamed() const;
+    const std::string& getSampleFile() const;
     const std::vector<double>& getVoltageValues() const;
     double getSamplingRate() const;
     double getSignalDuration() const;
@@ -315,13 +484,53 @@ public:
     void setStartTime(double start_time);
     void setRepeat(bool repeat);
     void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double currentTime) override;
+    bool hasDeferredSamples() const { return deferred != nullptr; }
+
+    // Inside a chunked project the samples travel as a payload index instead of inline.
+    // Version 1 added the streamed sample file; version 0 archives hold inline samples only.
+    // Saving reads deferred samples in first (a const save fills the mutable cache): the
+    // archive being written may replace the very file they would be read from.
     template<class Archive>
-    void serialize(Archive& archive) {
-        archive(cereal::base_class<Element>(this), CEREAL_NVP(voltage_values), CEREAL_NVP(sampling_rate), 
-                CEREAL_NVP(signal_duration), CEREAL_NVP(start_time), CEREAL_NVP(repeat));
+    void save(Archive& archive, std::uint32_t const version) const {
+        archive(cereal::base_class<Element>(this));
+        ensureSamples();
+        if (ProjectPayloadContext* payloads = ProjectPayloadContext::active()) {
+            uint64_t payload = payloads->outgoing.size();
+            payloads->outgoing.push_back(&voltage_values);
+            archive(CEREAL_NVP(payload));
+        } else {
+            archive(CEREAL_NVP(voltage_values));
+        }
+        archive(CEREAL_NVP(sampling_rate), CEREAL_NVP(signal_duration), CEREAL_NVP(start_time), CEREAL_NVP(repeat));
+        if (version >= 1) archive(CEREAL_NVP(sample_file), CEREAL_NVP(sample_format));
+    }
+    template<class Archive>
+    void load(Archive& archive, std::uint32_t const version) {
+        archive(cereal::base_class<Element>(this));
+        deferred.reset();
+        if (ProjectPayloadContext* payloads = ProjectPayloadContext::active()) {
+            uint64_t payload = 0;
+            archive(CEREAL_NVP(payload));
+            if (!payloads->decoded.empty()) {
+                voltage_values = std::move(payloads->decoded.at(payload));
+            } else {
+                voltage_values.clear();
+                deferred = std::make_unique<DeferredSamples>(payloads->locations.at(payload));
+            }
+        } else {
+            archive(CEREAL_NVP(voltage_values));
+        }
+        archive(CEREAL_NVP(sampling_rate), CEREAL_NVP(signal_duration), CEREAL_NVP(start_time), CEREAL_NVP(repeat));
+        sample_file.clear();
+        sample_format = "F64";
+        if (version >= 1) archive(CEREAL_NVP(sample_file), CEREAL_NVP(sample_format));
     }
 };
 
+// Element::serialize is inherited, so pick the split save/load explicitly
+CEREAL_SPECIALIZE_FOR_ALL_ARCHIVES(WaveformVoltageSource, cereal::specialization::member_load_save)
+CEREAL_CLASS_VERSION(WaveformVoltageSource, 1)
+
 class PhaseVoltageSource : public Element {
 private:
     double magnitude;      // Voltage magnitude (V)
@@ -454,6 +663,10 @@ public:
     double getValue() const override;
     void setValue(double value) override;
     std::string getAddCommandString() const override;
+    double getSaturationCurrent() const;
+    double getIdealityFactor() const;
+    double getThermalVoltage() const;
+    void applyModelCard(const DeviceModelCard& model);
     void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
     template<class Archive>
     void serialize(Archive& archive) {
@@ -461,6 +674,252 @@ public:
     }
 };
 
+// --- MOSFET (Level 1 / Shichman-Hodges) ---
+// node1 = drain, node2 = source, gate stored separately. Bulk is tied to source.
+class Mosfet : public Element {
+private:
+    std::string gate_id;
+    std::string model_name;
+    int polarity;           // +1 NMOS, -1 PMOS
+    double kp;              // Transconductance parameter (A/V^2)
+    double vto;             // Threshold voltage (V), positive for enhancement NMOS
+    double lambda;          // Channel-length modulation (1/V)
+    double width, length;   // Channel geometry (m)
+    friend class cereal::access;
+    Mosfet(); // Default constructor for Cereal
+public:
+    Mosfet(const std::string& name, const std::string& drain, const std::string& gate, const std::string& source,
+           const DeviceModelCard& model, double w = 1e-6, double l = 1e-6);
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    std::string getGateId() const;
+    std::string getModelName() const;
+    int getPolarity() const;
+    // Drain current (drain->source) and its analytic partial derivatives at the given terminal voltages
+    void evaluate(double vgs, double vds, double& id, double& gm, double& gds) const;
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(gate_id), CEREAL_NVP(model_name), CEREAL_NVP(polarity),
+                CEREAL_NVP(kp), CEREAL_NVP(vto), CEREAL_NVP(lambda), CEREAL_NVP(width), CEREAL_NVP(length));
+    }
+};
+
+// --- Bipolar Junction Transistor (Ebers-Moll, transport form) ---
+// node1 = collector, node2 = emitter, base stored separately.
+class BipolarTransistor : public Element {
+private:
+    std::string base_id;
+    std::string model_name;
+    int polarity;           // +1 NPN, -1 PNP
+    double saturation_current;
+    double beta_f, beta_r;
+    double thermal_voltage;
+    double last_vbe = 0.0, last_vbc = 0.0; // Limiting state, not serialised
+    friend class cereal::access;
+    BipolarTransistor(); // Default constructor for Cereal
+public:
+    BipolarTransistor(const std::string& name, const std::string& collector, const std::string& base, const std::string& emitter,
+                      const DeviceModelCard& model);
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    std::string getBaseId() const;
+    std::string getModelName() const;
+    void saveTransientState(std::vector<double>& state) const override;
+    void restoreTransientState(const std::vector<double>& state) override;
+    int getPolarity() const;
+    // Collector and base currents with their analytic partial derivatives w.r.t. vbe and vbc
+    void evaluate(double vbe, double vbc, double& ic, double& ib,
+                  double& dic_dvbe, double& dic_dvbc, double& dib_dvbe, double& dib_dvbc) const;
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(base_id), CEREAL_NVP(model_name), CEREAL_NVP(polarity),
+                CEREAL_NVP(saturation_current), CEREAL_NVP(beta_f), CEREAL_NVP(beta_r), CEREAL_NVP(thermal_voltage));
+    }
+};
+
+// --- Table-driven two-terminal device (measured I-V and optional C-V curves) ---
+class TableDevice : public Element {
+private:
+    std::string table_path;
+    std::vector<double> iv_voltage, iv_current;
+    std::vector<double> cv_voltage, cv_capacitance;
+    MonotoneCubicSpline iv_spline; // Rebuilt from the tables, not serialised
+    MonotoneCubicSpline cv_spline;
+    friend class cereal::access;
+    TableDevice(); // Default constructor for Cereal
+    void buildSplines();
+public:
+    TableDevice(const std::string& name, const std::string& node1, const std::string& node2,
+                const std::vector<double>& voltages, const std::vector<double>& currents,
+                const std::vector<double>& cv_voltages = {}, const std::vector<double>& capacitances = {});
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    void setTablePath(const std::string& path);
+    double getCurrent(double v, double& conductance);
+    double getCapacitance(double v);
+    // Reads a two-column CSV (x,y); header and comment lines are skipped.
+    static void loadCSV(const std::string& path, std::vector<double>& xs, std::vector<double>& ys);
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(table_path), CEREAL_NVP(iv_voltage), CEREAL_NVP(iv_current),
+                CEREAL_NVP(cv_voltage), CEREAL_NVP(cv_capacitance));
+    }
+};
+
+// --- Switch (voltage- or time-controlled, on/off resistance) ---
+// Voltage mode: turns on when V(ctrl+, ctrl-) > VT + VH and off when it drops
+// below VT - VH. Time mode: toggles at each listed time, starting from the
+// initial state. The state only changes at accepted time points; the transient
+// engine locates voltage crossings by bisection before toggling.
+class Switch : public Element {
+public:
+    enum class Control { VOLTAGE, TIME };
+private:
+    Control control;
+    std::string ctrl_pos, ctrl_neg;
+    std::vector<double> toggle_times;
+    std::string model_name;
+    double r_on, r_off, v_threshold, v_hysteresis;
+    bool initial_on;
+    // Transient state, not serialised
+    bool is_on = false;
+    size_t next_toggle = 0;
+    friend class cereal::access;
+    Switch(); // Default constructor for Cereal
+    void applyModel(const DeviceModelCard& model);
+public:
+    Switch(const std::string& name, const std::string& node1, const std::string& node2,
+           const std::string& ctrl_pos, const std::string& ctrl_neg, const DeviceModelCard& model, bool initial_on = false);
+    Switch(const std::string& name, const std::string& node1, const std::string& node2,
+           const std::vector<double>& toggle_times, const DeviceModelCard& model, bool initial_on = false);
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    Control getControl() const;
+    std::string getControlPosId() const;
+    std::string getControlNegId() const;
+    bool isOn() const;
+
+    // Restores the initial state (toggle times at or before t = 0 are applied).
+    void resetState();
+    // Whether the switch would change state at these node voltages (voltage mode).
+    bool wantsToggle(const std::map<std::string, double>& node_voltages) const;
+    // Next scheduled toggle strictly after t, or +infinity (time mode).
+    double nextToggleTime(double t) const;
+    void toggle();
+    void saveTransientState(std::vector<double>& state) const override;
+    void restoreTransientState(const std::vector<double>& state) override;
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(control), CEREAL_NVP(ctrl_pos), CEREAL_NVP(ctrl_neg),
+                CEREAL_NVP(toggle_times), CEREAL_NVP(model_name), CEREAL_NVP(r_on), CEREAL_NVP(r_off),
+                CEREAL_NVP(v_threshold), CEREAL_NVP(v_hysteresis), CEREAL_NVP(initial_on));
+    }
+};
+
+// --- Behavioural source (B element) ---
+// Voltage or current given by an expression over V(node), V(a,b), I(branch)
+// and time, e.g. I = 1e-3*tanh(V(a)-V(b)). The expression is compiled once to
+// an ExpressionTape; each build evaluates value and exact partial derivatives
+// at the previous solution and stamps the Newton linearisation. I(branch)
+// refers to voltage-source or inductor currents; voltage-source currents are
+// not kept between solves, so they linearise around zero.
+class BehavioralSource : public Element {
+public:
+    enum class Kind { VOLTAGE, CURRENT };
+private:
+    Kind kind;
+    std::string expression;
+    ExpressionTape tape; // Compiled from expression, not serialised
+    mutable std::vector<double> inputs, gradient;
+    friend class cereal::access;
+    BehavioralSource(); // Default constructor for Cereal
+    void compile();
+public:
+    BehavioralSource(const std::string& name, const std::string& node1, const std::string& node2, Kind kind, const std::string& expression);
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    Kind getKind() const;
+    const std::string& getExpression() const;
+    void setExpression(const std::string& expr);
+    // Node names referenced through V(...)
+    std::vector<std::string> getReferencedNodes() const;
+
+    // branch_row is the source's own current unknown (voltage kind), branch_columns maps
+    // voltage-source/inductor names to their current unknowns.
+    void stampLinearized(Matrix& G, Vector& J, const NodeIndexMap& node_map, const std::map<std::string, int>& branch_columns,
+                         const std::map<std::string, double>& prev_node_voltages, const std::map<std::string, double>& prev_branch_currents,
+                         double t, int branch_row) const;
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(kind), CEREAL_NVP(expression));
+        if (Archive::is_loading::value) compile();
+    }
+};
+
+// --- Lossless transmission line (Branin / method of characteristics) ---
+// Port 1 is node1/node2, port 2 is port2_pos/port2_neg. Each port is a Norton
+// companion 1/Z0 in parallel with a source driven by the wave that left the
+// other port Td earlier: E1(t) = v2(t-Td) + Z0*i2(t-Td), E2(t) = v1(t-Td) + Z0*i1(t-Td).
+// Accepted port waves go into a ring buffer sized for Td/dt points and are
+// linearly interpolated at t-Td. In DC the line is a short between the ports.
+class TransmissionLine : public Element {
+private:
+    struct WavePoint { double t, w1, w2; };
+    std::string port2_pos, port2_neg;
+    double z0, delay;
+    // Transient state, not serialised
+    std::vector<WavePoint> history; // Ring buffer ordered from head
+    size_t head = 0, count = 0;
+    double initial_w1 = 0.0, initial_w2 = 0.0;
+    friend class cereal::access;
+    TransmissionLine(); // Default constructor for Cereal
+    const WavePoint& historyAt(size_t logical) const;
+    void pushHistory(const WavePoint& point);
+    void incidentWaves(double t, double& e1, double& e2) const;
+    void portVoltages(const std::map<std::string, double>& voltages, double& v1, double& v2) const;
+public:
+    static constexpr double DC_CONDUCTANCE = 1e6; // Port-to-port short used for DC
+
+    TransmissionLine(const std::string& name, const std::string& p1_pos, const std::string& p1_neg,
+                     const std::string& p2_pos, const std::string& p2_neg, double z0, double delay);
+    std::string getType() const override;
+    double getValue() const override;
+    void setValue(double value) override;
+    std::string getAddCommandString() const override;
+    std::string getPort2PosId() const;
+    std::string getPort2NegId() const;
+    double getImpedance() const;
+    double getDelay() const;
+
+    // Seeds the history from the operating point and sizes the buffer for the step.
+    void beginTransient(double timestep, const std::map<std::string, double>& node_voltages);
+    // Records the port waves of an accepted time point.
+    void acceptStep(double t, const std::map<std::string, double>& node_voltages);
+    void saveTransientState(std::vector<double>& state) const override;
+    void restoreTransientState(const std::vector<double>& state) override;
+    void stampCompanion(Matrix& G, Vector& J, const NodeIndexMap& node_map, bool is_transient, double t) const;
+    void contributeToMNA(Matrix& G, Vector& J, int num_nodes, const NodeIndexMap& node_map, const std::map<std::string, double>&, bool, double) override;
+    template<class Archive>
+    void serialize(Archive& archive) {
+        archive(cereal::base_class<Element>(this), CEREAL_NVP(port2_pos), CEREAL_NVP(port2_neg), CEREAL_NVP(z0), CEREAL_NVP(delay));
+    }
+};
+
 class Ground : public Element {
 private:
     friend class cereal::access;
@@ -0,0 +1,295 @@
+#include "ExponentialIntegrator.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace {
+Matrix identity(size_t n) {
+    Matrix I(n, Vector(n, 0.0));
+    for (size_t i = 0; i < n; ++i) I[i][i] = 1.0;
+    return I;
+}
+
+Matrix multiply(const Matrix& A, const Matrix& B) {
+    const size_t rows = A.size(), inner = B.size(), cols = B.empty() ? 0 : B[0].size();
+    Matrix out(rows, Vector(cols, 0.0));
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t k = 0; k < inner; ++k) {
+            const double a = A[i][k];
+            if (a == 0.0) continue;
+            const Vector& row = B[k];
+            Vector& target = out[i];
+            for (size_t j = 0; j < cols; ++j) target[j] += a * row[j];
+        }
+    }
+    return out;
+}
+
+Matrix transpose(const Matrix& A, size_t rows, size_t cols) {
+    Matrix out(cols, Vector(rows, 0.0));
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < cols; ++j) out[j][i] = A[i][j];
+    }
+    return out;
+}
+
+Vector apply(const Matrix& A, const Vector& x) {
+    Vector out(A.size(), 0.0);
+    for (size_t i = 0; i < A.size(); ++i) {
+        double sum = 0.0;
+        for (size_t j = 0; j < x.size(); ++j) sum += A[i][j] * x[j];
+        out[i] = sum;
+    }
+    return out;
+}
+
+double norm1(const Matrix& A) {
+    if (A.empty()) return 0.0;
+    Vector column_sums(A[0].size(), 0.0);
+    for (const auto& row : A) {
+        for (size_t j = 0; j < row.size(); ++j) column_sums[j] += std::abs(row[j]);
+    }
+    return *std::max_element(column_sums.begin(), column_sums.end());
+}
+
+// F^{-1} B, one solve per column of B (cols wide)
+Matrix solveColumns(const LUFactors& factors, const Matrix& B, size_t cols) {
+    Matrix out(B.size(), Vector(cols, 0.0));
+    Vector column(B.size());
+    for (size_t j = 0; j < cols; ++j) {
+        for (size_t i = 0; i < B.size(); ++i) column[i] = B[i][j];
+        Vector x = factors.solve(column);
+        for (size_t i = 0; i < B.size(); ++i) out[i][j] = x[i];
+    }
+    return out;
+}
+
+size_t findRoot(std::vector<size_t>& parent, size_t i) {
+    while (parent[i] != i) i = parent[i] = parent[parent[i]];
+    return i;
+}
+}
+
+// --- ExponentialIntegrator Implementation ---
+ExponentialIntegrator::ExponentialIntegrator(const Matrix& C, const Matrix& G, size_t max_propagators)
+    : n(C.size()), max_propagators(std::max<size_t>(1, max_propagators)) {
+    if (G.size() != n) throw std::runtime_error("Descriptor matrices have different sizes.");
+
+    // Capacitor groups and inductor groups never share entries of C; each connected
+    // block is decomposed on its own so its rank test is relative to its own scale
+    std::vector<size_t> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<bool> dynamic(n, false);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (C[i][j] == 0.0) continue;
+            dynamic[i] = dynamic[j] = true;
+            parent[findRoot(parent, i)] = findRoot(parent, j);
+        }
+    }
+    std::map<size_t, std::vector<size_t>> blocks;
+    for (size_t i = 0; i < n; ++i) {
+        if (dynamic[i]) blocks[findRoot(parent, i)].push_back(i);
+    }
+
+    std::vector<Vector> d_columns, a_columns; // Basis vectors of length n
+    Vector lambda;
+    for (size_t i = 0; i < n; ++i) {
+        if (dynamic[i]) continue;
+        a_columns.emplace_back(n, 0.0);
+        a_columns.back()[i] = 1.0;
+    }
+    for (const auto& block : blocks) {
+        const std::vector<size_t>& index = block.second;
+        const size_t m = index.size();
+        Matrix S(m, Vector(m, 0.0));
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < m; ++j) S[i][j] = 0.5 * (C[index[i]][index[j]] + C[index[j]][index[i]]);
+        }
+        Vector w;
+        Matrix Q;
+        symmetricEigen(S, w, Q);
+        double scale = 0.0;
+        for (double value : w) scale = std::max(scale, std::abs(value));
+        for (size_t k = 0; k < m; ++k) {
+            Vector column(n, 0.0);
+            for (size_t i = 0; i < m; ++i) column[index[i]] = Q[i][k];
+            if (std::abs(w[k]) > 1e-11 * scale) {
+                d_columns.push_back(std::move(column));
+                lambda.push_back(w[k]);
+            } else {
+                a_columns.push_back(std::move(column)); // Floating capacitor groups
+            }
+        }
+    }
+    r = d_columns.size();
+    const size_t a = a_columns.size();
+
+    V_d = transpose(d_columns, r, n);
+    Matrix V_a = transpose(a_columns, a, n);
+    Matrix Vd_T = d_columns;
+    Matrix Va_T = a_columns;
+
+    Matrix G_Vd = multiply(G, V_d), G_Va = multiply(G, V_a);
+    Matrix G_dd = multiply(Vd_T, G_Vd), G_da = multiply(Vd_T, G_Va);
+    Matrix G_ad = multiply(Va_T, G_Vd), G_aa = multiply(Va_T, G_Va);
+
+    // Algebraic coordinates: y_a = G_aa^{-1} (Va^T b - G_ad y)
+    Matrix X(a, Vector(r, 0.0)), Y(a, Vector(n, 0.0));
+    if (a > 0) {
+        LUFactors aa_factors;
+        try {
+            aa_factors = LUFactors::factor(G_aa);
+        } catch (const std::runtime_error&) {
+            throw std::runtime_error("Circuit is not index-1 (capacitor/voltage-source loop or inductor cutset); "
+                                     "exponential integration needs the algebraic part to be solvable.");
+        }
+        X = solveColumns(aa_factors, G_ad, r);
+        Y = solveColumns(aa_factors, Va_T, n);
+    }
+
+    // y' = -Lambda^{-1} (G_dd - G_da X) y + Lambda^{-1} (Vd^T - G_da Y) b
+    Matrix G_da_X = multiply(G_da, X), G_da_Y = multiply(G_da, Y);
+    M.assign(r, Vector(r, 0.0));
+    K.assign(r, Vector(n, 0.0));
+    for (size_t i = 0; i < r; ++i) {
+        for (size_t j = 0; j < r; ++j) M[i][j] = -(G_dd[i][j] - G_da_X[i][j]) / lambda[i];
+        for (size_t j = 0; j < n; ++j) K[i][j] = (Vd_T[i][j] - G_da_Y[i][j]) / lambda[i];
+    }
+
+    Matrix Va_X = multiply(V_a, X);
+    R_y.assign(n, Vector(r, 0.0));
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < r; ++j) R_y[i][j] = V_d[i][j] - Va_X[i][j];
+    }
+    R_b = (a > 0) ? multiply(V_a, Y) : Matrix(n, Vector(n, 0.0));
+}
+
+const ExponentialIntegrator::Propagator& ExponentialIntegrator::propagator(double h) {
+    auto it = propagators.find(h);
+    if (it != propagators.end()) return it->second;
+    if (propagators.size() >= max_propagators) propagators.clear();
+
+    // exp([[hM, I, 0], [0, 0, I], [0, 0, 0]]) = [[e^{hM}, phi1(hM), phi2(hM)], ...]
+    Matrix W(3 * r, Vector(3 * r, 0.0));
+    for (size_t i = 0; i < r; ++i) {
+        for (size_t j = 0; j < r; ++j) W[i][j] = h * M[i][j];
+        W[i][r + i] = 1.0;
+        W[r + i][2 * r + i] = 1.0;
+    }
+    Matrix F = expm(W);
+
+    Propagator p;
+    p.E.assign(r, Vector(r, 0.0));
+    Matrix phi_diff(r, Vector(r, 0.0)), phi2(r, Vector(r, 0.0));
+    for (size_t i = 0; i < r; ++i) {
+        for (size_t j = 0; j < r; ++j) {
+            p.E[i][j] = F[i][j];
+            phi_diff[i][j] = h * (F[i][r + j] - F[i][2 * r + j]);
+            phi2[i][j] = h * F[i][2 * r + j];
+        }
+    }
+    p.P0 = multiply(phi_diff, K);
+    p.P1 = multiply(phi2, K);
+    return propagators.emplace(h, std::move(p)).first->second;
+}
+
+Vector ExponentialIntegrator::reduce(const Vector& x) const {
+    Vector y(r, 0.0);
+    for (size_t j = 0; j < r; ++j) {
+        for (size_t i = 0; i < n; ++i) y[j] += V_d[i][j] * x[i];
+    }
+    return y;
+}
+
+Vector ExponentialIntegrator::expand(const Vector& y, const Vector& b) const {
+    Vector x = apply(R_b, b);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < r; ++j) x[i] += R_y[i][j] * y[j];
+    }
+    return x;
+}
+
+Vector ExponentialIntegrator::step(const Vector& y, double h, const Vector& b0, const Vector& b1) {
+    if (r == 0) return y;
+    const Propagator& p = propagator(h);
+    Vector next = apply(p.E, y);
+    Vector from_b0 = apply(p.P0, b0), from_b1 = apply(p.P1, b1);
+    for (size_t i = 0; i < r; ++i) next[i] += from_b0[i] + from_b1[i];
+    return next;
+}
+
+Matrix ExponentialIntegrator::expm(const Matrix& A) {
+    const size_t m = A.size();
+    if (m == 0) return {};
+    // Scale to ||A||_1 <= 1/2, where the [6/6] Pade approximant is accurate to double precision
+    const double norm = norm1(A);
+    const int squarings = (norm > 0.5) ? static_cast<int>(std::ceil(std::log2(norm / 0.5))) : 0;
+    const double scale = std::ldexp(1.0, -squarings);
+    Matrix X = A;
+    for (auto& row : X) {
+        for (double& value : row) value *= scale;
+    }
+
+    const int q = 6;
+    Matrix N = identity(m), D = identity(m), power = identity(m);
+    double c = 1.0;
+    for (int k = 1; k <= q; ++k) {
+        c *= static_cast<double>(q - k + 1) / (k * (2 * q - k + 1));
+        power = multiply(power, X);
+        const double sign = (k % 2 == 0) ? 1.0 : -1.0;
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = 0; j < m; ++j) {
+                N[i][j] += c * power[i][j];
+                D[i][j] += sign * c * power[i][j];
+            }
+        }
+    }
+    Matrix F = solveColumns(LUFactors::factor(D), N, m);
+    for (int s = 0; s < squarings; ++s) F = multiply(F, F);
+    return F;
+}
+
+// Cyclic Jacobi rotations; eigenvectors are the columns of `eigenvectors`
+void ExponentialIntegrator::symmetricEigen(const Matrix& S, Vector& eigenvalues, Matrix& eigenvectors) {
+    const size_t m = S.size();
+    Matrix A = S;
+    eigenvectors = identity(m);
+    double total = 0.0;
+    for (const auto& row : A) {
+        for (double value : row) total += value * value;
+    }
+    for (int sweep = 0; sweep < 100; ++sweep) {
+        double off = 0.0;
+        for (size_t p = 0; p < m; ++p) {
+            for (size_t q = p + 1; q < m; ++q) off += A[p][q] * A[p][q];
+        }
+        if (off <= 1e-30 * total) break;
+        for (size_t p = 0; p < m; ++p) {
+            for (size_t q = p + 1; q < m; ++q) {
+                if (A[p][q] == 0.0) continue;
+                const double theta = (A[q][q] - A[p][p]) / (2.0 * A[p][q]);
+                const double t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                const double c = 1.0 / std::sqrt(t * t + 1.0), s = t * c;
+                for (size_t k = 0; k < m; ++k) {
+                    const double akp = A[k][p], akq = A[k][q];
+                    A[k][p] = c * akp - s * akq;
+                    A[k][q] = s * akp + c * akq;
+                }
+                for (size_t k = 0; k < m; ++k) {
+                    const double apk = A[p][k], aqk = A[q][k];
+                    A[p][k] = c * apk - s * aqk;
+                    A[q][k] = s * apk + c * aqk;
+                }
+                for (size_t k = 0; k < m; ++k) {
+                    const double vkp = eigenvectors[k][p], vkq = eigenvectors[k][q];
+                    eigenvectors[k][p] = c * vkp - s * vkq;
+                    eigenvectors[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    eigenvalues.resize(m);
+    for (size_t i = 0; i < m; ++i) eigenvalues[i] = A[i][i];
+}
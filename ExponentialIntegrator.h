@@ -0,0 +1,53 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "Solvers.h"
+
+// --- ExponentialIntegrator (Exact stepping of linear time-invariant circuits) ---
+// Works on the descriptor system C x' + G x = b(t) behind the MNA stamps. The
+// transient build is A(h) = G + C/h with history (C/h) x_prev on the right-hand
+// side, so C and G come from two builds at different steps and b(t) from a build
+// with zero history. C is symmetric (capacitor Laplacian, inductance block), so
+// its eigenvectors split x into differential coordinates y (range of C) and
+// algebraic ones, which are eliminated through the index-1 constraint:
+//     y' = M y + K b(t),    x = R_y y + R_b b(t)
+// Over a step with b linear in time the solution is exact:
+//     y(h) = e^{hM} y(0) + h (phi1 - phi2)(hM) K b(0) + h phi2(hM) K b(h)
+// The three operators come from one exponential of a 3r x 3r block matrix
+// (Pade 6 with scaling and squaring) and are cached per step length.
+class ExponentialIntegrator {
+private:
+    struct Propagator {
+        Matrix E;  // e^{hM}
+        Matrix P0; // h (phi1 - phi2)(hM) K
+        Matrix P1; // h phi2(hM) K
+    };
+
+    size_t n = 0, r = 0;
+    Matrix V_d;                // n x r differential basis, columns orthonormal
+    Matrix M, K;               // r x r, r x n
+    Matrix R_y, R_b;           // n x r, n x n
+    std::map<double, Propagator> propagators;
+    size_t max_propagators;
+
+    const Propagator& propagator(double h);
+
+public:
+    // Throws std::runtime_error when the system is not index-1 (for example a voltage
+    // source directly across a capacitor), so the caller can fall back to companion models.
+    ExponentialIntegrator(const Matrix& C, const Matrix& G, size_t max_propagators = 64);
+
+    size_t size() const { return n; }
+    size_t order() const { return r; }              // Number of dynamic states
+    size_t cachedSteps() const { return propagators.size(); }
+
+    Vector reduce(const Vector& x) const;           // Differential coordinates of x
+    Vector expand(const Vector& y, const Vector& b) const; // Full MNA solution, algebraic part consistent with b
+    // Advances y by h with b linear between b0 (start) and b1 (end).
+    Vector step(const Vector& y, double h, const Vector& b0, const Vector& b1);
+
+    // Dense helpers
+    static Matrix expm(const Matrix& A);
+    static void symmetricEigen(const Matrix& S, Vector& eigenvalues, Matrix& eigenvectors);
+};
@@ -13,8 +13,10 @@
 #include <utility>
 #include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <iomanip>
 #include <sstream>
+#include <chrono>
 #include <fstream>
 
 #ifndef M_PI
@@ -1569,6 +1571,26 @@ void PlotView::renderCursors(SDL_Renderer* renderer) {
 }
 
 // --- ComponentEditDialog Implementation ---
+namespace {
+// Shortest form that reads back as the same double; std::to_string's %f would show
+// 10nF or 1uH as 0.000000
+std::string formatEditValue(double value) {
+    std::ostringstream ss;
+    for (int precision = 15; precision <= 17; ++precision) {
+        ss.str("");
+        ss << std::setprecision(precision) << value;
+        if (std::strtod(ss.str().c_str(), nullptr) == value) break;
+    }
+    return ss.str();
+}
+
+// Value edits that the AC and DC sweeps can retune in place
+bool isLiveTunable(const Element& element) {
+    const std::string& type = element.getType();
+    return type == "Resistor" || type == "Capacitor" || type == "Inductor";
+}
+}
+
 ComponentEditDialog::ComponentEditDialog(int x, int y, int w, int h, TTF_Font* font, std::function<void()> on_apply, std::function<void()> on_cancel)
     : font(font), on_apply_callback(std::move(on_apply)), on_cancel_callback(std::move(on_cancel)) {
     dialog_rect = {x, y, w, h};
@@ -1657,7 +1679,8 @@ void ComponentEditDialog::setTargetElement(Element* element) {
         } else {
             // Generic single-value input for other components
             dialog_rect.h = 150;
-            current_value = std::to_string(element->getValue());
+            original_value = element->getValue();
+            current_value = formatEditValue(element->getValue());
             if (value_input) {
                 value_input->setText(current_value);
             }
@@ -1674,12 +1697,45 @@ void ComponentEditDialog::hide() {
     target_element = nullptr;
 }
 
+void ComponentEditDialog::applyLiveValue(double value) {
+    if (!target_element || value == target_element->getValue()) return;
+    target_element->setValue(value);
+    if (on_live_edit_callback) on_live_edit_callback(target_element);
+}
+
 void ComponentEditDialog::handleEvent(const SDL_Event& event) {
     if (!is_visible) return;
     
     // Handle value input for simple components
     if (value_input) {
         value_input->handleEvent(event);
+        if (target_element && param_inputs.empty() && isLiveTunable(*target_element)) {
+            if (event.type == SDL_TEXTINPUT || event.type == SDL_KEYDOWN) {
+                // Partial input ("4.", "1e") simply does not parse yet, and "0" on the way
+                // to "0.5" is not a resistance, capacitance or inductance
+                const std::string text = value_input->getText();
+                size_t used = 0;
+                double value = 0.0;
+                try {
+                    value = std::stod(text, &used);
+                } catch (const std::logic_error&) {
+                    used = 0;
+                }
+                if (used != 0 && used == text.size() && value > 0.0 && std::isfinite(value)) applyLiveValue(value);
+            } else if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0) {
+                // Scrolling over the dialog scales the value by 5% per notch; the wheel
+                // elsewhere belongs to the schematic and plot views
+                SDL_Point mouse;
+                SDL_GetMouseState(&mouse.x, &mouse.y);
+                if (SDL_PointInRect(&mouse, &dialog_rect)) {
+                    const double value = target_element->getValue() * std::pow(1.05, event.wheel.y);
+                    if (value > 0.0 && std::isfinite(value)) {
+                        value_input->setText(formatEditValue(value));
+                        applyLiveValue(value);
+                    }
+                }
+            }
+        }
     }
     
     // Handle parameter inputs for complex components
@@ -1749,6 +1805,7 @@ void ComponentEditDialog::handleEvent(const SDL_Event& event) {
         // Check Cancel button
         SDL_Rect cancel_btn = {dialog_rect.x + 100, dialog_rect.y + dialog_rect.h - 40, 80, 30};
         if (mx >= cancel_btn.x && mx <= cancel_btn.x + cancel_btn.w && my >= cancel_btn.y && my <= cancel_btn.y + cancel_btn.h) {
+            if (param_inputs.empty()) applyLiveValue(original_value); // Undo live edits
             if (on_cancel_callback) on_cancel_callback();
             hide();
             return;
@@ -1756,6 +1813,7 @@ void ComponentEditDialog::handleEvent(const SDL_Event& event) {
     }
     
     if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
+        if (param_inputs.empty()) applyLiveValue(original_value);
         hide();
     }
 }
@@ -2059,6 +2117,7 @@ void GuiApplication::initialize() {
         [this]() { 
             std::cout << "Component edit cancelled" << std::endl; 
         });
+    edit_dlg->setOnLiveEdit([this](Element* element) { this->onLiveValueEdit(element); });
     edit_dialog = edit_dlg.get();
     ui_elements.push_back(std::move(edit_dlg));
     
@@ -2079,11 +2138,7 @@ void GuiApplication::initialize() {
     ui_elements.push_back(std::make_unique<ActionButton>(current_x, button_y, button_width, button_height, "Undo", font, [this]() {
         if (!undo_stack.empty()) {
             try {
-                const std::string path = "__redo_snapshot.json";
-                ProjectSerializer::save(*circuit, path);
-                std::ifstream ifs(path, std::ios::in | std::ios::binary);
-                std::stringstream buffer; buffer << ifs.rdbuf();
-                redo_stack.push_back(buffer.str());
+                redo_stack.push_back(ProjectSerializer::saveToString(*circuit));
             } catch (...) {}
             auto snap = undo_stack.back(); undo_stack.pop_back();
             applySnapshot(snap);
@@ -2485,6 +2540,7 @@ void GuiApplication::cleanup() {
 }
 
 void GuiApplication::onRunSimulationClicked() {
+    stopLiveTuning();
     MNAMatrix mna;
     LUDecompositionSolver solver;
     TransientAnalysis tran(settings_panel->getTranTStep(), settings_panel->getTranTStop());
@@ -2515,7 +2571,7 @@ void GuiApplication::onRunSimulationClicked() {
             std::cout << ss.str() << std::endl; logLine(ss.str()); ErrorManager::info(ss.str());
         }
         try {
-            tran.analyze(*circuit, mna, solver);
+            if (result_cache.analyze(tran, *circuit, mna, solver)) logLine("[TRAN] unchanged circuit, reused cached results");
         } catch (const std::exception& ex) {
             std::stringstream ss; ss << "[TRAN] exception: " << ex.what();
             std::cout << ss.str() << std::endl; logLine(ss.str());
@@ -2608,9 +2664,10 @@ void GuiApplication::onRunSimulationClicked() {
 }
 
 void GuiApplication::onRunACAnalysisClicked() {
+    stopLiveTuning();
     MNAMatrix mna;
     LUDecompositionSolver solver;
-    ACSweepAnalysis ac(settings_panel->getACSource(), settings_panel->getACStartFreq(), settings_panel->getACStopFreq(), settings_panel->getACPoints(), "DEC");
+    auto ac = std::make_unique<ACSweepAnalysis>(settings_panel->getACSource(), settings_panel->getACStartFreq(), settings_panel->getACStopFreq(), settings_panel->getACPoints(), "DEC");
     try {
         if (!circuit->checkGroundNodeExists()) throw std::runtime_error("No ground node set.");
         if (!circuit->checkConnectivity()) throw std::runtime_error("Circuit not fully connected.");
@@ -2629,16 +2686,17 @@ void GuiApplication::onRunACAnalysisClicked() {
             ErrorManager::info("[AC] No AC sources found - add ACVoltageSource for frequency analysis");
         }
 
-        ac.analyze(*circuit, mna, solver);
+        result_cache.analyze(*ac, *circuit, mna, solver);
 
         for (auto& el : ui_elements) {
             if (auto* plot = dynamic_cast<PlotView*>(el.get())) {
-                plot->setDataAC(ac.getFrequencyPoints(), ac.getComplexResults());
+                plot->setDataAC(ac->getFrequencyPoints(), ac->getComplexResults());
                 break;
             }
         }
         
-        ErrorManager::info("[AC] Analysis complete: " + std::to_string(ac.getFrequencyPoints().size()) + " frequency points");
+        ErrorManager::info("[AC] Analysis complete: " + std::to_string(ac->getFrequencyPoints().size()) + " frequency points");
+        live_ac = std::move(ac); // Value edits now refresh this plot
 
     } catch (const std::exception& e) {
         ErrorManager::displayError("AC Simulation failed: " + std::string(e.what()));
@@ -2646,14 +2704,28 @@ void GuiApplication::onRunACAnalysisClicked() {
 }
 
 void GuiApplication::onRunPhaseAnalysisClicked() {
+    stopLiveTuning();
     MNAMatrix mna;
     LUDecompositionSolver solver;
-    PhaseSweepAnalysis phase("V1", 0, 360, 1e3, 100);
     try {
         if (!circuit->checkGroundNodeExists()) throw std::runtime_error("No ground node set.");
         if (!circuit->checkConnectivity()) throw std::runtime_error("Circuit not fully connected.");
 
-        phase.analyze(*circuit, mna, solver);
+        // Sweep the source named in the settings panel, else the first phase source
+        const Element* source = circuit->getElement(settings_panel->getACSource());
+        if (!source || source->getType() != "PhaseVoltageSource") {
+            for (const auto& elem : circuit->getElements()) {
+                if (elem->getType() == "PhaseVoltageSource") { source = elem.get(); break; }
+            }
+        }
+        if (!source) throw std::runtime_error("No source to sweep: set the AC source or add a phase source.");
+        double base_freq_hz = 1e3;
+        if (source->getType() == "PhaseVoltageSource") {
+            base_freq_hz = static_cast<const PhaseVoltageSource*>(source)->getBaseFrequency() / (2 * M_PI); // Stored in rad/s
+        }
+
+        PhaseSweepAnalysis phase(source->getName(), 0, 360, base_freq_hz, 100);
+        result_cache.analyze(phase, *circuit, mna, solver);
 
         for (auto& el : ui_elements) {
             if (auto* plot = dynamic_cast<PlotView*>(el.get())) {
@@ -2668,46 +2740,88 @@ void GuiApplication::onRunPhaseAnalysisClicked() {
 }
 
 void GuiApplication::onRunDCSweepClicked() {
+    stopLiveTuning();
     MNAMatrix mna;
     LUDecompositionSolver solver;
-    DCSweepAnalysis dc(settings_panel->getACSource(), 0.0, 10.0, 0.1);
+    auto dc = std::make_unique<DCSweepAnalysis>(settings_panel->getACSource(), 0.0, 10.0, 0.1);
     try {
         if (!circuit->checkGroundNodeExists()) throw std::runtime_error("No ground node set.");
         if (!circuit->checkConnectivity()) throw std::runtime_error("Circuit not fully connected.");
 
-        dc.analyze(*circuit, mna, solver);
+        result_cache.analyze(*dc, *circuit, mna, solver);
 
         for (auto& el : ui_elements) {
             if (auto* plot = dynamic_cast<PlotView*>(el.get())) {
                 // Convert DC sweep results to plot format
                 std::map<std::string, std::vector<double>> plot_results;
-                const auto& dc_results = dc.getResults();
+                const auto& dc_results = dc->getResults();
                 for (const auto& pair : dc_results) {
                     plot_results[pair.first] = pair.second;
                 }
-                plot->setData(dc.getSweepValues(), plot_results);
+                plot->setData(dc->getSweepValues(), plot_results);
                 break;
             }
         }
+        live_dc = std::move(dc); // Value edits now refresh this plot
 
     } catch (const std::exception& e) {
         ErrorManager::displayError("DC Sweep Simulation failed: " + std::string(e.what()));
     }
 }
 
+void GuiApplication::onLiveValueEdit(Element* element) {
+    if (!element || (!live_ac && !live_dc)) return;
+    const auto started = std::chrono::steady_clock::now();
+    try {
+        // The first edit factors once; later edits are low-rank updates of that factorisation.
+        // Edits the updaters cannot express fall back to a full run.
+        LUDecompositionSolver solver;
+        if (live_ac) {
+            if (!live_ac->isLiveTuning()) live_ac->startLiveTuning(*circuit);
+            if (!live_ac->retune(*circuit, *element)) live_ac->analyze(*circuit, live_mna, solver);
+        } else {
+            if (!live_dc->isLiveTuning()) {
+                try {
+                    live_dc->startLiveTuning(*circuit, live_mna);
+                } catch (const std::runtime_error& e) {
+                    ErrorManager::info("[LIVE] " + std::string(e.what()) + "; re-running the sweep on each edit");
+                }
+            }
+            if (!live_dc->isLiveTuning() || !live_dc->retune(*circuit, live_mna, *element)) live_dc->analyze(*circuit, live_mna, solver);
+        }
+
+        for (auto& el : ui_elements) {
+            if (auto* plot = dynamic_cast<PlotView*>(el.get())) {
+                if (live_ac) plot->setDataAC(live_ac->getFrequencyPoints(), live_ac->getComplexResults());
+                else plot->setData(live_dc->getSweepValues(), live_dc->getResults());
+                break;
+            }
+        }
+        const double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        std::stringstream ss;
+        ss << "[LIVE] " << element->getName() << " = " << element->getValue() << ", refreshed in " << std::fixed << std::setprecision(0) << elapsed_us << " us";
+        ErrorManager::info(ss.str());
+    } catch (const std::exception& e) {
+        ErrorManager::warn("[LIVE] " + std::string(e.what()));
+    }
+}
+
 void GuiApplication::onSaveProjectClicked() {
     try {
-        ProjectSerializer::save(*circuit, "circuit.json");
-        std::cout << "Project saved to circuit.json" << std::endl;
+        ProjectSerializer::save(*circuit, "circuit.proj");
+        std::cout << "Project saved to circuit.proj" << std::endl;
     } catch (const std::exception& e) {
         ErrorManager::displayError("Failed to save project: " + std::string(e.what()));
     }
 }
 
 void GuiApplication::onLoadProjectClicked() {
+    stopLiveTuning();
     try {
-        ProjectSerializer::load(*circuit, "circuit.json");
-        std::cout << "Project loaded from circuit.json" << std::endl;
+        // Projects saved before the binary format still load from circuit.json
+        const std::string path = std::ifstream("circuit.proj").good() ? "circuit.proj" : "circuit.json";
+        ProjectSerializer::load(*circuit, path);
+        std::cout << "Project loaded from " << path << std::endl;
     } catch (const std::exception& e) {
         ErrorManager::displayError("Failed to load project: " + std::string(e.what()));
     }
@@ -2875,25 +2989,20 @@ void GuiApplication::resetPlacementState() {
 }
 
 void GuiApplication::pushUndoSnapshot() {
+    stopLiveTuning(); // Structural edits invalidate the kept factorisation
     try {
-        // Serialize circuit to JSON string snapshot
-        const std::string path = "__undo_snapshot.json";
-        ProjectSerializer::save(*circuit, path);
-        // Read file back into string
-        std::ifstream ifs(path, std::ios::in | std::ios::binary);
-        std::stringstream buffer; buffer << ifs.rdbuf();
-        undo_stack.push_back(buffer.str());
+        // Serialize circuit to an in-memory binary snapshot. Snapshots stand alone, so
+        // the first one after a project load reads any deferred waveform samples: a
+        // later save may overwrite the file they are still sitting in.
+        undo_stack.push_back(ProjectSerializer::saveToString(*circuit));
         redo_stack.clear();
     } catch (...) {}
 }
 
 void GuiApplication::applySnapshot(const std::string& snapshot) {
+    stopLiveTuning();
     try {
-        const std::string path = "__apply_snapshot.json";
-        std::ofstream ofs(path, std::ios::out | std::ios::binary);
-        ofs << snapshot;
-        ofs.close();
-        ProjectSerializer::load(*circuit, path);
+        ProjectSerializer::loadFromString(*circuit, snapshot);
         if (schematic_view) {
             schematic_view->clearWires();
             schematic_view->updatePinPositions();
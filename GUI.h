@@ -9,6 +9,7 @@
 #include <set>
 #include "Circuit.h"
 #include "Analyzers.h"
+#include "ResultCache.h"
 #include "Pin.h"
 #include "Wire.h"
 #include "PlotCursor.h"
@@ -230,10 +231,15 @@ private:
     std::vector<std::string> param_labels;
     std::function<void()> on_apply_callback;
     std::function<void()> on_cancel_callback;
+    // Live tuning: single-value edits are applied as they are typed or scrolled
+    std::function<void(Element*)> on_live_edit_callback;
+    double original_value = 0.0;
+    void applyLiveValue(double value);
     
 public:
     ComponentEditDialog(int x, int y, int w, int h, TTF_Font* font, 
                        std::function<void()> on_apply, std::function<void()> on_cancel);
+    void setOnLiveEdit(std::function<void(Element*)> callback) { on_live_edit_callback = std::move(callback); }
     void setTargetElement(Element* element);
     void show();
     void hide();
@@ -298,6 +304,11 @@ private:
     // Latest analysis data for probes
     std::vector<double> latest_time_points;
     std::map<std::string, std::vector<double>> latest_tran_results;
+    ResultCache result_cache; // Reruns of an unchanged circuit reuse earlier results
+    // Last AC or DC run, refreshed by low-rank updates while a value is being edited
+    std::unique_ptr<ACSweepAnalysis> live_ac;
+    std::unique_ptr<DCSweepAnalysis> live_dc;
+    MNAMatrix live_mna;
     std::set<std::string> selected_signals;
     
     // Analysis and probe states
@@ -315,6 +326,8 @@ private:
     void onRunACAnalysisClicked();
     void onRunDCSweepClicked();
     void onRunPhaseAnalysisClicked();
+    void onLiveValueEdit(Element* element);
+    void stopLiveTuning() { live_ac.reset(); live_dc.reset(); }
     void onSaveProjectClicked();
     void onLoadProjectClicked();
     void onSaveSubcircuitClicked();
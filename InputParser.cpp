@@ -3,35 +3,92 @@
 #include "Circuit.h"
 #include "Analyzers.h" // <-- FIX: Changed from TransientAnalysis.h
 #include "ErrorManager.h"
+#include "SampleStream.h"
+#include "SignalProcessor.h"
 #include <sstream>
 #include <cctype>
 #include <fstream>
 #include <stdexcept>
 #include <algorithm>
 #include <iostream>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
 
-std::vector<std::string> InputParser::tokenize(const std::string& line) {
-    std::vector<std::string> tokens;
-    std::istringstream iss(line);
-    std::string token;
-    while (iss >> token) {
-        if (token.front() == '*' || token.front() == ';') break; // Comment line
-        tokens.push_back(token);
+static bool equalsNoCase(std::string_view a, const char* b) {
+    size_t n = std::strlen(b);
+    if (a.size() != n) return false;
+    for (size_t i = 0; i < n; ++i) {
+        if (tolower(static_cast<unsigned char>(a[i])) != b[i]) return false;
     }
-    return tokens;
+    return true;
 }
 
-double InputParser::parseValue(const std::string& value_str) {
-    if (value_str.empty()) {
-        throw std::runtime_error("Invalid numeric value format: empty string.");
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static std::string toUpper(std::string text) {
+    transform(text.begin(), text.end(), text.begin(), ::toupper);
+    return text;
+}
+
+void InputParser::tokenizeView(std::string_view line, std::vector<std::string_view>& tokens) {
+    tokens.clear();
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && isSpace(line[i])) ++i;
+        if (i == line.size()) break;
+        if (line[i] == '*' || line[i] == ';') break; // Comment line
+        size_t start = i;
+        int braces = 0;
+        bool quoted = false;
+        while (i < line.size() && (braces > 0 || quoted || !isSpace(line[i]))) {
+            if (line[i] == '{') ++braces;
+            else if (line[i] == '}' && braces > 0) --braces;
+            else if (line[i] == '\'') quoted = !quoted;
+            ++i;
+        }
+        tokens.push_back(line.substr(start, i - start));
     }
-    std::string num_part = value_str;
-    double multiplier = 1.0;
-    char last_char = tolower(value_str.back());
+}
 
-    if (isalpha(last_char)) {
-        num_part = value_str.substr(0, value_str.length() - 1);
-        switch (last_char) {
+std::vector<std::string> InputParser::tokenize(const std::string& line) {
+    std::vector<std::string_view> views;
+    tokenizeView(line, views);
+    return std::vector<std::string>(views.begin(), views.end());
+}
+
+bool InputParser::parseNumber(std::string_view text, double& value) {
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    if (text.empty()) return false;
+    const char* first = text.data();
+    const char* last = text.data() + text.size();
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto result = std::from_chars(first, last, value);
+    if (result.ec != std::errc()) return false;
+    const char* p = result.ptr;
+#else
+    char buffer[64];
+    if (text.size() >= sizeof(buffer)) return false;
+    std::memcpy(buffer, first, text.size());
+    buffer[text.size()] = '\0';
+    char* end = nullptr;
+    value = std::strtod(buffer, &end);
+    if (end == buffer) return false;
+    const char* p = first + (end - buffer);
+#endif
+    std::string_view suffix(p, static_cast<size_t>(last - p));
+    if (suffix.empty()) return true;
+    double multiplier = 1.0;
+    size_t used = 1;
+    if (suffix.size() >= 3 && equalsNoCase(suffix.substr(0, 3), "meg")) { multiplier = 1e6; used = 3; }
+    else if (suffix.size() >= 3 && equalsNoCase(suffix.substr(0, 3), "mil")) { multiplier = 25.4e-6; used = 3; }
+    else {
+        switch (tolower(static_cast<unsigned char>(suffix[0]))) {
             case 't': multiplier = 1e12; break;
             case 'g': multiplier = 1e9; break;
             case 'k': multiplier = 1e3; break;
@@ -40,15 +97,41 @@ double InputParser::parseValue(const std::string& value_str) {
             case 'n': multiplier = 1e-9; break;
             case 'p': multiplier = 1e-12; break;
             case 'f': multiplier = 1e-15; break;
-            default: break;
+            default: used = 0; break;
         }
     }
+    // Anything after the scale factor must be unit letters
+    for (size_t i = used; i < suffix.size(); ++i) {
+        if (!isalpha(static_cast<unsigned char>(suffix[i]))) return false;
+    }
+    value *= multiplier;
+    return true;
+}
 
-    try {
-        return std::stod(num_part) * multiplier;
-    } catch (const std::exception&) {
+double InputParser::parseValue(const std::string& value_str) {
+    if (value_str.empty()) {
+        throw std::runtime_error("Invalid numeric value format: empty string.");
+    }
+    double value;
+    if (!parseNumber(value_str, value)) {
+        auto it = params.find(toUpper(value_str));
+        if (it != params.end()) return it->second;
+        markToken(value_str);
         throw std::runtime_error("Invalid numeric value format: '" + value_str + "'.");
     }
+    return value;
+}
+
+void InputParser::markToken(const std::string& token) {
+    if (!current_source) return;
+    for (size_t i = 0; i < current_source->tokens.size(); ++i) {
+        size_t at = current_source->tokens[i].find(token);
+        if (at != std::string::npos) {
+            error_line = current_source->positions[i].first;
+            error_column = current_source->positions[i].second + at;
+            return;
+        }
+    }
 }
 
 void InputParser::parseAddCommand(const std::vector<std::string>& tokens, Circuit& circuit) {
@@ -71,13 +154,42 @@ void InputParser::parseAddCommand(const std::vector<std::string>& tokens, Circui
         else if (type_char == 'I') circuit.addElement(std::make_unique<IndependentCurrentSource>(name, n1, n2, val));
     } else if (type_char == 'D') {
         if (tokens.size() != 5) throw std::runtime_error("Invalid syntax for Diode. Expected: add <id> <n1> <n2> <model>");
-        circuit.addElement(std::make_unique<Diode>(name, tokens[2], tokens[3], tokens[4]));
+        auto diode = std::make_unique<Diode>(name, tokens[2], tokens[3], tokens[4]);
+        if (circuit.hasModelCard(tokens[4])) diode->applyModelCard(circuit.getModelCard(tokens[4]));
+        circuit.addElement(std::move(diode));
+    } else if (type_char == 'M') {
+        if (tokens.size() < 6 || tokens.size() > 8) throw std::runtime_error("Invalid syntax for MOSFET. Expected: add M<name> <drain> <gate> <source> <model> [W=<w>] [L=<l>]");
+        double w = 1e-6, l = 1e-6;
+        for (size_t i = 6; i < tokens.size(); ++i) {
+            std::string key = tokens[i].substr(0, 2);
+            transform(key.begin(), key.end(), key.begin(), ::toupper);
+            if (key == "W=") w = parseValue(tokens[i].substr(2));
+            else if (key == "L=") l = parseValue(tokens[i].substr(2));
+            else throw std::runtime_error("Unknown MOSFET parameter '" + tokens[i] + "'. Expected W=<w> or L=<l>.");
+        }
+        circuit.addElement(std::make_unique<Mosfet>(name, tokens[2], tokens[3], tokens[4], circuit.getModelCard(tokens[5]), w, l));
+    } else if (type_char == 'Y') {
+        if ((tokens.size() != 6 && tokens.size() != 7) || (tokens[4] != "TABLE" && tokens[4] != "table")) {
+            throw std::runtime_error("Invalid syntax for table device. Expected: add Y<name> <n+> <n-> TABLE <iv.csv> [<cv.csv>]");
+        }
+        std::vector<double> v, i, cv, c;
+        TableDevice::loadCSV(tokens[5], v, i);
+        if (tokens.size() == 7) TableDevice::loadCSV(tokens[6], cv, c);
+        auto table = std::make_unique<TableDevice>(name, tokens[2], tokens[3], v, i, cv, c);
+        table->setTablePath(tokens[5]);
+        circuit.addElement(std::move(table));
+    } else if (type_char == 'Q') {
+        if (tokens.size() != 6) throw std::runtime_error("Invalid syntax for BJT. Expected: add Q<name> <collector> <base> <emitter> <model>");
+        circuit.addElement(std::make_unique<BipolarTransistor>(name, tokens[2], tokens[3], tokens[4], circuit.getModelCard(tokens[5])));
     } else if (type_char == 'V') { // Voltage Sources
         if (tokens.size() < 5) throw std::runtime_error("Invalid syntax for V source.");
         std::string n1 = tokens[2], n2 = tokens[3];
         if (tokens.size() > 5 && (tokens[4] == "PULSE" || tokens[4] == "pulse")) {
             if (tokens.size() != 14 || tokens[5] != "(" || tokens[13] != ")") throw std::runtime_error("Invalid PULSE syntax. Expected: add V<name> <n+> <n-> PULSE ( V1 V2 TD TR TF PW PER )");
             circuit.addElement(std::make_unique<PulseVoltageSource>(name, n1, n2, parseValue(tokens[6]), parseValue(tokens[7]), parseValue(tokens[8]), parseValue(tokens[9]), parseValue(tokens[10]), parseValue(tokens[11]), parseValue(tokens[12])));
+        } else if (tokens.size() > 5 && (tokens[4] == "FILE" || tokens[4] == "file")) {
+            if (tokens.size() != 7 && tokens.size() != 8) throw std::runtime_error("Invalid FILE syntax. Expected: add V<name> <n+> <n-> FILE <samples.bin> <fs> [F32|F64]");
+            circuit.addElement(std::make_unique<WaveformVoltageSource>(name, n1, n2, tokens[5], parseValue(tokens[6]), tokens.size() == 8 ? tokens[7] : "F64"));
         } else if (tokens.size() > 5 && (tokens[4] == "SIN" || tokens[4] == "sin")) {
             if (tokens.size() != 10 || tokens[5] != "(" || tokens[9] != ")") {
                 throw std::runtime_error("Invalid SIN syntax. Expected: add V<name> <n+> <n-> SIN ( Voffset Vamplitude Frequency )");
@@ -87,24 +199,104 @@ void InputParser::parseAddCommand(const std::vector<std::string>& tokens, Circui
              if (tokens.size() != 5) throw std::runtime_error("Invalid syntax for DC Voltage Source.");
              circuit.addElement(std::make_unique<IndependentVoltageSource>(name, n1, n2, parseValue(tokens[4])));
         }
+    } else if (type_char == 'S') { // Switch
+        if (tokens.size() >= 7 && (tokens[4] == "TIME" || tokens[4] == "time")) {
+            std::string state = tokens[6];
+            transform(state.begin(), state.end(), state.begin(), ::toupper);
+            if (state != "ON" && state != "OFF") throw std::runtime_error("Switch initial state must be ON or OFF.");
+            std::vector<double> times;
+            for (size_t i = 7; i < tokens.size(); ++i) times.push_back(parseValue(tokens[i]));
+            circuit.addElement(std::make_unique<Switch>(name, tokens[2], tokens[3], times, circuit.getModelCard(tokens[5]), state == "ON"));
+        } else if (tokens.size() == 7) {
+            circuit.addElement(std::make_unique<Switch>(name, tokens[2], tokens[3], tokens[4], tokens[5], circuit.getModelCard(tokens[6])));
+        } else {
+            throw std::runtime_error("Invalid syntax for switch. Expected: add S<name> <n+> <n-> <nc+> <nc-> <model> or add S<name> <n+> <n-> TIME <model> <ON|OFF> <t1> [t2 ...]");
+        }
+    } else if (type_char == 'T') { // Lossless transmission line
+        if (tokens.size() != 8) throw std::runtime_error("Invalid syntax for transmission line. Expected: add T<name> <p1+> <p1-> <p2+> <p2-> Z0=<z> TD=<delay>");
+        double z0 = -1, td = -1;
+        for (size_t i = 6; i < 8; ++i) {
+            size_t eq = tokens[i].find('=');
+            std::string key = tokens[i].substr(0, eq);
+            transform(key.begin(), key.end(), key.begin(), ::toupper);
+            if (eq == std::string::npos) throw std::runtime_error("Expected <key>=<value>, got '" + tokens[i] + "'.");
+            if (key == "Z0") z0 = parseValue(tokens[i].substr(eq + 1));
+            else if (key == "TD") td = parseValue(tokens[i].substr(eq + 1));
+            else throw std::runtime_error("Unknown transmission line parameter '" + tokens[i] + "'. Expected Z0=<z> or TD=<delay>.");
+        }
+        circuit.addElement(std::make_unique<TransmissionLine>(name, tokens[2], tokens[3], tokens[4], tokens[5], z0, td));
+    } else if (type_char == 'K') { // Mutual inductance
+        if (tokens.size() < 5) throw std::runtime_error("Invalid syntax for coupling. Expected: add K<name> <L1> <L2> [<L3> ...] <k>");
+        std::vector<std::string> inductors(tokens.begin() + 2, tokens.end() - 1);
+        for (const auto& l : inductors) {
+            Element* elem = circuit.getElement(l);
+            if (!elem || elem->getType() != "Inductor") throw std::runtime_error("Coupling " + name + " references unknown inductor '" + l + "'.");
+        }
+        circuit.addElement(std::make_unique<MutualInductance>(name, inductors, parseValue(tokens.back())));
+    } else if (type_char == 'B') { // Behavioural source
+        const std::string usage = "Invalid syntax for behavioural source. Expected: add B<name> <n+> <n-> V=<expr> or I=<expr>";
+        if (tokens.size() < 5 || tokens[4].size() < 2 || tokens[4][1] != '=') throw std::runtime_error(usage);
+        char kind = toupper(tokens[4][0]);
+        if (kind != 'V' && kind != 'I') throw std::runtime_error(usage);
+        // The expression may have been split on spaces; rejoin the remaining tokens
+        std::string expr = tokens[4].substr(2);
+        for (size_t i = 5; i < tokens.size(); ++i) expr += " " + tokens[i];
+        circuit.addElement(std::make_unique<BehavioralSource>(name, tokens[2], tokens[3],
+            kind == 'V' ? BehavioralSource::Kind::VOLTAGE : BehavioralSource::Kind::CURRENT, expr));
     } else if (type_char == 'E') { // VCVS
         if (tokens.size() != 7) throw std::runtime_error("Invalid syntax for VCVS. Expected: add E<name> <n+> <n-> <ctrl_n+> <ctrl_n-> <gain>");
         circuit.addElement(std::make_unique<VoltageControlledVoltageSource>(name, tokens[2], tokens[3], tokens[4], tokens[5], parseValue(tokens[6])));
     }
     else {
+        markToken(full_id);
         throw std::runtime_error("Unknown element type: '" + full_id + "'.");
     }
-    std::cout << "Added element: " << name << std::endl;
+    if (verbose) std::cout << "Added element: " << name << std::endl;
 }
 
+void InputParser::parseModelCommand(const std::vector<std::string>& tokens, Circuit& circuit) {
+    // .model <name> <type> [(] PARAM=value ... [)]
+    if (tokens.size() < 3) throw std::runtime_error("Usage: .model <name> <D|NMOS|PMOS|NPN|PNP|SW> (PARAM=value ...)");
+    DeviceModelCard model;
+    model.name = tokens[1];
+    model.type = tokens[2];
+    size_t paren = model.type.find('(');
+    std::vector<std::string> param_tokens;
+    if (paren != std::string::npos) {
+        param_tokens.push_back(model.type.substr(paren));
+        model.type = model.type.substr(0, paren);
+    }
+    transform(model.type.begin(), model.type.end(), model.type.begin(), ::toupper);
+    if (model.type != "D" && model.type != "NMOS" && model.type != "PMOS" && model.type != "NPN" && model.type != "PNP" && model.type != "SW") {
+        throw std::runtime_error("Unsupported model type '" + model.type + "'.");
+    }
+    param_tokens.insert(param_tokens.end(), tokens.begin() + 3, tokens.end());
+    for (std::string tok : param_tokens) {
+        tok.erase(std::remove(tok.begin(), tok.end(), '('), tok.end());
+        tok.erase(std::remove(tok.begin(), tok.end(), ')'), tok.end());
+        if (tok.empty()) continue;
+        size_t eq = tok.find('=');
+        if (eq == std::string::npos || eq == 0) throw std::runtime_error("Invalid model parameter '" + tok + "'. Expected PARAM=value.");
+        std::string key = tok.substr(0, eq);
+        transform(key.begin(), key.end(), key.begin(), ::toupper);
+        model.params[key] = parseValue(tok.substr(eq + 1));
+    }
+    circuit.addModelCard(model);
+    if (verbose) std::cout << "Added model: " << model.name << " (" << model.type << ")" << std::endl;
+}
 
 void InputParser::parseCommand(const std::vector<std::string>& tokens, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver) {
     if (tokens.empty()) return;
     std::string cmd = tokens[0];
     transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
 
-    if (cmd == "add") {
+    if (cmd == "add" && tokens.size() > 1 && toupper(tokens[1][0]) == 'X') {
+        DeckContext ctx(circuit, mna, solver, ".");
+        expandInstance(tokens, ctx);
+    } else if (cmd == "add") {
         parseAddCommand(tokens, circuit);
+    } else if (cmd == ".model") {
+        parseModelCommand(tokens, circuit);
     } else if (cmd == "delete") {
         if (tokens.size() != 2) throw std::runtime_error("Usage: delete <element_name>");
         circuit.deleteElement(tokens[1]);
@@ -117,17 +309,30 @@ void InputParser::parseCommand(const std::vector<std::string>& tokens, Circuit&
         if (tokens.size() != 4 || tokens[1] != "node") throw std::runtime_error("Usage: rename node <old> <new>");
         circuit.renameNode(tokens[2], tokens[3]);
     } else if (cmd == "tran") {
-        if (tokens.size() < 3 || tokens.size() > 4) {
-             throw std::runtime_error("Usage: tran <Tstep> <Tstop> [UIC]");
-        }
+        const std::string usage = "Usage: tran <Tstep> <Tstop> [UIC] [EXP] [CHECKPOINT <file> [<interval_s>]] [RESUME <file>]";
+        if (tokens.size() < 3) throw std::runtime_error(usage);
         bool use_uic = false;
-        if (tokens.size() == 4) {
-            std::string uic_token = tokens[3];
-            transform(uic_token.begin(), uic_token.end(), uic_token.begin(), ::toupper);
-            if (uic_token == "UIC") {
+        TransientMethod method = TransientMethod::BACKWARD_EULER;
+        std::string checkpoint_file, resume_file;
+        double checkpoint_interval = 60.0;
+        for (size_t i = 3; i < tokens.size(); ++i) {
+            std::string option = tokens[i];
+            transform(option.begin(), option.end(), option.begin(), ::toupper);
+            if (option == "UIC") {
                 use_uic = true;
+            } else if (option == "EXP") {
+                method = TransientMethod::EXPONENTIAL;
+            } else if (option == "CHECKPOINT" && i + 1 < tokens.size()) {
+                checkpoint_file = tokens[++i];
+                double interval;
+                if (i + 1 < tokens.size() && parseNumber(tokens[i + 1], interval)) {
+                    checkpoint_interval = interval;
+                    ++i;
+                }
+            } else if (option == "RESUME" && i + 1 < tokens.size()) {
+                resume_file = tokens[++i];
             } else {
-                throw std::runtime_error("Invalid option '" + tokens[3] + "'. Did you mean 'UIC'?");
+                throw std::runtime_error("Invalid option '" + tokens[i] + "'. " + usage);
             }
         }
 
@@ -135,8 +340,19 @@ void InputParser::parseCommand(const std::vector<std::string>& tokens, Circuit&
         if (!circuit.checkConnectivity()) throw std::runtime_error("Circuit is not fully connected.");
 
         TransientAnalysis tran(parseValue(tokens[1]), parseValue(tokens[2]), use_uic);
+        tran.setMethod(method);
+        if (!checkpoint_file.empty()) tran.setCheckpointing(checkpoint_file, checkpoint_interval);
+        if (!resume_file.empty()) tran.resumeFrom(resume_file);
         tran.analyze(circuit, mna, solver);
         tran.displayResults();
+    } else if (cmd == "pss") {
+        if (tokens.size() != 3 && tokens.size() != 4) throw std::runtime_error("Usage: pss <period> <steps_per_period> [warmup_periods]");
+        if (!circuit.checkGroundNodeExists()) throw std::runtime_error("No ground node detected in the circuit.");
+        if (!circuit.checkConnectivity()) throw std::runtime_error("Circuit is not fully connected.");
+        PSSAnalysis pss(parseValue(tokens[1]), static_cast<int>(parseValue(tokens[2])),
+                        tokens.size() == 4 ? static_cast<int>(parseValue(tokens[3])) : 2);
+        pss.analyze(circuit, mna, solver);
+        pss.displayResults();
     } else if (cmd == "dc") {
         if (tokens.size() != 5) throw std::runtime_error("Usage: dc <src_name> <start> <end> <inc>");
         if (!circuit.checkGroundNodeExists()) throw std::runtime_error("No ground node detected in the circuit.");
@@ -152,26 +368,623 @@ void InputParser::parseCommand(const std::vector<std::string>& tokens, Circuit&
     }
 }
 
-void InputParser::parseFile(const std::string& file_path, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver) {
-    std::ifstream infile(file_path);
-    if (!infile.is_open()) throw std::runtime_error("Could not open file: " + file_path);
+// --- Netlist decks ---
+namespace {
+    struct CachedDeck {
+        std::filesystem::file_time_type mtime;
+        std::uintmax_t size = 0;
+        std::shared_ptr<const NetlistDeck> deck;
+    };
+    std::map<std::string, CachedDeck> deck_cache;
+    const int MAX_NESTING_DEPTH = 32; // .include and subcircuit nesting
+
+    std::string formatValue(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        return buffer;
+    }
+
+    // Files below PARALLEL_MIN_BYTES, and runs of fewer than PARALLEL_MIN_RECORDS plain
+    // element cards, are handled on the calling thread
+    const size_t PARALLEL_MIN_BYTES = 1 << 20;
+    const size_t PARALLEL_CHUNK_BYTES = 256 << 10;
+    const size_t PARALLEL_MIN_RECORDS = 4096;
+    bool parallel_loading = true;
+
+    // Splits [0, count) into contiguous ranges, one per worker, each at least min_per_worker long
+    template<class F>
+    void parallelFor(size_t count, size_t min_per_worker, F fn) {
+        size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), std::max<size_t>(1, count / min_per_worker));
+        if (workers <= 1) {
+            fn(0, count);
+            return;
+        }
+        std::vector<std::thread> pool;
+        pool.reserve(workers);
+        for (size_t w = 0; w < workers; ++w) pool.emplace_back(fn, count * w / workers, count * (w + 1) / workers);
+        for (auto& t : pool) t.join();
+    }
+
+    struct DeckChunk {
+        std::vector<NetlistLine> lines;
+        unsigned physical_lines = 0;
+        bool leading_continuation = false; // lines[0] continues the previous chunk's last statement
+    };
+
+    void tokenizeChunk(std::string_view text, bool first_chunk, DeckChunk& chunk) {
+        std::vector<std::string_view> views;
+        unsigned line_number = 0;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if (end == std::string_view::npos) end = text.size();
+            std::string_view line = text.substr(pos, end - pos);
+            pos = end + 1;
+            ++line_number;
+
+            InputParser::tokenizeView(line, views);
+            if (views.empty()) continue;
+            size_t first = 0;
+            if (views[0].front() == '+' && (!chunk.lines.empty() || !first_chunk)) {
+                // Continuation of the previous statement
+                if (chunk.lines.empty()) {
+                    chunk.lines.emplace_back();
+                    chunk.leading_continuation = true;
+                }
+                if (views[0].size() == 1) first = 1;
+                else views[0].remove_prefix(1);
+            } else {
+                chunk.lines.emplace_back();
+            }
+            NetlistLine& statement = chunk.lines.back();
+            for (size_t i = first; i < views.size(); ++i) {
+                statement.tokens.emplace_back(views[i]);
+                statement.positions.emplace_back(line_number, static_cast<unsigned>(views[i].data() - line.data()) + 1);
+            }
+        }
+        chunk.physical_lines = line_number;
+    }
+
+    // name n1 n2 value with a literal value: R, C, L, DC I and DC V cards
+    bool isPlainElement(const std::vector<std::string>& tokens) {
+        const size_t offset = equalsNoCase(tokens[0], "add") ? 1 : 0;
+        if (tokens.size() != offset + 4) return false;
+        const char type = toupper(static_cast<unsigned char>(tokens[offset][0]));
+        if (type != 'R' && type != 'C' && type != 'L' && type != 'I' && type != 'V') return false;
+        const std::string& value = tokens[offset + 3];
+        return value.find('{') == std::string::npos && value.find('\'') == std::string::npos;
+    }
+
+    std::unique_ptr<Element> buildPlainElement(const std::vector<std::string>& tokens) {
+        const size_t offset = equalsNoCase(tokens[0], "add") ? 1 : 0;
+        const std::string& name = tokens[offset];
+        const std::string& n1 = tokens[offset + 1];
+        const std::string& n2 = tokens[offset + 2];
+        double value;
+        if (!InputParser::parseNumber(tokens[offset + 3], value)) return nullptr; // Parameters and errors take the normal path
+        try {
+            switch (toupper(static_cast<unsigned char>(name[0]))) {
+                case 'R': return std::make_unique<Resistor>(name, n1, n2, value);
+                case 'C': return std::make_unique<Capacitor>(name, n1, n2, value);
+                case 'L': return std::make_unique<Inductor>(name, n1, n2, value);
+                case 'I': return std::make_unique<IndependentCurrentSource>(name, n1, n2, value);
+                case 'V': return std::make_unique<IndependentVoltageSource>(name, n1, n2, value);
+                default: return nullptr;
+            }
+        } catch (...) {
+            return nullptr;
+        }
+    }
+
+    std::string stripDelimiters(const std::string& text) {
+        if (text.size() >= 2 && ((text.front() == '{' && text.back() == '}') || (text.front() == '\'' && text.back() == '\'') || (text.front() == '"' && text.back() == '"'))) {
+            return text.substr(1, text.size() - 2);
+        }
+        return text;
+    }
+}
+
+std::shared_ptr<const NetlistDeck> InputParser::loadDeck(const std::string& path) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path resolved = fs::weakly_canonical(fs::path(path), ec);
+    const std::string key = ec ? path : resolved.string();
+    const auto mtime = fs::last_write_time(key, ec);
+    if (ec) throw std::runtime_error("Could not open file: " + path);
+    const auto size = fs::file_size(key, ec);
+
+    auto cached = deck_cache.find(key);
+    if (cached != deck_cache.end() && cached->second.mtime == mtime && cached->second.size == size) {
+        ErrorManager::info("[Parser] deck cache hit: " + key);
+        return cached->second.deck;
+    }
+
+    std::unique_ptr<MappedFile> file;
+    try {
+        file = std::make_unique<MappedFile>(key);
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Could not open file: " + path);
+    }
+
+    // Tokens are cut as views out of the mapped file and copied once into the deck.
+    // Large files are split on line boundaries and tokenised concurrently.
+    auto deck = std::make_shared<NetlistDeck>();
+    deck->path = key;
+    std::string_view text(file->size() ? reinterpret_cast<const char*>(file->data()) : "", file->size());
+    std::vector<size_t> bounds{0};
+    if (parallel_loading && text.size() >= PARALLEL_MIN_BYTES) {
+        const size_t chunks = std::min<size_t>(text.size() / PARALLEL_CHUNK_BYTES, 64);
+        for (size_t c = 1; c < chunks; ++c) {
+            size_t cut = text.find('\n', std::max(bounds.back(), text.size() * c / chunks));
+            if (cut == std::string_view::npos) break;
+            bounds.push_back(cut + 1);
+        }
+    }
+    bounds.push_back(text.size());
+
+    std::vector<DeckChunk> chunks(bounds.size() - 1);
+    parallelFor(chunks.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            tokenizeChunk(text.substr(bounds[c], bounds[c + 1] - bounds[c]), c == 0, chunks[c]);
+        }
+    });
+
+    // Merge in file order, rebasing line numbers and joining continuations across chunk edges
+    size_t statement_count = 0;
+    for (const auto& chunk : chunks) statement_count += chunk.lines.size();
+    deck->lines.reserve(statement_count);
+    unsigned line_offset = 0;
+    for (auto& chunk : chunks) {
+        for (size_t k = 0; k < chunk.lines.size(); ++k) {
+            NetlistLine& line = chunk.lines[k];
+            for (auto& position : line.positions) position.first += line_offset;
+            if (k == 0 && chunk.leading_continuation && !deck->lines.empty()) {
+                NetlistLine& previous = deck->lines.back();
+                previous.tokens.insert(previous.tokens.end(), std::make_move_iterator(line.tokens.begin()), std::make_move_iterator(line.tokens.end()));
+                previous.positions.insert(previous.positions.end(), line.positions.begin(), line.positions.end());
+                continue;
+            }
+            deck->lines.push_back(std::move(line));
+        }
+        line_offset += chunk.physical_lines;
+    }
+    if (chunks.size() > 1) ErrorManager::info("[Parser] tokenised " + key + " in " + std::to_string(chunks.size()) + " chunks");
+
+    // .lib <section> ... .endl blocks, only entered through .lib <file> <section>
+    for (size_t i = 0; i < deck->lines.size(); ++i) {
+        const auto& tokens = deck->lines[i].tokens;
+        if (tokens.size() != 2 || !equalsNoCase(tokens[0], ".lib")) continue;
+        for (size_t j = i + 1; j < deck->lines.size(); ++j) {
+            if (equalsNoCase(deck->lines[j].tokens[0], ".endl")) {
+                deck->lib_sections[toUpper(tokens[1])] = {i + 1, j};
+                i = j;
+                break;
+            }
+        }
+    }
 
-    std::string line;
+    ErrorManager::info("[Parser] parsed " + key + " (" + std::to_string(deck->lines.size()) + " statements)");
+    deck_cache[key] = CachedDeck{mtime, size, deck};
+    return deck;
+}
+
+void InputParser::clearDeckCache() {
+    deck_cache.clear();
+}
+
+void InputParser::setParallelLoading(bool enabled) {
+    parallel_loading = enabled;
+}
+
+void InputParser::parseFile(const std::string& file_path, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver) {
+    std::shared_ptr<const NetlistDeck> deck = loadDeck(file_path);
     std::cout << "Loading circuit from: " << file_path << std::endl;
-    while (getline(infile, line)) {
-        std::vector<std::string> tokens = tokenize(line);
-        if (tokens.empty()) continue;
-
-        std::string cmd = tokens[0];
-        transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
-
-        if (cmd == "add" || cmd == "delete" || cmd == "rename") {
-            try {
-                parseCommand(tokens, circuit, mna, solver);
-            } catch (const std::runtime_error& e) {
-                ErrorManager::displayError("In file '" + file_path + "': " + e.what());
+
+    params.clear();
+    subcircuits.clear();
+    command_count = 0;
+    const bool was_verbose = verbose;
+    verbose = false;
+    DeckContext ctx(circuit, mna, solver, deck->path);
+    // The first line of a SPICE deck is its title
+    std::string extension = toUpper(std::filesystem::path(file_path).extension().string());
+    bool has_title = (extension == ".SP" || extension == ".CIR" || extension == ".SPI" || extension == ".NET" || extension == ".CKT");
+    size_t first = (has_title && !deck->lines.empty() && deck->lines[0].positions[0].first == 1) ? 1 : 0;
+    processDeck(deck->lines, first, deck->lines.size(), deck.get(), ctx);
+    verbose = was_verbose;
+    current_source = nullptr;
+
+    // SPICE decks treat node 0 as ground without a GND element
+    if (!circuit.checkGroundNodeExists() && circuit.hasNode("0")) {
+        circuit.addElement(std::make_unique<Ground>("GND", "0"));
+        ErrorManager::info("[Parser] node 0 used as ground");
+    }
+    std::cout << "File parsing complete (" << command_count << " commands)." << std::endl;
+}
+
+void InputParser::processDeck(const std::vector<NetlistLine>& lines, size_t first, size_t last, const NetlistDeck* deck, DeckContext& ctx) {
+    for (size_t i = first; i < last; ++i) {
+        const NetlistLine& line = lines[i];
+        const std::string& cmd = line.tokens[0];
+        current_source = &line;
+        error_line = error_column = 0;
+        try {
+            if (equalsNoCase(cmd, ".end")) break;
+            if (equalsNoCase(cmd, ".subckt")) {
+                // .subckt <name> <ports...> [PARAMS:] [k=v ...]
+                if (line.tokens.size() < 2) throw std::runtime_error("Usage: .subckt <name> <port1> [port2 ...] [PARAMS: name=value ...]");
+                SubcircuitDefinition def;
+                def.name = line.tokens[1];
+                def.file = ctx.file;
+                for (size_t k = 2; k < line.tokens.size(); ++k) {
+                    const std::string& token = line.tokens[k];
+                    size_t eq = token.find('=');
+                    if (equalsNoCase(token, "params:")) continue;
+                    if (eq == std::string::npos) def.ports.push_back(token);
+                    else def.params.emplace_back(toUpper(token.substr(0, eq)), stripDelimiters(token.substr(eq + 1)));
+                }
+                int nesting = 1;
+                size_t j = i + 1;
+                for (; j < last; ++j) {
+                    if (equalsNoCase(lines[j].tokens[0], ".subckt")) ++nesting;
+                    else if (equalsNoCase(lines[j].tokens[0], ".ends") && --nesting == 0) break;
+                    def.body.push_back(lines[j]);
+                }
+                if (j == last) throw std::runtime_error("Subcircuit '" + def.name + "' has no matching .ends.");
+                subcircuits[toUpper(def.name)] = std::move(def);
+                i = j;
+                continue;
+            }
+            if (equalsNoCase(cmd, ".lib") && line.tokens.size() == 2 && deck) {
+                auto section = deck->lib_sections.find(toUpper(line.tokens[1]));
+                if (section != deck->lib_sections.end() && section->second.first == i + 1) {
+                    i = section->second.second; // Section bodies are skipped unless requested
+                    continue;
+                }
+            }
+            if (parallel_loading && ctx.instance_path.empty() && isPlainElement(line.tokens)) {
+                size_t j = i + 1;
+                while (j < last && isPlainElement(lines[j].tokens)) ++j;
+                if (j - i >= PARALLEL_MIN_RECORDS) {
+                    addPlainElements(lines, i, j, ctx);
+                    i = j - 1;
+                    continue;
+                }
+            }
+            if (equalsNoCase(cmd, ".control")) {
+                while (i + 1 < last && !equalsNoCase(lines[i + 1].tokens[0], ".endc")) ++i;
+                ++i;
+                continue;
+            }
+            processLine(line, ctx);
+        } catch (const std::exception& e) {
+            reportError(line, ctx, e);
+        }
+    }
+}
+
+void InputParser::reportError(const NetlistLine& line, const DeckContext& ctx, const std::exception& e) const {
+    size_t line_number = error_line ? error_line : line.positions[0].first;
+    size_t column = error_line ? error_column : line.positions[0].second;
+    ErrorManager::displayError("In file '" + ctx.file + "', line " + std::to_string(line_number) + ", column " + std::to_string(column) + ": " + e.what());
+}
+
+void InputParser::addPlainElements(const std::vector<NetlistLine>& lines, size_t first, size_t last, DeckContext& ctx) {
+    std::vector<std::unique_ptr<Element>> records(last - first);
+    parallelFor(records.size(), PARALLEL_MIN_RECORDS / 2, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) records[k] = buildPlainElement(lines[first + k].tokens);
+    });
+
+    size_t k = 0;
+    while (k < records.size()) {
+        size_t stop = ctx.circuit->addElements(records, k);
+        command_count += stop - k;
+        if (stop == records.size()) break;
+        // Unparsed value or duplicate name: the normal path adds it or reports the error
+        const NetlistLine& line = lines[first + stop];
+        current_source = &line;
+        error_line = error_column = 0;
+        try {
+            processLine(line, ctx);
+        } catch (const std::exception& e) {
+            reportError(line, ctx, e);
+        }
+        k = stop + 1;
+    }
+}
+
+void InputParser::processLine(const NetlistLine& line, DeckContext& ctx) {
+    std::string cmd = line.tokens[0];
+    transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+
+    if (cmd == ".param") {
+        defineParams(line.tokens, 1);
+        return;
+    }
+    std::vector<std::string> tokens;
+    tokens.reserve(line.tokens.size() + 1);
+    for (const auto& token : line.tokens) tokens.push_back(substituteExpressions(token));
+
+    if (cmd == ".include" || cmd == ".inc") {
+        if (tokens.size() != 2) throw std::runtime_error("Usage: .include <file>");
+        includeFile(stripDelimiters(tokens[1]), "", ctx);
+        return;
+    }
+    if (cmd == ".lib") {
+        if (tokens.size() != 2 && tokens.size() != 3) throw std::runtime_error("Usage: .lib <file> [section]");
+        includeFile(stripDelimiters(tokens[1]), tokens.size() == 3 ? tokens[2] : "", ctx);
+        return;
+    }
+    if (cmd == "add" || cmd == "delete" || cmd == "rename" || cmd == ".model") {
+        // Repo command syntax
+    } else if (cmd[0] == '.') {
+        return; // Analysis and output directives are run from the GUI or the command line
+    } else if (cmd == "tran" || cmd == "pss" || cmd == "dc" || cmd == "list" || cmd == "save") {
+        return;
+    } else if (isalpha(static_cast<unsigned char>(cmd[0]))) {
+        tokens = toAddForm(tokens, *ctx.circuit);
+        cmd = "add";
+    } else {
+        throw std::runtime_error("Unrecognised statement '" + line.tokens[0] + "'.");
+    }
+
+    if (cmd == "add" && tokens.size() > 1 && toupper(tokens[1][0]) == 'X') {
+        expandInstance(tokens, ctx);
+        return;
+    }
+    if (cmd == "add" && !ctx.instance_path.empty()) {
+        if (tokens.size() > 1 && (tokens[1] == "GND" || tokens[1] == "gnd")) return; // Ground is global
+        localise(tokens, ctx);
+    }
+    parseCommand(tokens, *ctx.circuit, *ctx.mna, *ctx.solver);
+    ++command_count;
+}
+
+void InputParser::includeFile(const std::string& path, const std::string& section, DeckContext& ctx) {
+    if (ctx.depth >= MAX_NESTING_DEPTH) throw std::runtime_error("Includes nested too deeply (recursive .include?): " + path);
+    std::filesystem::path target(path);
+    if (target.is_relative()) target = std::filesystem::path(ctx.file).parent_path() / target;
+    std::shared_ptr<const NetlistDeck> deck = loadDeck(target.string());
+
+    size_t first = 0, last = deck->lines.size();
+    if (!section.empty()) {
+        auto it = deck->lib_sections.find(toUpper(section));
+        if (it == deck->lib_sections.end()) throw std::runtime_error("Library section '" + section + "' not found in " + deck->path);
+        first = it->second.first;
+        last = it->second.second;
+    }
+    const NetlistLine* outer = current_source;
+    DeckContext child = ctx;
+    child.file = deck->path;
+    child.depth = ctx.depth + 1;
+    processDeck(deck->lines, first, last, deck.get(), child);
+    current_source = outer;
+    error_line = error_column = 0;
+}
+
+double InputParser::evaluateExpression(const std::string& expression) const {
+    ExpressionTape tape = ExpressionTape::compile(expression);
+    std::vector<double> inputs;
+    for (const auto& name : tape.getVariables()) {
+        auto it = params.find(toUpper(name));
+        if (it == params.end()) throw std::runtime_error("Unknown parameter '" + name + "' in '" + expression + "'.");
+        inputs.push_back(it->second);
+    }
+    return tape.evaluate(inputs.data());
+}
+
+std::string InputParser::substituteExpressions(const std::string& token) const {
+    if (token.find('{') == std::string::npos && token.find('\'') == std::string::npos) return token;
+    std::string out;
+    size_t i = 0;
+    while (i < token.size()) {
+        const char open = token[i];
+        if (open != '{' && open != '\'') { out += token[i++]; continue; }
+        const char close = (open == '{') ? '}' : '\'';
+        size_t end = token.find(close, i + 1);
+        if (end == std::string::npos) throw std::runtime_error("Unterminated expression in '" + token + "'.");
+        out += formatValue(evaluateExpression(token.substr(i + 1, end - i - 1)));
+        i = end + 1;
+    }
+    return out;
+}
+
+void InputParser::defineParams(const std::vector<std::string>& tokens, size_t first) {
+    // .param a=1k b = {2*a} c='a+b' ... : assignments may contain spaces, so work on the joined text
+    std::string text;
+    for (size_t i = first; i < tokens.size(); ++i) text += (i > first ? " " : "") + tokens[i];
+    auto identifierEnd = [&](size_t k) {
+        if (k >= text.size() || !(isalpha(static_cast<unsigned char>(text[k])) || text[k] == '_')) return k;
+        while (k < text.size() && (isalnum(static_cast<unsigned char>(text[k])) || text[k] == '_')) ++k;
+        return k;
+    };
+    auto assignmentAt = [&](size_t k, size_t& name_end, size_t& value_start) {
+        while (k < text.size() && text[k] == ' ') ++k;
+        name_end = identifierEnd(k);
+        if (name_end == k) return false;
+        size_t e = name_end;
+        while (e < text.size() && text[e] == ' ') ++e;
+        if (e >= text.size() || text[e] != '=' || (e + 1 < text.size() && text[e + 1] == '=')) return false;
+        value_start = e + 1;
+        return true;
+    };
+
+    size_t pos = 0;
+    if (text.empty()) throw std::runtime_error("Usage: .param <name>=<value> [...]");
+    while (pos < text.size()) {
+        while (pos < text.size() && text[pos] == ' ') ++pos;
+        if (pos == text.size()) break;
+        size_t name_end, value_start;
+        if (!assignmentAt(pos, name_end, value_start)) throw std::runtime_error("Invalid .param assignment near '" + text.substr(pos) + "'.");
+        const std::string name = text.substr(pos, name_end - pos);
+        // The value runs until the next top-level " name=" or the end of the line
+        size_t end = value_start, depth = 0;
+        bool quoted = false;
+        for (; end < text.size(); ++end) {
+            char c = text[end];
+            if (c == '\'') quoted = !quoted;
+            else if (c == '(' || c == '{') ++depth;
+            else if ((c == ')' || c == '}') && depth > 0) --depth;
+            else if (c == ' ' && depth == 0 && !quoted) {
+                size_t n_end, v_start;
+                if (assignmentAt(end, n_end, v_start)) break;
+            }
+        }
+        std::string value_text = text.substr(value_start, end - value_start);
+        value_text.erase(0, value_text.find_first_not_of(' '));
+        value_text.erase(value_text.find_last_not_of(' ') + 1);
+        value_text = stripDelimiters(value_text);
+        if (value_text.empty()) throw std::runtime_error("Parameter '" + name + "' has no value.");
+        double value;
+        params[toUpper(name)] = parseNumber(value_text, value) ? value : evaluateExpression(value_text);
+        pos = end;
+    }
+}
+
+std::vector<std::string> InputParser::toAddForm(const std::vector<std::string>& tokens, const Circuit& circuit) const {
+    // SPICE element card -> "add <card>" with the small syntax differences smoothed over
+    std::vector<std::string> out;
+    out.reserve(tokens.size() + 1);
+    out.push_back("add");
+    out.insert(out.end(), tokens.begin(), tokens.end());
+    const char type = toupper(out[1][0]);
+    if (type == 'V' || type == 'I') {
+        if (out.size() > 5 && equalsNoCase(out[4], "dc")) out.erase(out.begin() + 4);
+        if (out.size() > 4) {
+            const std::string keyword = toUpper(out[4].substr(0, out[4].find('(')));
+            if (keyword == "PULSE" || keyword == "SIN") {
+                // PULSE(0 5 1n ...) -> PULSE ( 0 5 1n ... )
+                std::string spec;
+                for (size_t i = 4; i < out.size(); ++i) spec += " " + out[i];
+                std::string spaced;
+                for (char c : spec) {
+                    if (c == '(' || c == ')' || c == ',') { spaced += ' '; if (c != ',') spaced += c; spaced += ' '; }
+                    else spaced += c;
+                }
+                out.resize(4);
+                std::vector<std::string_view> views;
+                tokenizeView(spaced, views);
+                for (auto view : views) out.emplace_back(view);
+                out[4] = keyword;
             }
         }
+    } else if ((type == 'M' || type == 'Q') && out.size() >= 7 && !circuit.hasModelCard(out[5]) && circuit.hasModelCard(out[6])) {
+        out.erase(out.begin() + 5); // Bulk/substrate terminal is not modelled
+    }
+    return out;
+}
+
+std::string InputParser::localNode(const std::string& node, const DeckContext& ctx) const {
+    if (ctx.instance_path.empty()) return node;
+    auto port = ctx.port_map.find(node);
+    if (port != ctx.port_map.end()) return port->second;
+    if (node == "0" || equalsNoCase(node, "gnd")) return node; // Global ground
+    return ctx.instance_path + "." + node;
+}
+
+std::string InputParser::localName(const std::string& name, const DeckContext& ctx) const {
+    // Keeps the type letter in front so the element still dispatches by its first character
+    return std::string(1, name[0]) + "." + ctx.instance_path + "." + name;
+}
+
+void InputParser::localise(std::vector<std::string>& tokens, const DeckContext& ctx) const {
+    if (tokens.size() < 3) return;
+    const char type = toupper(tokens[1][0]);
+    tokens[1] = localName(tokens[1], ctx);
+
+    size_t node_count = 2;
+    switch (type) {
+        case 'M': case 'Q': node_count = 3; break;
+        case 'E': case 'T': node_count = 4; break;
+        case 'S': node_count = (tokens.size() > 4 && equalsNoCase(tokens[4], "time")) ? 2 : 4; break;
+        case 'K': node_count = 0; break;
+        default: break;
+    }
+    for (size_t i = 2; i < 2 + node_count && i < tokens.size(); ++i) tokens[i] = localNode(tokens[i], ctx);
+
+    if (type == 'K') {
+        for (size_t i = 2; i + 1 < tokens.size(); ++i) tokens[i] = localName(tokens[i], ctx);
+    } else if (type == 'B') {
+        // Rewrite V(node), V(a,b) and I(branch) probes inside the expression
+        for (size_t i = 4; i < tokens.size(); ++i) {
+            const std::string& text = tokens[i];
+            std::string out;
+            size_t k = 0;
+            while (k < text.size()) {
+                const char c = toupper(text[k]);
+                const bool boundary = (k == 0) || !(isalnum(static_cast<unsigned char>(text[k - 1])) || text[k - 1] == '_');
+                size_t close = text.find(')', k);
+                if ((c == 'V' || c == 'I') && boundary && k + 1 < text.size() && text[k + 1] == '(' && close != std::string::npos) {
+                    std::string inner = text.substr(k + 2, close - k - 2);
+                    std::string mapped;
+                    size_t start = 0;
+                    while (true) {
+                        size_t comma = inner.find(',', start);
+                        std::string part = inner.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+                        mapped += (c == 'V') ? localNode(part, ctx) : localName(part, ctx);
+                        if (comma == std::string::npos) break;
+                        mapped += ",";
+                        start = comma + 1;
+                    }
+                    out += text.substr(k, 2) + mapped + ")";
+                    k = close + 1;
+                } else {
+                    out += text[k++];
+                }
+            }
+            tokens[i] = out;
+        }
+    }
+}
+
+void InputParser::expandInstance(const std::vector<std::string>& tokens, DeckContext& ctx) {
+    // add X<name> <nodes...> <subckt> [name=value ...]
+    if (ctx.depth >= MAX_NESTING_DEPTH) throw std::runtime_error("Subcircuits nested too deeply (recursive instance?): " + tokens[1]);
+    size_t end = tokens.size();
+    while (end > 2 && tokens[end - 1].find('=') != std::string::npos) --end;
+    if (end < 4) throw std::runtime_error("Invalid syntax for subcircuit instance. Expected: X<name> <node1> [node2 ...] <subckt> [param=value ...]");
+    const std::string& sub_name = tokens[end - 1];
+    auto it = subcircuits.find(toUpper(sub_name));
+    if (it == subcircuits.end()) {
+        markToken(sub_name);
+        throw std::runtime_error("Subcircuit '" + sub_name + "' is not defined.");
+    }
+    const SubcircuitDefinition& def = it->second;
+    if (end - 3 != def.ports.size()) {
+        throw std::runtime_error("Subcircuit '" + def.name + "' has " + std::to_string(def.ports.size()) + " ports, instance " + tokens[1] + " connects " + std::to_string(end - 3) + ".");
+    }
+
+    DeckContext child = ctx;
+    child.file = def.file;
+    child.depth = ctx.depth + 1;
+    child.instance_path = ctx.instance_path.empty() ? tokens[1] : ctx.instance_path + "." + tokens[1];
+    child.port_map.clear();
+    for (size_t k = 0; k < def.ports.size(); ++k) child.port_map[def.ports[k]] = localNode(tokens[2 + k], ctx);
+
+    // Overrides are evaluated in the caller's scope, defaults in the instance scope
+    std::map<std::string, double> overrides;
+    for (size_t k = end; k < tokens.size(); ++k) {
+        size_t eq = tokens[k].find('=');
+        std::string value_text = stripDelimiters(tokens[k].substr(eq + 1));
+        double value;
+        overrides[toUpper(tokens[k].substr(0, eq))] = parseNumber(value_text, value) ? value : evaluateExpression(value_text);
+    }
+    const std::map<std::string, double> saved = params;
+    const NetlistLine* outer = current_source;
+    try {
+        for (const auto& param : def.params) {
+            auto o = overrides.find(param.first);
+            double value;
+            params[param.first] = (o != overrides.end()) ? o->second : (parseNumber(param.second, value) ? value : evaluateExpression(param.second));
+        }
+        for (const auto& o : overrides) params[o.first] = o.second;
+        processDeck(def.body, 0, def.body.size(), nullptr, child);
+    } catch (...) {
+        params = saved;
+        current_source = outer;
+        throw;
     }
-    std::cout << "File parsing complete." << std::endl;
+    params = saved;
+    current_source = outer;
+    error_line = error_column = 0;
 }
@@ -1,18 +1,106 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <utility>
 
 // Forward declarations
 class Circuit;
 class MNAMatrix;
 class LinearSolver;
 
+// --- Netlist deck (one file after continuation joining and tokenising) ---
+struct NetlistLine {
+    std::vector<std::string> tokens;
+    std::vector<std::pair<unsigned, unsigned>> positions; // Source (line, column) of each token, 1-based
+};
+
+struct NetlistDeck {
+    std::string path;
+    std::vector<NetlistLine> lines;
+    // .lib <section> ... .endl ranges as [first, last) line indices, keyed by upper-case section name
+    std::map<std::string, std::pair<size_t, size_t>> lib_sections;
+};
+
+// --- Subcircuit definition (.subckt name ports... [PARAMS: k=v ...] ... .ends) ---
+// Instances (X lines) are flattened: body elements become <type>.<path>.<name>
+// and internal nodes <path>.<node>, with ports mapped to the instance nodes.
+struct SubcircuitDefinition {
+    std::string name;
+    std::vector<std::string> ports;
+    std::vector<std::pair<std::string, std::string>> params; // Defaults as (name, expression)
+    std::vector<NetlistLine> body;
+    std::string file;
+};
+
 class InputParser {
 public:
     std::vector<std::string> tokenize(const std::string& line);
+    // Splits on whitespace into views of `line`; a token starting with '*' or ';' ends the line.
+    // Whitespace inside {...} or '...' parameter expressions does not split.
+    static void tokenizeView(std::string_view line, std::vector<std::string_view>& tokens);
+    // SPICE number: from_chars mantissa plus an optional scale suffix (T G MEG K M MIL U N P F),
+    // trailing unit letters are ignored ("10kOhm"). Returns false on malformed input.
+    static bool parseNumber(std::string_view text, double& value);
     void parseCommand(const std::vector<std::string>& tokens, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver);
+    // Reads the repo's own command files as well as SPICE decks (.include, .lib, .param, .subckt).
     void parseFile(const std::string& file_path, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver);
+
+    // Parsed decks are cached by canonical path and reused while size and mtime are unchanged.
+    static std::shared_ptr<const NetlistDeck> loadDeck(const std::string& path);
+    static void clearDeckCache();
+    // Decks of 1 MB or more are tokenised in chunks, and long runs of plain R/C/L/I/V
+    // cards are built, on worker threads (on by default). Off, everything runs on the
+    // calling thread; the resulting circuit and error positions are the same.
+    static void setParallelLoading(bool enabled);
+
+    const std::map<std::string, double>& getParams() const { return params; }
+    double evaluateExpression(const std::string& expression) const;
+
 private:
+    struct DeckContext {
+        DeckContext(Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver, std::string file)
+            : circuit(&circuit), mna(&mna), solver(&solver), file(std::move(file)) {}
+        Circuit* circuit;
+        MNAMatrix* mna;
+        const LinearSolver* solver;
+        std::string file;
+        std::string instance_path;                   // "" at top level, "X1.X2" inside instances
+        std::map<std::string, std::string> port_map; // Subcircuit port -> instance node
+        int depth = 0;
+    };
+
     void parseAddCommand(const std::vector<std::string>& tokens, Circuit& circuit);
+    void parseModelCommand(const std::vector<std::string>& tokens, Circuit& circuit);
     double parseValue(const std::string& value_str);
+    // Points error_line/error_column at `token` within current_source
+    void markToken(const std::string& token);
+
+    // --- SPICE deck processing ---
+    // Runs lines [first, last); deck supplies .lib sections and is null for subcircuit bodies
+    void processDeck(const std::vector<NetlistLine>& lines, size_t first, size_t last, const NetlistDeck* deck, DeckContext& ctx);
+    void processLine(const NetlistLine& line, DeckContext& ctx);
+    void reportError(const NetlistLine& line, const DeckContext& ctx, const std::exception& e) const;
+    // Builds plain element cards [first, last) concurrently and merges them in file order
+    void addPlainElements(const std::vector<NetlistLine>& lines, size_t first, size_t last, DeckContext& ctx);
+    void includeFile(const std::string& path, const std::string& section, DeckContext& ctx);
+    void defineParams(const std::vector<std::string>& tokens, size_t first);
+    void expandInstance(const std::vector<std::string>& tokens, DeckContext& ctx);
+    std::string substituteExpressions(const std::string& token) const;
+    std::vector<std::string> toAddForm(const std::vector<std::string>& tokens, const Circuit& circuit) const;
+    void localise(std::vector<std::string>& tokens, const DeckContext& ctx) const;
+    std::string localNode(const std::string& node, const DeckContext& ctx) const;
+    std::string localName(const std::string& name, const DeckContext& ctx) const;
+
+    std::map<std::string, double> params;                      // .param values in scope
+    std::map<std::string, SubcircuitDefinition> subcircuits;   // Keyed by upper-case name
+
+    // Line being parsed by parseFile, used to place error positions
+    const NetlistLine* current_source = nullptr;
+    size_t error_column = 0; // 1-based, 0 when unknown
+    size_t error_line = 0;   // Line of the marked token, 0 when unknown
+    size_t command_count = 0;
+    bool verbose = true;     // Per-element console messages
 };
@@ -0,0 +1,93 @@
+#include "MonotoneSpline.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+// --- MonotoneCubicSpline Implementation ---
+void MonotoneCubicSpline::setPoints(const std::vector<double>& xs, const std::vector<double>& ys) {
+    if (xs.size() != ys.size()) throw std::runtime_error("Spline table columns have different lengths.");
+    if (xs.size() < 2) throw std::runtime_error("Spline table needs at least two points.");
+    for (size_t k = 1; k < xs.size(); ++k) {
+        if (!(xs[k] > xs[k - 1])) throw std::runtime_error("Spline table x values must be strictly increasing.");
+    }
+
+    const size_t n = xs.size();
+    x = xs;
+    last_interval = 0;
+
+    // Secant slopes
+    std::vector<double> h(n - 1), d(n - 1);
+    for (size_t k = 0; k + 1 < n; ++k) {
+        h[k] = xs[k + 1] - xs[k];
+        d[k] = (ys[k + 1] - ys[k]) / h[k];
+    }
+
+    // Initial tangents: one-sided at the ends, averaged secants inside (zero at extrema)
+    std::vector<double> m(n);
+    m[0] = d[0];
+    m[n - 1] = d[n - 2];
+    for (size_t k = 1; k + 1 < n; ++k) {
+        m[k] = (d[k - 1] * d[k] <= 0.0) ? 0.0 : 0.5 * (d[k - 1] + d[k]);
+    }
+
+    // Fritsch-Carlson limiter keeps each segment monotone
+    for (size_t k = 0; k + 1 < n; ++k) {
+        if (d[k] == 0.0) {
+            m[k] = 0.0;
+            m[k + 1] = 0.0;
+            continue;
+        }
+        double alpha = m[k] / d[k];
+        double beta = m[k + 1] / d[k];
+        double r2 = alpha * alpha + beta * beta;
+        if (r2 > 9.0) {
+            double tau = 3.0 / std::sqrt(r2);
+            m[k] = tau * alpha * d[k];
+            m[k + 1] = tau * beta * d[k];
+        }
+    }
+
+    c0.resize(n); c1.resize(n); c2.assign(n, 0.0); c3.assign(n, 0.0);
+    for (size_t k = 0; k < n; ++k) {
+        c0[k] = ys[k];
+        c1[k] = m[k];
+    }
+    for (size_t k = 0; k + 1 < n; ++k) {
+        c2[k] = (3.0 * d[k] - 2.0 * m[k] - m[k + 1]) / h[k];
+        c3[k] = (m[k] + m[k + 1] - 2.0 * d[k]) / (h[k] * h[k]);
+    }
+}
+
+size_t MonotoneCubicSpline::findInterval(double xq) const {
+    const size_t last = x.size() - 2; // Index of the final interval
+    size_t k = std::min(last_interval, last);
+    if (xq >= x[k] && xq < x[k + 1]) return k;
+    if (k < last && xq >= x[k + 1] && xq < x[k + 2]) return last_interval = k + 1;
+    if (k > 0 && xq >= x[k - 1] && xq < x[k]) return last_interval = k - 1;
+
+    auto it = std::upper_bound(x.begin(), x.end(), xq);
+    size_t idx = (it == x.begin()) ? 0 : static_cast<size_t>(it - x.begin()) - 1;
+    return last_interval = std::min(idx, last);
+}
+
+double MonotoneCubicSpline::evaluate(double xq, double& dydx) const {
+    if (x.empty()) throw std::runtime_error("Spline evaluated before setPoints().");
+    const size_t n = x.size();
+    if (xq <= x[0]) {
+        dydx = c1[0];
+        return c0[0] + c1[0] * (xq - x[0]);
+    }
+    if (xq >= x[n - 1]) {
+        dydx = c1[n - 1];
+        return c0[n - 1] + c1[n - 1] * (xq - x[n - 1]);
+    }
+    size_t k = findInterval(xq);
+    double t = xq - x[k];
+    dydx = c1[k] + t * (2.0 * c2[k] + 3.0 * c3[k] * t);
+    return c0[k] + t * (c1[k] + t * (c2[k] + t * c3[k]));
+}
+
+double MonotoneCubicSpline::evaluate(double xq) const {
+    double unused;
+    return evaluate(xq, unused);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// --- MonotoneCubicSpline (Fritsch-Carlson) ---
+// Piecewise cubic Hermite interpolant that preserves the monotonicity of the
+// tabulated data, so a measured I-V curve never produces negative differential
+// conductance between samples. Per-interval polynomial coefficients are
+// precomputed in setPoints(); evaluate() first tries the interval used by the
+// previous call (and its neighbours) so successive Newton iterations resolve
+// the segment in O(1), falling back to binary search on large jumps.
+// Outside the table the curve is extended linearly with the end slopes.
+class MonotoneCubicSpline {
+private:
+    std::vector<double> x;
+    std::vector<double> c0, c1, c2, c3; // y = c0 + c1*t + c2*t^2 + c3*t^3, t = xq - x[k]
+    mutable size_t last_interval = 0;
+
+    size_t findInterval(double xq) const;
+
+public:
+    void setPoints(const std::vector<double>& xs, const std::vector<double>& ys);
+    bool empty() const { return x.empty(); }
+    size_t size() const { return x.size(); }
+
+    // Returns y(xq) and writes dy/dx at xq.
+    double evaluate(double xq, double& dydx) const;
+    double evaluate(double xq) const;
+};
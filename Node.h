@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include "ObjectPool.h"
 
 class Node {
 private:
@@ -9,6 +10,8 @@ private:
 
 public:
     explicit Node(const std::string& id);
+    static void* operator new(std::size_t size) { return ObjectPool::allocate(size); }
+    static void operator delete(void* p, std::size_t size) { ObjectPool::release(p, size); }
     std::string getId() const;
     double getVoltage() const;
     bool getIsGround() const;
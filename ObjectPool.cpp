@@ -0,0 +1,145 @@
+#include "ObjectPool.h"
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+    struct FreeNode { FreeNode* next; };
+
+    constexpr std::size_t CLASS_COUNT = ObjectPool::MAX_POOLED_SIZE / ObjectPool::GRANULE;
+    constexpr std::size_t REFILL_BATCH = 32; // Free nodes moved from the shared lists per miss
+    static_assert(ObjectPool::GRANULE >= sizeof(FreeNode) && ObjectPool::GRANULE % alignof(std::max_align_t) == 0,
+                  "Pool granule must hold a free-list link and keep max alignment");
+
+    // Free lists plus a bump region; one per thread and one shared
+    struct FreeLists {
+        FreeNode* free_lists[CLASS_COUNT] = {};
+        char* cursor = nullptr;
+        std::size_t remaining = 0;
+    };
+
+    struct SharedState {
+        std::mutex mutex;
+        FreeLists lists;
+        std::vector<char*> blocks;
+    };
+
+    // Never destroyed: objects owned by static Circuits may be released during exit
+    SharedState& shared() {
+        static SharedState* s = new SharedState;
+        return *s;
+    }
+
+    std::size_t classIndex(std::size_t size) {
+        return (size == 0) ? 0 : (size - 1) / ObjectPool::GRANULE;
+    }
+
+    void push(FreeLists& lists, std::size_t index, void* p) {
+        FreeNode* node = static_cast<FreeNode*>(p);
+        node->next = lists.free_lists[index];
+        lists.free_lists[index] = node;
+    }
+
+    // Hands what is left of the bump region to the free lists
+    void retireTail(FreeLists& lists) {
+        while (lists.remaining >= ObjectPool::GRANULE) {
+            const std::size_t index = classIndex(lists.remaining < ObjectPool::MAX_POOLED_SIZE ? lists.remaining : ObjectPool::MAX_POOLED_SIZE);
+            const std::size_t size = (index + 1) * ObjectPool::GRANULE;
+            push(lists, index, lists.cursor);
+            lists.cursor += size;
+            lists.remaining -= size;
+        }
+        lists.cursor = nullptr;
+        lists.remaining = 0;
+    }
+
+    // Gives a thread's lists back to the shared state when the thread exits
+    struct ThreadCache {
+        FreeLists lists;
+        ~ThreadCache();
+    };
+    thread_local bool thread_cache_gone = false; // Trivial, so still readable during thread exit
+
+    ThreadCache* threadCache() {
+        if (thread_cache_gone) return nullptr;
+        thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    ThreadCache::~ThreadCache() {
+        thread_cache_gone = true;
+        retireTail(lists);
+        SharedState& s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (std::size_t index = 0; index < CLASS_COUNT; ++index) {
+            while (FreeNode* node = lists.free_lists[index]) {
+                lists.free_lists[index] = node->next;
+                push(s.lists, index, node);
+            }
+        }
+    }
+
+    void* carve(FreeLists& lists, std::size_t rounded, SharedState& s) {
+        if (lists.remaining < rounded) {
+            retireTail(lists);
+            char* block = static_cast<char*>(::operator new(ObjectPool::BLOCK_SIZE));
+            s.blocks.push_back(block);
+            lists.cursor = block;
+            lists.remaining = ObjectPool::BLOCK_SIZE;
+        }
+        void* p = lists.cursor;
+        lists.cursor += rounded;
+        lists.remaining -= rounded;
+        return p;
+    }
+}
+
+// --- ObjectPool Implementation ---
+void* ObjectPool::allocate(std::size_t size) {
+    if (size > MAX_POOLED_SIZE) return ::operator new(size);
+    const std::size_t index = classIndex(size);
+    const std::size_t rounded = (index + 1) * GRANULE;
+    SharedState& s = shared();
+
+    ThreadCache* cache = threadCache();
+    if (!cache) {
+        // Thread is exiting: work on the shared lists directly
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (FreeNode* node = s.lists.free_lists[index]) {
+            s.lists.free_lists[index] = node->next;
+            return node;
+        }
+        return carve(s.lists, rounded, s);
+    }
+
+    FreeLists& local = cache->lists;
+    if (!local.free_lists[index]) {
+        // Refill a batch from nodes other threads gave back before carving new memory
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (std::size_t k = 0; k < REFILL_BATCH && s.lists.free_lists[index]; ++k) {
+            FreeNode* node = s.lists.free_lists[index];
+            s.lists.free_lists[index] = node->next;
+            push(local, index, node);
+        }
+        if (!local.free_lists[index] && local.remaining < rounded) return carve(local, rounded, s);
+    }
+    if (FreeNode* node = local.free_lists[index]) {
+        local.free_lists[index] = node->next;
+        return node;
+    }
+    return carve(local, rounded, s); // Fits the thread's current block, no lock needed
+}
+
+void ObjectPool::release(void* p, std::size_t size) {
+    if (!p) return;
+    if (size > MAX_POOLED_SIZE) { ::operator delete(p); return; }
+    const std::size_t index = classIndex(size);
+
+    if (ThreadCache* cache = threadCache()) {
+        push(cache->lists, index, p);
+        return;
+    }
+    SharedState& s = shared();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    push(s.lists, index, p);
+}
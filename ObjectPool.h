@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+
+// --- ObjectPool (Size-class pool for circuit objects) ---
+// Element and Node route their operator new/delete here. Requests are rounded
+// up to 16-byte classes and carved sequentially out of 64 KB blocks, so objects
+// created together (a netlist load, a project load) sit next to each other in
+// memory. Freed objects go onto a per-class free list and are handed out again
+// by the next allocation of that class, which makes Circuit::clear followed by
+// a reload reuse the same blocks instead of round-tripping through malloc.
+// Blocks are kept for the life of the process. Objects larger than
+// MAX_POOLED_SIZE go straight to the global allocator. Thread-safe.
+//
+// Each thread carves its own blocks and keeps its own free lists, so the
+// parser's worker threads build elements without contending on a lock. The
+// shared mutex is only taken to register a new block, to refill an empty
+// free list from the shared lists, and when a thread exits and hands its
+// lists and block tail back. An object freed on another thread joins that
+// thread's lists; memory moves between threads only through thread exit.
+class ObjectPool {
+public:
+    static constexpr std::size_t GRANULE = 16;
+    static constexpr std::size_t MAX_POOLED_SIZE = 1024;
+    static constexpr std::size_t BLOCK_SIZE = 64 * 1024;
+
+    static void* allocate(std::size_t size);
+    static void release(void* p, std::size_t size);
+};
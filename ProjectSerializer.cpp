@@ -1,26 +1,236 @@
 #include "ProjectSerializer.h"
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <algorithm>
+#include <filesystem>
+#include <cctype>
+#include <cstring>
 #include <cereal/archives/json.hpp>
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/external/rapidjson/stringbuffer.h>
+#include <cereal/external/rapidjson/writer.h>
+#include <iterator>
 
-void ProjectSerializer::save(const Circuit& circuit, const std::string& filepath) {
-    std::ofstream os(filepath);
-    if (!os.is_open()) throw std::runtime_error("Failed to open file for saving: " + filepath);
-    cereal::JSONOutputArchive archive(os);
-    archive(cereal::make_nvp("circuit_elements", circuit.getElements()),
-            cereal::make_nvp("ground_node", circuit.getGroundNodeId()));
+namespace {
+    const char BINARY_MAGIC[8] = {'C', 'K', 'T', 'P', 'R', 'O', 'J', '\0'};
+
+    // Installs a payload context for the current thread for one archive pass
+    class PayloadScope {
+        ProjectPayloadContext* previous;
+    public:
+        explicit PayloadScope(ProjectPayloadContext* context) : previous(ProjectPayloadContext::active()) {
+            ProjectPayloadContext::active() = context;
+        }
+        ~PayloadScope() { ProjectPayloadContext::active() = previous; }
+    };
+
+    // Samples are stored little-endian regardless of the host
+    void writeSamples(std::ostream& os, const std::vector<double>& samples) {
+        if (cereal::portable_binary_detail::is_little_endian()) {
+            os.write(reinterpret_cast<const char*>(samples.data()), static_cast<std::streamsize>(samples.size() * sizeof(double)));
+            return;
+        }
+        for (double v : samples) {
+            auto* bytes = reinterpret_cast<unsigned char*>(&v);
+            std::reverse(bytes, bytes + sizeof(double));
+            os.write(reinterpret_cast<const char*>(bytes), sizeof(double));
+        }
+    }
+
+    // JSON projects older than the sample-file version of WaveformVoltageSource carry
+    // no cereal_class_version, which cereal requires once a class is versioned. The
+    // version is read from the first instance of the type, so stamp it there: 1 if that
+    // source already has the sample-file fields, 0 for the inline-only layout.
+    std::string upgradeLegacyJson(const std::string& json) {
+        if (json.find("\"WaveformVoltageSource\"") == std::string::npos) return json;
+        CEREAL_RAPIDJSON_NAMESPACE::Document doc;
+        doc.Parse(json.c_str(), json.size());
+        if (doc.HasParseError() || !doc.IsObject()) return json;
+        auto elements = doc.FindMember("circuit_elements");
+        if (elements == doc.MemberEnd() || !elements->value.IsArray()) return json;
+        for (auto& element : elements->value.GetArray()) {
+            if (!element.IsObject()) continue;
+            auto type = element.FindMember("polymorphic_name");
+            if (type == element.MemberEnd() || !type->value.IsString() ||
+                std::strcmp(type->value.GetString(), "WaveformVoltageSource") != 0) continue;
+            auto wrapper = element.FindMember("ptr_wrapper");
+            if (wrapper == element.MemberEnd() || !wrapper->value.IsObject()) return json;
+            auto data = wrapper->value.FindMember("data");
+            if (data == wrapper->value.MemberEnd() || !data->value.IsObject()) return json;
+            if (data->value.HasMember("cereal_class_version")) return json;
+            // First member: the unnamed base-class entry that follows is read by position
+            auto& allocator = doc.GetAllocator();
+            CEREAL_RAPIDJSON_NAMESPACE::Value upgraded(CEREAL_RAPIDJSON_NAMESPACE::kObjectType);
+            upgraded.AddMember("cereal_class_version", data->value.HasMember("sample_file") ? 1u : 0u, allocator);
+            for (auto& member : data->value.GetObject()) upgraded.AddMember(member.name, member.value, allocator);
+            data->value = upgraded;
+            CEREAL_RAPIDJSON_NAMESPACE::StringBuffer buffer;
+            CEREAL_RAPIDJSON_NAMESPACE::Writer<CEREAL_RAPIDJSON_NAMESPACE::StringBuffer> writer(buffer);
+            doc.Accept(writer);
+            return std::string(buffer.GetString(), buffer.GetSize());
+        }
+        return json;
+    }
+
+    std::vector<double> readSamples(std::istream& is, uint64_t size) {
+        std::vector<double> samples(size / sizeof(double));
+        is.read(reinterpret_cast<char*>(samples.data()), static_cast<std::streamsize>(samples.size() * sizeof(double)));
+        if (!is) throw std::runtime_error("Truncated waveform sample chunk.");
+        if (!cereal::portable_binary_detail::is_little_endian()) {
+            for (double& v : samples) {
+                auto* bytes = reinterpret_cast<unsigned char*>(&v);
+                std::reverse(bytes, bytes + sizeof(double));
+            }
+        }
+        return samples;
+    }
 }
 
-void ProjectSerializer::load(Circuit& circuit, const std::string& filepath) {
-    std::ifstream is(filepath);
-    if (!is.is_open()) throw std::runtime_error("Failed to open file for loading: " + filepath);
-    cereal::JSONInputArchive archive(is);
+ProjectSerializer::Format ProjectSerializer::formatForPath(const std::string& filepath) {
+    std::string lower = filepath;
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    const std::string ext = ".json";
+    bool is_json = lower.size() >= ext.size() && lower.compare(lower.size() - ext.size(), ext.size(), ext) == 0;
+    return is_json ? Format::JSON : Format::BINARY;
+}
+
+std::string ProjectSerializer::encode(const Circuit& circuit, Format format) {
+    std::ostringstream os(std::ios::out | std::ios::binary);
+    if (format == Format::JSON) {
+        {
+            cereal::JSONOutputArchive archive(os);
+            archive(cereal::make_nvp("circuit_elements", circuit.getElements()),
+                    cereal::make_nvp("ground_node", circuit.getGroundNodeId()));
+        }
+        return os.str();
+    }
+
+    // Topology first; waveform samples are collected as payloads on the way
+    ProjectPayloadContext payloads;
+    std::ostringstream topology(std::ios::out | std::ios::binary);
+    {
+        PayloadScope scope(&payloads);
+        cereal::PortableBinaryOutputArchive archive(topology);
+        archive(circuit.getElements(), circuit.getGroundNodeId());
+    }
+    const std::string topology_bytes = topology.str();
+
+    std::vector<ProjectChunk> toc;
+    toc.push_back({"TOPO", 0, topology_bytes.size()});
+    uint64_t offset = topology_bytes.size();
+    for (const auto* samples : payloads.outgoing) {
+        const uint64_t size = samples->size() * sizeof(double);
+        toc.push_back({"SMPL", offset, size});
+        offset += size;
+    }
+
+    os.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    {
+        cereal::PortableBinaryOutputArchive archive(os);
+        archive(BINARY_VERSION, toc);
+    }
+    os.write(topology_bytes.data(), static_cast<std::streamsize>(topology_bytes.size()));
+    for (const auto* samples : payloads.outgoing) writeSamples(os, *samples);
+    return os.str();
+}
+
+void ProjectSerializer::read(Circuit& circuit, std::istream& is, const std::string& source, const std::string& file_path) {
     std::vector<std::unique_ptr<Element>> loaded_elements;
     std::string loaded_ground_node_id;
-    archive(loaded_elements, loaded_ground_node_id);
+
+    char magic[sizeof(BINARY_MAGIC)] = {};
+    is.read(magic, sizeof(magic));
+    if (is.gcount() == sizeof(magic) && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0) {
+        uint32_t version = 0;
+        std::vector<ProjectChunk> toc;
+        {
+            cereal::PortableBinaryInputArchive archive(is);
+            archive(version);
+            if (version > BINARY_VERSION) {
+                throw std::runtime_error("Project " + source + " uses binary format version " + std::to_string(version) +
+                                         ", newer than supported (" + std::to_string(BINARY_VERSION) + ").");
+            }
+            if (version < 3) {
+                // Versions 1 and 2 predate class versioning and cannot be told apart from it
+                throw std::runtime_error("Project " + source + " uses pre-release binary format version " +
+                                         std::to_string(version) + "; re-save it as JSON with the build that wrote it.");
+            }
+            archive(toc);
+        }
+
+        const uint64_t data_start = static_cast<uint64_t>(is.tellg());
+        const ProjectChunk* topology = nullptr;
+        ProjectPayloadContext payloads;
+        DeferredSamples stamp;
+        if (!file_path.empty()) {
+            stamp.path = std::filesystem::absolute(file_path).string();
+            stamp.file_size = std::filesystem::file_size(file_path);
+            stamp.file_time = std::filesystem::last_write_time(file_path).time_since_epoch().count();
+        }
+        for (const auto& chunk : toc) {
+            if (chunk.tag == "TOPO") {
+                topology = &chunk;
+            } else if (chunk.tag == "SMPL") {
+                if (file_path.empty()) {
+                    is.seekg(static_cast<std::streamoff>(data_start + chunk.offset));
+                    payloads.decoded.push_back(readSamples(is, chunk.size));
+                } else {
+                    DeferredSamples location = stamp;
+                    location.offset = data_start + chunk.offset;
+                    location.count = chunk.size / sizeof(double);
+                    payloads.locations.push_back(std::move(location));
+                }
+            }
+        }
+        if (!topology) throw std::runtime_error("Project " + source + " has no topology chunk.");
+
+        is.seekg(static_cast<std::streamoff>(data_start + topology->offset));
+        PayloadScope scope(&payloads);
+        cereal::PortableBinaryInputArchive archive(is);
+        archive(loaded_elements, loaded_ground_node_id);
+    } else {
+        is.clear();
+        is.seekg(0);
+        std::istringstream json(upgradeLegacyJson(std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>())));
+        cereal::JSONInputArchive archive(json);
+        archive(loaded_elements, loaded_ground_node_id);
+    }
+
     circuit.clear();
-    for (auto& elem : loaded_elements) {
-        circuit.addElement(std::move(elem));
+    // One duplicate-name pass for the whole project instead of a scan per element
+    size_t added = circuit.addElements(loaded_elements);
+    if (added < loaded_elements.size()) {
+        const std::string name = loaded_elements[added] ? loaded_elements[added]->getName() : "<null>";
+        throw std::runtime_error("Project " + source + " contains duplicate element '" + name + "'.");
     }
     circuit.setGroundNode(loaded_ground_node_id);
 }
+
+void ProjectSerializer::save(const Circuit& circuit, const std::string& filepath) {
+    save(circuit, filepath, formatForPath(filepath));
+}
+
+void ProjectSerializer::save(const Circuit& circuit, const std::string& filepath, Format format) {
+    // Encoded before the file is opened: deferred samples may still live in the file being replaced
+    const std::string data = encode(circuit, format);
+    std::ofstream os(filepath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!os.is_open()) throw std::runtime_error("Failed to open file for saving: " + filepath);
+    os.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!os) throw std::runtime_error("Failed to write project file: " + filepath);
+}
+
+void ProjectSerializer::load(Circuit& circuit, const std::string& filepath) {
+    std::ifstream is(filepath, std::ios::in | std::ios::binary);
+    if (!is.is_open()) throw std::runtime_error("Failed to open file for loading: " + filepath);
+    read(circuit, is, filepath, filepath);
+}
+
+std::string ProjectSerializer::saveToString(const Circuit& circuit, Format format) {
+    return encode(circuit, format);
+}
+
+void ProjectSerializer::loadFromString(Circuit& circuit, const std::string& data) {
+    std::istringstream is(data, std::ios::in | std::ios::binary);
+    read(circuit, is, "snapshot", "");
+}
@@ -1,10 +1,46 @@
 #pragma once
 #include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
 #include "Circuit.h"
 
+// --- Project chunk (table-of-contents entry of a binary project) ---
+struct ProjectChunk {
+    std::string tag;     // "TOPO" elements and parameters, "SMPL" one waveform's samples
+    uint64_t offset = 0; // From the end of the table of contents
+    uint64_t size = 0;
+
+    template<class Archive>
+    void serialize(Archive& archive) { archive(CEREAL_NVP(tag), CEREAL_NVP(offset), CEREAL_NVP(size)); }
+};
+
 // Class for saving and loading circuit projects using Cereal
+// Projects are stored in a compact chunked binary form unless the file name ends
+// in ".json", which selects the JSON archive for interchange. A binary project is
+// a magic/version header and a table of contents followed by the chunks: the
+// topology chunk (cereal portable binary) is read on load, waveform sample
+// chunks are only read when a source first needs its samples. load() detects
+// the format from the file contents. Saving, to a file or a snapshot string,
+// reads any still-deferred samples first, so the result never refers back to
+// the file the project was loaded from.
 class ProjectSerializer {
 public:
+    enum class Format { BINARY, JSON };
+    static constexpr uint32_t BINARY_VERSION = 3;
+
     static void save(const Circuit& circuit, const std::string& filepath);
     static void load(Circuit& circuit, const std::string& filepath);
+    static void save(const Circuit& circuit, const std::string& filepath, Format format);
+
+    // In-memory snapshots (undo/redo) without touching the file system
+    static std::string saveToString(const Circuit& circuit, Format format = Format::BINARY);
+    static void loadFromString(Circuit& circuit, const std::string& data);
+
+    static Format formatForPath(const std::string& filepath);
+
+private:
+    static std::string encode(const Circuit& circuit, Format format);
+    // file_path is empty for in-memory sources, whose samples are decoded eagerly
+    static void read(Circuit& circuit, std::istream& is, const std::string& source, const std::string& file_path);
 };
@@ -0,0 +1,182 @@
+#include "ResultCache.h"
+#include "ErrorManager.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <typeinfo>
+#include <cereal/archives/portable_binary.hpp>
+#include <cereal/types/map.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/string.hpp>
+
+namespace {
+    constexpr uint64_t FNV_OFFSET = 14695981039346656037ull;
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+
+    void hashBytes(uint64_t& h, const void* data, size_t size) {
+        const auto* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= bytes[i];
+            h *= FNV_PRIME;
+        }
+    }
+
+    void hashString(uint64_t& h, const std::string& s) {
+        const uint64_t size = s.size(); // Length prefix keeps adjacent fields apart
+        hashBytes(h, &size, sizeof(size));
+        hashBytes(h, s.data(), s.size());
+    }
+}
+
+ResultCache::ResultCache(size_t capacity_bytes) : capacity_bytes(capacity_bytes) {}
+
+uint64_t ResultCache::contentHash(const Circuit& circuit) {
+    std::vector<const std::unique_ptr<Element>*> sorted;
+    sorted.reserve(circuit.getElements().size());
+    for (const auto& elem : circuit.getElements()) {
+        if (elem->getType() == "WirelessVoltageSource") return 0;
+        sorted.push_back(&elem);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](auto* a, auto* b) { return (*a)->getName() < (*b)->getName(); });
+
+    uint64_t h = FNV_OFFSET;
+    std::ostringstream os(std::ios::out | std::ios::binary);
+    for (const auto* elem : sorted) {
+        os.str("");
+        {
+            cereal::PortableBinaryOutputArchive archive(os);
+            archive(*elem);
+        }
+        hashString(h, os.str());
+        if ((*elem)->getType() == "WaveformVoltageSource") {
+            const auto& wave = static_cast<const WaveformVoltageSource&>(**elem);
+            if (wave.isStreamed()) {
+                // The samples live in an external file: key on its identity
+                std::error_code ec;
+                const uint64_t size = std::filesystem::file_size(wave.getSampleFile(), ec);
+                const int64_t time = std::filesystem::last_write_time(wave.getSampleFile(), ec).time_since_epoch().count();
+                hashBytes(h, &size, sizeof(size));
+                hashBytes(h, &time, sizeof(time));
+            }
+        }
+    }
+    os.str("");
+    {
+        cereal::PortableBinaryOutputArchive archive(os);
+        archive(circuit.getModelCards(), circuit.getGroundNodeId());
+    }
+    hashString(h, os.str());
+    return (h == 0) ? 1 : h;
+}
+
+uint64_t ResultCache::key(const Circuit& circuit, const Analyzer& analysis, const LinearSolver& solver) {
+    const std::string settings = analysis.getSettingsKey();
+    if (settings.empty()) return 0;
+    const uint64_t content = contentHash(circuit);
+    if (content == 0) return 0;
+    uint64_t h = content;
+    hashString(h, settings);
+    hashString(h, typeid(solver).name());
+    hashString(h, solver.getConfigKey());
+    return (h == 0) ? 1 : h;
+}
+
+bool ResultCache::analyze(Analyzer& analysis, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver) {
+    const uint64_t k = key(circuit, analysis, solver);
+    if (k != 0) {
+        if (auto cached = find(k, analysis.getSettingsKey())) {
+            analysis.importResults(*cached);
+            ErrorManager::info("[ResultCache] hit for " + cached->analysis);
+            return true;
+        }
+    }
+    analysis.analyze(circuit, mna, solver);
+    if (k != 0) {
+        auto result = std::make_shared<CachedResult>();
+        analysis.exportResults(*result);
+        // A run that failed or stopped early is not cached, so a rerun reports it again
+        if (result->complete) store(k, std::move(result));
+    }
+    return false;
+}
+
+std::shared_ptr<const CachedResult> ResultCache::find(uint64_t key, const std::string& settings_key) {
+    auto it = index.find(key);
+    if (it != index.end() && it->second->result->analysis == settings_key) {
+        lru.splice(lru.begin(), lru, it->second);
+        ++hit_count;
+        return it->second->result;
+    }
+    if (!disk_directory.empty()) {
+        std::ifstream is(diskPath(key), std::ios::in | std::ios::binary);
+        if (is.is_open()) {
+            try {
+                uint64_t stored_key = 0;
+                auto result = std::make_shared<CachedResult>();
+                cereal::PortableBinaryInputArchive archive(is);
+                archive(stored_key, *result);
+                if (stored_key == key && result->analysis == settings_key) {
+                    insert(key, result);
+                    ++hit_count;
+                    return result;
+                }
+            } catch (const std::exception& e) {
+                ErrorManager::warn("[ResultCache] ignoring unreadable " + diskPath(key) + ": " + e.what());
+            }
+        }
+    }
+    ++miss_count;
+    return nullptr;
+}
+
+void ResultCache::store(uint64_t key, std::shared_ptr<const CachedResult> result) {
+    if (!result) return;
+    if (!disk_directory.empty()) {
+        std::ofstream os(diskPath(key), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (os.is_open()) {
+            cereal::PortableBinaryOutputArchive archive(os);
+            archive(key, *result);
+        } else {
+            ErrorManager::warn("[ResultCache] could not write " + diskPath(key));
+        }
+    }
+    insert(key, std::move(result));
+}
+
+void ResultCache::insert(uint64_t key, std::shared_ptr<const CachedResult> result) {
+    auto existing = index.find(key);
+    if (existing != index.end()) {
+        used_bytes -= existing->second->bytes;
+        lru.erase(existing->second);
+        index.erase(existing);
+    }
+    const size_t bytes = result->byteSize();
+    if (bytes > capacity_bytes) return; // Would evict everything else; disk copy only
+    lru.push_front({key, std::move(result), bytes});
+    index[key] = lru.begin();
+    used_bytes += bytes;
+    while (used_bytes > capacity_bytes) {
+        used_bytes -= lru.back().bytes;
+        index.erase(lru.back().key);
+        lru.pop_back();
+    }
+}
+
+std::string ResultCache::diskPath(uint64_t key) const {
+    std::stringstream ss;
+    ss << std::hex << std::setw(16) << std::setfill('0') << key << ".res";
+    return (std::filesystem::path(disk_directory) / ss.str()).string();
+}
+
+void ResultCache::setDiskDirectory(const std::string& directory) {
+    disk_directory = directory;
+    if (!directory.empty()) std::filesystem::create_directories(directory);
+}
+
+void ResultCache::clear() {
+    lru.clear();
+    index.clear();
+    used_bytes = 0;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <string>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "Analyzers.h"
+
+// --- ResultCache (Analysis results keyed by circuit content) ---
+// A result is filed under a 64-bit FNV-1a hash of the circuit's canonical
+// content, the analysis settings key and the solver's type and configuration
+// (LinearSolver::getConfigKey). Only complete runs are stored. Canonical content is
+// every element's serialised form in name order (so insertion order and
+// deletions do not matter), the model cards and the ground node; streamed
+// waveform files add their size and write time. Circuits with wireless
+// sources are never cached because their inputs live outside the project.
+// Results are held in an LRU bounded by bytes and, when a directory is set,
+// also written to <directory>/<key>.res so they survive restarts.
+class ResultCache {
+private:
+    struct Entry {
+        uint64_t key;
+        std::shared_ptr<const CachedResult> result;
+        size_t bytes;
+    };
+    std::list<Entry> lru; // Most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    size_t capacity_bytes;
+    size_t used_bytes = 0;
+    size_t hit_count = 0, miss_count = 0;
+    std::string disk_directory;
+
+    void insert(uint64_t key, std::shared_ptr<const CachedResult> result);
+    std::string diskPath(uint64_t key) const;
+
+public:
+    explicit ResultCache(size_t capacity_bytes = 256u * 1024 * 1024);
+
+    // Canonical content hash, 0 when the circuit cannot be cached
+    static uint64_t contentHash(const Circuit& circuit);
+    // 0 when either the circuit or the analysis cannot be cached
+    static uint64_t key(const Circuit& circuit, const Analyzer& analysis, const LinearSolver& solver);
+
+    // Imports a cached result into `analysis` or runs it and stores the result; true on a hit
+    bool analyze(Analyzer& analysis, Circuit& circuit, MNAMatrix& mna, const LinearSolver& solver);
+
+    std::shared_ptr<const CachedResult> find(uint64_t key, const std::string& settings_key);
+    void store(uint64_t key, std::shared_ptr<const CachedResult> result);
+
+    // Empty disables the on-disk store
+    void setDiskDirectory(const std::string& directory);
+    void clear(); // In-memory entries only
+
+    size_t size() const { return lru.size(); }
+    size_t bytes() const { return used_bytes; }
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+};
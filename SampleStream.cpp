@@ -0,0 +1,147 @@
+#include "SampleStream.h"
+#include "ErrorManager.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+
+#ifdef _WIN32
+    #ifndef NOMINMAX
+    #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+// --- MappedFile Implementation ---
+MappedFile::MappedFile(const std::string& path) {
+#ifdef _WIN32
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (h == INVALID_HANDLE_VALUE) throw std::runtime_error("Could not open sample file: " + path);
+    file_handle = h;
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(h, &file_size)) { close(); throw std::runtime_error("Could not stat sample file: " + path); }
+    length = static_cast<size_t>(file_size.QuadPart);
+    if (length == 0) return;
+    HANDLE m = CreateFileMappingA(h, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) { close(); throw std::runtime_error("Could not map sample file: " + path); }
+    mapping_handle = m;
+    bytes = static_cast<const unsigned char*>(MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0));
+    if (!bytes) { close(); throw std::runtime_error("Could not map sample file: " + path); }
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Could not open sample file: " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(); throw std::runtime_error("Could not stat sample file: " + path); }
+    length = static_cast<size_t>(st.st_size);
+    if (length == 0) return;
+    void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) { close(); throw std::runtime_error("Could not map sample file: " + path); }
+    madvise(p, length, MADV_SEQUENTIAL);
+    bytes = static_cast<const unsigned char*>(p);
+#endif
+}
+
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (bytes) UnmapViewOfFile(bytes);
+    if (mapping_handle) CloseHandle(static_cast<HANDLE>(mapping_handle));
+    if (file_handle) CloseHandle(static_cast<HANDLE>(file_handle));
+    mapping_handle = nullptr;
+    file_handle = nullptr;
+#else
+    if (bytes) munmap(const_cast<unsigned char*>(bytes), length);
+    if (fd >= 0) ::close(fd);
+    fd = -1;
+#endif
+    bytes = nullptr;
+    length = 0;
+}
+
+// --- SampleStream Implementation ---
+SampleStream::SampleStream(const std::string& path, Format format) : file(path), format(format) {
+    const size_t width = (format == Format::F32) ? sizeof(float) : sizeof(double);
+    if (file.size() % width != 0) {
+        ErrorManager::warn("[SampleStream] " + path + " size is not a multiple of the sample width; trailing bytes ignored");
+    }
+    count = file.size() / width;
+    if (count == 0) throw std::runtime_error("Sample file contains no samples: " + path);
+    ErrorManager::info("[SampleStream] mapped " + path + " (" + std::to_string(count) + " samples, " + formatName(format) + ")");
+}
+
+SampleStream::Format SampleStream::parseFormat(const std::string& name) {
+    std::string upper = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    if (upper == "F64" || upper.empty()) return Format::F64;
+    if (upper == "F32") return Format::F32;
+    throw std::runtime_error("Unknown sample format '" + name + "'. Expected F32 or F64.");
+}
+
+std::string SampleStream::formatName(Format format) {
+    return format == Format::F32 ? "F32" : "F64";
+}
+
+void SampleStream::fillWindow(size_t first) {
+    const size_t n = std::min(WINDOW_SIZE, count - first);
+    window.resize(n);
+    window_begin = first;
+    const unsigned char* src = file.data();
+    // memcpy per sample: mapped data carries no alignment guarantee
+    if (format == Format::F64) {
+        for (size_t i = 0; i < n; ++i) std::memcpy(&window[i], src + (first + i) * sizeof(double), sizeof(double));
+    } else {
+        for (size_t i = 0; i < n; ++i) {
+            float f;
+            std::memcpy(&f, src + (first + i) * sizeof(float), sizeof(float));
+            window[i] = f;
+        }
+    }
+}
+
+double SampleStream::sample(size_t k) {
+    if (k >= count) k = count - 1;
+    if (window.empty() || k < window_begin || k >= window_begin + window.size()) {
+        // Keep a quarter window of look-behind for the resampling kernel
+        const size_t back = WINDOW_SIZE / 4;
+        fillWindow(k > back ? k - back : 0);
+    }
+    return window[k - window_begin];
+}
+
+double SampleStream::valueAt(double sample_index, double decimation_ratio) {
+    if (sample_index <= 0.0) return sample(0);
+    const double last = static_cast<double>(count - 1);
+    if (sample_index >= last) return sample(count - 1);
+
+    const long base = static_cast<long>(sample_index);
+    if (decimation_ratio <= 1.0) {
+        const double fraction = sample_index - base;
+        const double a = sample(static_cast<size_t>(base));
+        const double b = sample(static_cast<size_t>(base) + 1);
+        return a * (1.0 - fraction) + b * fraction;
+    }
+
+    // Band-limited interpolation: cutoff at the simulator's Nyquist frequency
+    const double cutoff = 1.0 / decimation_ratio; // Fraction of the source Nyquist
+    const long half_width = std::min(MAX_KERNEL_HALF_WIDTH, static_cast<long>(std::ceil(KERNEL_ZERO_CROSSINGS * decimation_ratio)));
+    double acc = 0.0, weight_sum = 0.0;
+    for (long k = base - half_width + 1; k <= base + half_width; ++k) {
+        const double x = sample_index - static_cast<double>(k);
+        if (std::abs(x) >= half_width) continue;
+        const double arg = M_PI * cutoff * x;
+        const double sinc = (arg == 0.0) ? 1.0 : std::sin(arg) / arg;
+        const double hann = 0.5 * (1.0 + std::cos(M_PI * x / half_width));
+        const double w = sinc * hann;
+        const long idx = std::min(std::max(k, 0L), static_cast<long>(count - 1)); // Hold the end samples
+        acc += w * sample(static_cast<size_t>(idx));
+        weight_sum += w;
+    }
+    return (weight_sum != 0.0) ? acc / weight_sum : sample(static_cast<size_t>(base));
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+// --- MappedFile (Read-only memory map) ---
+// Maps a whole file into the address space; pages are only faulted in when a
+// window touching them is decoded, so multi-hundred-MB stimulus files cost
+// nothing until the simulation reaches them.
+class MappedFile {
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+    void close();
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
+
+// --- SampleStream (Windowed reader for binary waveform files) ---
+// Raw little-endian samples (F64 = double, F32 = float), no header. Samples are
+// decoded on demand into a sliding window that follows simulation time. When
+// the simulator step is coarser than the sample period, values are taken
+// through a Hann-windowed sinc low-pass at the simulator's Nyquist rate so the
+// stimulus is band-limited instead of aliased; otherwise samples are linearly
+// interpolated exactly like an in-memory WaveformVoltageSource.
+class SampleStream {
+public:
+    enum class Format { F64, F32 };
+
+private:
+    MappedFile file;
+    Format format;
+    size_t count = 0;
+
+    std::vector<double> window;
+    size_t window_begin = 0;
+
+    static constexpr size_t WINDOW_SIZE = 16384;
+    static constexpr double KERNEL_ZERO_CROSSINGS = 8.0;
+    static constexpr long MAX_KERNEL_HALF_WIDTH = 2048;
+
+    void fillWindow(size_t first);
+
+public:
+    SampleStream(const std::string& path, Format format);
+
+    static Format parseFormat(const std::string& name);
+    static std::string formatName(Format format);
+
+    size_t size() const { return count; }
+    double sample(size_t k);
+    // Value at a fractional sample index; decimation_ratio = simulator step * sampling rate.
+    double valueAt(double sample_index, double decimation_ratio);
+};
@@ -5,6 +5,8 @@
 #include <sstream>
 #include <cmath>
 #include <limits>
+#include <stdexcept>
+#include <cctype>
 
 // --- SignalProcessor Implementation ---
 
@@ -391,6 +393,332 @@ double SignalProcessor::linearInterpolation(double x1, double y1, double x2, dou
     return y1 + (y2 - y1) * (x - x1) / (x2 - x1);
 }
 
+// --- ExpressionTape Implementation ---
+class ExpressionCompiler {
+private:
+    const std::string& src;
+    size_t pos = 0;
+    ExpressionTape& tape;
+    size_t depth = 0;
+
+    [[noreturn]] void fail(const std::string& message) const {
+        throw std::runtime_error("Expression error at column " + std::to_string(pos + 1) + ": " + message + " in '" + src + "'");
+    }
+    void skipSpaces() {
+        while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos]))) ++pos;
+    }
+    bool accept(char c) {
+        skipSpaces();
+        if (pos < src.size() && src[pos] == c) { ++pos; return true; }
+        return false;
+    }
+    void expect(char c) {
+        if (!accept(c)) fail(std::string("expected '") + c + "'");
+    }
+    void emit(ExpressionTape::Op op, double value = 0.0, int slot = -1) {
+        using Op = ExpressionTape::Op;
+        if (op == Op::CONST || op == Op::VAR) {
+            tape.max_depth = std::max(tape.max_depth, ++depth);
+        } else if (op == Op::ADD || op == Op::SUB || op == Op::MUL || op == Op::DIV || op == Op::POW || op == Op::MIN || op == Op::MAX) {
+            --depth;
+        }
+        tape.code.push_back({op, value, slot});
+    }
+    void emitVariable(const std::string& name) {
+        auto it = std::find(tape.variables.begin(), tape.variables.end(), name);
+        int slot = static_cast<int>(it - tape.variables.begin());
+        if (it == tape.variables.end()) tape.variables.push_back(name);
+        emit(ExpressionTape::Op::VAR, 0.0, slot);
+    }
+
+    void parseExpression() {
+        parseTerm();
+        for (;;) {
+            if (accept('+')) { parseTerm(); emit(ExpressionTape::Op::ADD); }
+            else if (accept('-')) { parseTerm(); emit(ExpressionTape::Op::SUB); }
+            else return;
+        }
+    }
+    void parseTerm() {
+        parseUnary();
+        for (;;) {
+            if (accept('*')) { parseUnary(); emit(ExpressionTape::Op::MUL); }
+            else if (accept('/')) { parseUnary(); emit(ExpressionTape::Op::DIV); }
+            else return;
+        }
+    }
+    void parseUnary() {
+        if (accept('-')) { parseUnary(); emit(ExpressionTape::Op::NEG); return; }
+        if (accept('+')) { parseUnary(); return; }
+        parsePower();
+    }
+    void parsePower() {
+        parsePrimary();
+        if (accept('^')) { parseUnary(); emit(ExpressionTape::Op::POW); } // Right-associative
+    }
+    void parseNumber() {
+        size_t start = pos;
+        while (pos < src.size() && (std::isdigit(static_cast<unsigned char>(src[pos])) || src[pos] == '.')) ++pos;
+        if (pos < src.size() && (src[pos] == 'e' || src[pos] == 'E')) {
+            size_t p = pos + 1;
+            if (p < src.size() && (src[p] == '+' || src[p] == '-')) ++p;
+            if (p < src.size() && std::isdigit(static_cast<unsigned char>(src[p]))) {
+                pos = p;
+                while (pos < src.size() && std::isdigit(static_cast<unsigned char>(src[pos]))) ++pos;
+            }
+        }
+        double value;
+        try {
+            value = std::stod(src.substr(start, pos - start));
+        } catch (const std::exception&) {
+            fail("invalid number");
+        }
+        // Engineering suffix (case-insensitive), e.g. 10k, 2.2meg, 5u
+        size_t suffix_start = pos;
+        while (pos < src.size() && std::isalpha(static_cast<unsigned char>(src[pos]))) ++pos;
+        std::string suffix = src.substr(suffix_start, pos - suffix_start);
+        std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+        if (!suffix.empty()) {
+            static const std::map<std::string, double> multipliers = {
+                {"t", 1e12}, {"g", 1e9}, {"meg", 1e6}, {"k", 1e3}, {"m", 1e-3},
+                {"u", 1e-6}, {"n", 1e-9}, {"p", 1e-12}, {"f", 1e-15}};
+            auto it = multipliers.find(suffix);
+            if (it == multipliers.end()) { pos = suffix_start; fail("unknown suffix '" + suffix + "'"); }
+            value *= it->second;
+        }
+        emit(ExpressionTape::Op::CONST, value);
+    }
+    void parsePrimary() {
+        using Op = ExpressionTape::Op;
+        skipSpaces();
+        if (pos >= src.size()) fail("unexpected end of expression");
+        char c = src[pos];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') { parseNumber(); return; }
+        if (accept('(')) { parseExpression(); expect(')'); return; }
+        if (!(std::isalpha(static_cast<unsigned char>(c)) || c == '_')) fail(std::string("unexpected '") + c + "'");
+
+        size_t start = pos;
+        while (pos < src.size() && (std::isalnum(static_cast<unsigned char>(src[pos])) || src[pos] == '_')) ++pos;
+        std::string ident = src.substr(start, pos - start);
+        std::string lower = ident;
+        std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+        skipSpaces();
+        bool call = pos < src.size() && src[pos] == '(';
+        if (call && (lower == "v" || lower == "i")) {
+            // Probe variable: raw node/branch names up to ')'
+            ++pos;
+            size_t close = src.find(')', pos);
+            if (close == std::string::npos) fail("missing ')'");
+            std::vector<std::string> names;
+            std::stringstream ss(src.substr(pos, close - pos));
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                item.erase(0, item.find_first_not_of(" \t"));
+                item.erase(item.find_last_not_of(" \t") + 1);
+                if (item.empty()) fail("empty name in " + ident + "()");
+                names.push_back(item);
+            }
+            pos = close + 1;
+            const std::string prefix = (lower == "v") ? "V(" : "I(";
+            if (names.size() == 1) {
+                emitVariable(prefix + names[0] + ")");
+            } else if (names.size() == 2 && lower == "v") {
+                emitVariable(prefix + names[0] + ")");
+                emitVariable(prefix + names[1] + ")");
+                emit(Op::SUB);
+            } else {
+                fail("expected V(node), V(node,node) or I(branch)");
+            }
+            return;
+        }
+        if (call) {
+            static const std::map<std::string, Op> unary = {
+                {"sin", Op::SIN}, {"cos", Op::COS}, {"tan", Op::TAN}, {"exp", Op::EXP}, {"log", Op::LOG},
+                {"ln", Op::LOG}, {"log10", Op::LOG10}, {"sqrt", Op::SQRT}, {"abs", Op::ABS}, {"tanh", Op::TANH},
+                {"sinh", Op::SINH}, {"cosh", Op::COSH}, {"atan", Op::ATAN}};
+            static const std::map<std::string, Op> binary = {{"min", Op::MIN}, {"max", Op::MAX}, {"pow", Op::POW}};
+            expect('(');
+            auto u = unary.find(lower);
+            auto b = binary.find(lower);
+            if (u != unary.end()) {
+                parseExpression();
+                expect(')');
+                emit(u->second);
+            } else if (b != binary.end()) {
+                parseExpression();
+                expect(',');
+                parseExpression();
+                expect(')');
+                emit(b->second);
+            } else {
+                pos = start;
+                fail("unknown function '" + ident + "'");
+            }
+            return;
+        }
+        if (lower == "pi") { emit(Op::CONST, M_PI); return; }
+        if (lower == "e") { emit(Op::CONST, std::exp(1.0)); return; }
+        emitVariable(ident);
+    }
+
+public:
+    ExpressionCompiler(const std::string& source, ExpressionTape& target) : src(source), tape(target) {}
+
+    void run() {
+        skipSpaces();
+        if (pos >= src.size()) fail("empty expression");
+        parseExpression();
+        skipSpaces();
+        if (pos != src.size()) fail(std::string("unexpected '") + src[pos] + "'");
+    }
+};
+
+ExpressionTape ExpressionTape::compile(const std::string& expression) {
+    ExpressionTape tape;
+    ExpressionCompiler(expression, tape).run();
+    tape.value_stack.resize(tape.max_depth);
+    tape.grad_stack.resize(tape.max_depth * tape.variables.size());
+    return tape;
+}
+
+double ExpressionTape::evaluate(const double* inputs) const {
+    double* v = value_stack.data();
+    size_t sp = 0;
+    for (const auto& ins : code) {
+        switch (ins.op) {
+            case Op::CONST: v[sp++] = ins.value; break;
+            case Op::VAR:   v[sp++] = inputs[ins.slot]; break;
+            case Op::ADD:   --sp; v[sp - 1] += v[sp]; break;
+            case Op::SUB:   --sp; v[sp - 1] -= v[sp]; break;
+            case Op::MUL:   --sp; v[sp - 1] *= v[sp]; break;
+            case Op::DIV:   --sp; v[sp - 1] /= v[sp]; break;
+            case Op::POW:   --sp; v[sp - 1] = std::pow(v[sp - 1], v[sp]); break;
+            case Op::MIN:   --sp; v[sp - 1] = std::min(v[sp - 1], v[sp]); break;
+            case Op::MAX:   --sp; v[sp - 1] = std::max(v[sp - 1], v[sp]); break;
+            case Op::NEG:   v[sp - 1] = -v[sp - 1]; break;
+            case Op::SIN:   v[sp - 1] = std::sin(v[sp - 1]); break;
+            case Op::COS:   v[sp - 1] = std::cos(v[sp - 1]); break;
+            case Op::TAN:   v[sp - 1] = std::tan(v[sp - 1]); break;
+            case Op::EXP:   v[sp - 1] = std::exp(v[sp - 1]); break;
+            case Op::LOG:   v[sp - 1] = std::log(v[sp - 1]); break;
+            case Op::LOG10: v[sp - 1] = std::log10(v[sp - 1]); break;
+            case Op::SQRT:  v[sp - 1] = std::sqrt(v[sp - 1]); break;
+            case Op::ABS:   v[sp - 1] = std::abs(v[sp - 1]); break;
+            case Op::TANH:  v[sp - 1] = std::tanh(v[sp - 1]); break;
+            case Op::SINH:  v[sp - 1] = std::sinh(v[sp - 1]); break;
+            case Op::COSH:  v[sp - 1] = std::cosh(v[sp - 1]); break;
+            case Op::ATAN:  v[sp - 1] = std::atan(v[sp - 1]); break;
+        }
+    }
+    return v[0];
+}
+
+double ExpressionTape::evaluate(const double* inputs, double* gradient) const {
+    const size_t n = variables.size();
+    double* v = value_stack.data();
+    double* g = grad_stack.data(); // Row k holds d(v[k])/d(slots)
+    size_t sp = 0;
+    auto row = [g, n](size_t k) { return g + k * n; };
+    // Unary chain rule: g_top *= f'(a)
+    auto chain = [&](double dfda) {
+        double* ga = row(sp - 1);
+        for (size_t j = 0; j < n; ++j) ga[j] *= dfda;
+    };
+
+    for (const auto& ins : code) {
+        switch (ins.op) {
+            case Op::CONST:
+                v[sp] = ins.value;
+                std::fill(row(sp), row(sp) + n, 0.0);
+                ++sp;
+                break;
+            case Op::VAR:
+                v[sp] = inputs[ins.slot];
+                std::fill(row(sp), row(sp) + n, 0.0);
+                row(sp)[ins.slot] = 1.0;
+                ++sp;
+                break;
+            case Op::ADD: case Op::SUB: case Op::MUL: case Op::DIV: case Op::POW: case Op::MIN: case Op::MAX: {
+                --sp;
+                const double a = v[sp - 1], b = v[sp];
+                double* ga = row(sp - 1);
+                const double* gb = row(sp);
+                double r, da, db; // r = f(a,b), da = df/da, db = df/db
+                switch (ins.op) {
+                    case Op::ADD: r = a + b; da = 1.0; db = 1.0; break;
+                    case Op::SUB: r = a - b; da = 1.0; db = -1.0; break;
+                    case Op::MUL: r = a * b; da = b; db = a; break;
+                    case Op::DIV: r = a / b; da = 1.0 / b; db = -r / b; break;
+                    case Op::POW:
+                        r = std::pow(a, b);
+                        da = (b == 0.0) ? 0.0 : b * std::pow(a, b - 1.0);
+                        db = (a > 0.0) ? r * std::log(a) : 0.0;
+                        break;
+                    case Op::MIN: r = std::min(a, b); da = (a <= b) ? 1.0 : 0.0; db = 1.0 - da; break;
+                    default:      r = std::max(a, b); da = (a >= b) ? 1.0 : 0.0; db = 1.0 - da; break;
+                }
+                for (size_t j = 0; j < n; ++j) ga[j] = da * ga[j] + db * gb[j];
+                v[sp - 1] = r;
+                break;
+            }
+            case Op::NEG:   v[sp - 1] = -v[sp - 1]; chain(-1.0); break;
+            case Op::SIN:   chain(std::cos(v[sp - 1])); v[sp - 1] = std::sin(v[sp - 1]); break;
+            case Op::COS:   chain(-std::sin(v[sp - 1])); v[sp - 1] = std::cos(v[sp - 1]); break;
+            case Op::TAN:   v[sp - 1] = std::tan(v[sp - 1]); chain(1.0 + v[sp - 1] * v[sp - 1]); break;
+            case Op::EXP:   v[sp - 1] = std::exp(v[sp - 1]); chain(v[sp - 1]); break;
+            case Op::LOG:   chain(1.0 / v[sp - 1]); v[sp - 1] = std::log(v[sp - 1]); break;
+            case Op::LOG10: chain(1.0 / (v[sp - 1] * std::log(10.0))); v[sp - 1] = std::log10(v[sp - 1]); break;
+            case Op::SQRT:  v[sp - 1] = std::sqrt(v[sp - 1]); chain(v[sp - 1] > 0.0 ? 0.5 / v[sp - 1] : 0.0); break;
+            case Op::ABS:   chain(v[sp - 1] < 0.0 ? -1.0 : 1.0); v[sp - 1] = std::abs(v[sp - 1]); break;
+            case Op::TANH:  v[sp - 1] = std::tanh(v[sp - 1]); chain(1.0 - v[sp - 1] * v[sp - 1]); break;
+            case Op::SINH:  chain(std::cosh(v[sp - 1])); v[sp - 1] = std::sinh(v[sp - 1]); break;
+            case Op::COSH:  chain(std::sinh(v[sp - 1])); v[sp - 1] = std::cosh(v[sp - 1]); break;
+            case Op::ATAN:  chain(1.0 / (1.0 + v[sp - 1] * v[sp - 1])); v[sp - 1] = std::atan(v[sp - 1]); break;
+        }
+    }
+    std::copy(row(0), row(0) + n, gradient);
+    return v[0];
+}
+
+// --- SignalExpression Implementation ---
+SignalExpression::SignalExpression(const std::string& expr) : expression(expr) {
+    try {
+        tape = ExpressionTape::compile(expr);
+    } catch (const std::exception& e) {
+        compile_error = e.what();
+        ErrorManager::warn("[SignalExpression] " + compile_error);
+    }
+}
+
+void SignalExpression::setVariables(const std::map<std::string, std::vector<double>>& variables) {
+    signal_variables = variables;
+}
+
+std::vector<double> SignalExpression::evaluate() {
+    if (!compile_error.empty()) throw std::runtime_error(compile_error);
+    const auto& names = tape.getVariables();
+    std::vector<const std::vector<double>*> columns;
+    size_t length = names.empty() ? 1 : std::numeric_limits<size_t>::max();
+    for (const auto& name : names) {
+        auto it = signal_variables.find(name);
+        if (it == signal_variables.end()) throw std::runtime_error("Unknown signal '" + name + "' in expression '" + expression + "'");
+        columns.push_back(&it->second);
+        length = std::min(length, it->second.size());
+    }
+    std::vector<double> result(length);
+    std::vector<double> inputs(names.size());
+    for (size_t i = 0; i < length; ++i) {
+        for (size_t k = 0; k < columns.size(); ++k) inputs[k] = (*columns[k])[i];
+        result[i] = tape.evaluate(inputs.data());
+    }
+    return result;
+}
+
+std::vector<std::string> SignalExpression::getVariableNames() const { return tape.getVariables(); }
+
+bool SignalExpression::isValid() const { return compile_error.empty(); }
+
 // --- MathOperationManager Implementation ---
 
 void MathOperationManager::addDerivedSignal(const std::string& name, const std::vector<double>& signal, 
@@ -161,16 +161,75 @@ private:
     static double linearInterpolation(double x1, double y1, double x2, double y2, double x);
 };
 
+/**
+ * @brief Expression compiled to a postfix tape with forward-mode derivatives
+ *
+ * Grammar: + - * / ^ (right-associative), unary minus, parentheses, numbers with
+ * engineering suffixes (k, meg, m, u, n, p, ...), constants pi and e, functions
+ * sin cos tan exp log ln log10 sqrt abs tanh sinh cosh atan min max pow.
+ * Any other identifier or call of the form V(a), V(a,b) or I(name) is a
+ * variable. V(a,b) compiles to V(a) - V(b). Each distinct variable gets a slot
+ * in order of first appearance.
+ *
+ * evaluate() walks the tape once and carries a gradient alongside every value
+ * (dual numbers), so callers get exact partial derivatives with respect to all
+ * slots without finite differences or re-parsing.
+ */
+class ExpressionTape {
+public:
+    enum class Op {
+        CONST, VAR, ADD, SUB, MUL, DIV, POW, NEG,
+        SIN, COS, TAN, EXP, LOG, LOG10, SQRT, ABS, TANH, SINH, COSH, ATAN, MIN, MAX
+    };
+    struct Instruction {
+        Op op;
+        double value; // CONST
+        int slot;     // VAR
+    };
+
+private:
+    std::vector<Instruction> code;
+    std::vector<std::string> variables;
+    size_t max_depth = 0;
+    mutable std::vector<double> value_stack; // Evaluation scratch
+    mutable std::vector<double> grad_stack;
+
+    friend class ExpressionCompiler;
+
+public:
+    /**
+     * @brief Compile an expression; throws std::runtime_error with the column of the error
+     */
+    static ExpressionTape compile(const std::string& expression);
+
+    bool empty() const { return code.empty(); }
+    const std::vector<std::string>& getVariables() const { return variables; }
+    const std::vector<Instruction>& getCode() const { return code; }
+
+    /**
+     * @brief Value at the given slot values
+     */
+    double evaluate(const double* inputs) const;
+
+    /**
+     * @brief Value and gradient (one entry per variable slot) at the given slot values
+     */
+    double evaluate(const double* inputs, double* gradient) const;
+};
+
 /**
  * @brief Expression evaluator for mathematical signal operations
  * 
  * Allows users to define mathematical expressions like "V(N1) + 2*V(N2) - 0.5"
- * and evaluate them on signal data.
+ * and evaluate them on signal data. The expression is compiled once into an
+ * ExpressionTape and evaluated sample by sample.
  */
 class SignalExpression {
 private:
     std::string expression;
     std::map<std::string, std::vector<double>> signal_variables;
+    ExpressionTape tape;
+    std::string compile_error;
     
 public:
     SignalExpression(const std::string& expr);
@@ -194,13 +253,11 @@ public:
      * @brief Validate expression syntax
      */
     bool isValid() const;
-    
-private:
-    // Parser helper functions
-    std::vector<std::string> tokenize(const std::string& expr) const;
-    bool isOperator(const std::string& token) const;
-    bool isFunction(const std::string& token) const;
-    double evaluateConstant(const std::string& token) const;
+
+    /**
+     * @brief Compiled form of the expression
+     */
+    const ExpressionTape& getTape() const { return tape; }
 };
 
 /**
@@ -4,6 +4,9 @@
 #include <cmath>
 #include <algorithm>
 #include <chrono>
+#include <limits>
+#include <sstream>
+#include <iomanip>
 
 // --- MNAMatrix Implementation ---
 MNAMatrix::MNAMatrix() = default;
@@ -13,6 +16,25 @@ void MNAMatrix::reset() {
     b_vector.clear();
 }
 
+void MNAMatrix::invalidateCaches() {
+    diode_bank.clear();
+    source_bank.clear();
+}
+
+const TimeSourceBank& MNAMatrix::getSourceBank() const { return source_bank; }
+
+std::vector<double> MNAMatrix::getDeviceState() const {
+    return pending_limit_state.empty() ? diode_bank.getLimitState() : pending_limit_state;
+}
+
+void MNAMatrix::restoreDeviceState(const std::vector<double>& state) { pending_limit_state = state; }
+
+std::vector<double> MNAMatrix::getSourceState() const {
+    return pending_phasor_state.empty() ? source_bank.getPhasorState() : pending_phasor_state;
+}
+
+void MNAMatrix::restoreSourceState(const std::vector<double>& state) { pending_phasor_state = state; }
+
 void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentTime, double timeStepIncrement) {
     auto build_start = std::chrono::high_resolution_clock::now();
     reset();
@@ -30,16 +52,30 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
     int vs_idx_counter = 0;
     int l_idx_counter = 0;
     int ccvs_idx_counter = 0;
+    std::vector<const Diode*> diodes;
+    std::vector<const Element*> time_sources;
+    std::vector<const MutualInductance*> couplings;
+    std::vector<double> inductances; // Indexed like inductor_current_map
+    bool has_behavioral = false;
 
     // FIX: Correctly iterate over a vector of unique_ptrs
     for (const auto& elem : circuit.getElements()) {
         const std::string& type = elem->getType();
-        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource") {
+        if (TimeSourceBank::isTimeSource(type)) time_sources.push_back(elem.get());
+        if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource" || type == "BehavioralVoltageSource") {
             voltage_source_current_map[elem->getName()] = vs_idx_counter++;
+            if (type == "BehavioralVoltageSource") has_behavioral = true;
         } else if (type == "Inductor") {
             inductor_current_map[elem->getName()] = l_idx_counter++;
+            inductances.push_back(elem->getValue());
+        } else if (type == "MutualInductance") {
+            couplings.push_back(static_cast<const MutualInductance*>(elem.get()));
         } else if (type == "CurrentControlledVoltageSource") {
             ccvs_current_map[elem->getName()] = ccvs_idx_counter++;
+        } else if (type == "Diode") {
+            diodes.push_back(static_cast<const Diode*>(elem.get()));
+        } else if (type == "BehavioralCurrentSource") {
+            has_behavioral = true;
         }
     }
 
@@ -58,26 +94,58 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
 
     const std::map<std::string, double>& prev_node_voltages = circuit.previous_node_voltages;
     const std::map<std::string, double>& prev_inductor_currents = circuit.getPreviousInductorCurrents();
+    source_current_columns.clear();
+    for (const auto& pair : voltage_source_current_map) source_current_columns[pair.first] = num_voltage_nodes + pair.second;
 
     const double GMIN = 1e-12;
     for (int i = 0; i < num_voltage_nodes; ++i) {
         A_matrix[i][i] += GMIN;
     }
 
+    // Branch-current unknowns that behavioural sources may reference through I(name)
+    std::map<std::string, int> branch_columns = source_current_columns;
+    for (const auto& pair : inductor_current_map) branch_columns[pair.first] = num_voltage_nodes + num_voltage_sources + pair.second;
+    // ...and the previous solution of those unknowns they are linearised at
+    std::map<std::string, double> prev_branch_currents;
+    if (has_behavioral) {
+        prev_branch_currents = circuit.getPreviousSourceCurrents();
+        for (const auto& pair : prev_inductor_currents) prev_branch_currents[pair.first] = pair.second;
+    }
+
+    // Time-dependent sources are evaluated once per build, read back by slot in element order
+    if (!source_bank.isBoundTo(time_sources)) source_bank.bind(time_sources);
+    if (!pending_phasor_state.empty()) {
+        source_bank.setPhasorState(pending_phasor_state);
+        pending_phasor_state.clear();
+    }
+    source_bank.evaluate(currentTime);
+    size_t source_slot = 0;
+
     // FIX: Correctly iterate over a vector of unique_ptrs
     for (const auto& elem : circuit.getElements()) {
         const std::string& type = elem->getType();
+        const double source_value = TimeSourceBank::isTimeSource(type) ? source_bank.value(source_slot++) : 0.0;
 
-        if (type == "Resistor" || type == "Capacitor" || type == "IndependentCurrentSource" || type == "Diode") {
+        if (type == "Resistor" || type == "Capacitor" || type == "IndependentCurrentSource" || type == "Mosfet" || type == "BipolarTransistor" || type == "TableDevice" || type == "Switch") {
             elem->contributeToMNA(A_matrix, b_vector, num_voltage_nodes, node_map, prev_node_voltages, is_transient, timeStepIncrement);
 
+        } else if (type == "BehavioralVoltageSource" || type == "BehavioralCurrentSource") {
+            int branch_row = (type == "BehavioralVoltageSource") ? num_voltage_nodes + voltage_source_current_map.at(elem->getName()) : -1;
+            static_cast<const BehavioralSource*>(elem.get())->stampLinearized(A_matrix, b_vector, node_map, branch_columns, prev_node_voltages,
+                                                                              prev_branch_currents, is_transient ? currentTime : 0.0, branch_row);
+        } else if (type == "TransmissionLine") {
+            static_cast<const TransmissionLine*>(elem.get())->stampCompanion(A_matrix, b_vector, node_map, is_transient, currentTime);
         } else if (type == "PulseCurrentSource") {
-            // Pulse current sources need current time for transient analysis
-            static_cast<PulseCurrentSource*>(elem.get())->contributeToMNA(A_matrix, b_vector, num_voltage_nodes, node_map, prev_node_voltages, is_transient, currentTime);
+            // Pulse current sources use their initial value for DC
+            double current_value = is_transient ? source_value : static_cast<const PulseCurrentSource*>(elem.get())->getI1();
+            int n1_idx = elem->node1Row(node_map);
+            int n2_idx = elem->node2Row(node_map);
+            if (n1_idx != -1) b_vector[n1_idx] -= current_value;
+            if (n2_idx != -1) b_vector[n2_idx] += current_value;
         }
         else if (type == "IndependentVoltageSource" || type == "PulseVoltageSource" || type == "WaveformVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource" || type == "VoltageControlledVoltageSource") {
-            int n1_idx = node_map.count(elem->getNode1Id()) ? node_map.at(elem->getNode1Id()) : -1;
-            int n2_idx = node_map.count(elem->getNode2Id()) ? node_map.at(elem->getNode2Id()) : -1;
+            int n1_idx = elem->node1Row(node_map);
+            int n2_idx = elem->node2Row(node_map);
             
             if (!voltage_source_current_map.count(elem->getName())) {
                 ErrorManager::warn("[MNA] Voltage source " + elem->getName() + " not found in current map");
@@ -90,22 +158,11 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
             if (n1_idx != -1) { A_matrix[vs_curr_idx][n1_idx] += 1.0; }
             if (n2_idx != -1) { A_matrix[vs_curr_idx][n2_idx] -= 1.0; }
 
-            if (type == "PulseVoltageSource") {
-                b_vector[vs_curr_idx] = static_cast<const PulseVoltageSource*>(elem.get())->getVoltageAtTime(currentTime);
+            if (type == "PulseVoltageSource" || type == "PhaseVoltageSource" || type == "SinusoidalVoltageSource" || type == "ACVoltageSource") {
+                // ACVoltageSource in transient: V(t) = magnitude * cos(2*pi*frequency*t + phase)
+                b_vector[vs_curr_idx] = source_value;
             } else if (type == "WaveformVoltageSource") {
-                b_vector[vs_curr_idx] = static_cast<const WaveformVoltageSource*>(elem.get())->getVoltageAtTime(currentTime);
-            } else if (type == "PhaseVoltageSource") {
-                b_vector[vs_curr_idx] = static_cast<const PhaseVoltageSource*>(elem.get())->getVoltageAtTime(currentTime);
-            } else if (type == "SinusoidalVoltageSource") {
-                 b_vector[vs_curr_idx] = static_cast<const SinusoidalVoltageSource*>(elem.get())->getVoltageAtTime(currentTime);
-            } else if (type == "ACVoltageSource") {
-                auto* ac_vs = static_cast<const ACVoltageSource*>(elem.get());
-                // For transient analysis, AC voltage sources can be treated as sinusoidal
-                // V(t) = magnitude * cos(2*pi*frequency*t + phase)
-                double freq = ac_vs->getFrequency();
-                double mag = ac_vs->getMagnitude();
-                double phase_rad = ac_vs->getPhase() * M_PI / 180.0;
-                b_vector[vs_curr_idx] = mag * cos(2.0 * M_PI * freq * currentTime + phase_rad);
+                b_vector[vs_curr_idx] = static_cast<const WaveformVoltageSource*>(elem.get())->getVoltageAtTime(currentTime, is_transient ? timeStepIncrement : 0.0);
             } else if (type == "VoltageControlledVoltageSource") {
                 auto* vcvs = static_cast<const VoltageControlledVoltageSource*>(elem.get());
                 int ctrl_n1_idx = node_map.count(vcvs->getControlNode1Id()) ? node_map.at(vcvs->getControlNode1Id()) : -1;
@@ -122,8 +179,8 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
             }
         }
         else if (type == "Inductor") {
-            int n1_idx = node_map.count(elem->getNode1Id()) ? node_map.at(elem->getNode1Id()) : -1;
-            int n2_idx = node_map.count(elem->getNode2Id()) ? node_map.at(elem->getNode2Id()) : -1;
+            int n1_idx = elem->node1Row(node_map);
+            int n2_idx = elem->node2Row(node_map);
             
             if (!inductor_current_map.count(elem->getName())) {
                 ErrorManager::warn("[MNA] Inductor " + elem->getName() + " not found in current map");
@@ -149,8 +206,8 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
         }
         else if (type == "CurrentControlledCurrentSource") {
             auto* cccs = static_cast<const CurrentControlledCurrentSource*>(elem.get());
-            int n1_idx = node_map.count(elem->getNode1Id()) ? node_map.at(elem->getNode1Id()) : -1;
-            int n2_idx = node_map.count(elem->getNode2Id()) ? node_map.at(elem->getNode2Id()) : -1;
+            int n1_idx = elem->node1Row(node_map);
+            int n2_idx = elem->node2Row(node_map);
             
             // Find the controlling branch (voltage source or inductor)
             std::string ctrl_branch = cccs->getControllingBranchName();
@@ -169,8 +226,8 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
         }
         else if (type == "CurrentControlledVoltageSource") {
             auto* ccvs = static_cast<const CurrentControlledVoltageSource*>(elem.get());
-            int n1_idx = node_map.count(elem->getNode1Id()) ? node_map.at(elem->getNode1Id()) : -1;
-            int n2_idx = node_map.count(elem->getNode2Id()) ? node_map.at(elem->getNode2Id()) : -1;
+            int n1_idx = elem->node1Row(node_map);
+            int n2_idx = elem->node2Row(node_map);
             
             // Add a new current variable for this CCVS
             int ccvs_curr_idx = num_voltage_nodes + num_voltage_sources + num_inductors + (ccvs_current_map.count(elem->getName()) ? ccvs_current_map.at(elem->getName()) : 0);
@@ -198,6 +255,58 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
             }
         }
     }
+    // Mutual inductance: v_i = L_i dI_i/dt + sum_j M_ij dI_j/dt. Only the coupled
+    // branch rows/columns are touched, one entry per inductor pair; duplicate
+    // pairs from several K elements accumulate. In DC the inductors are shorts.
+    if (is_transient && !couplings.empty()) {
+        const int l_base = num_voltage_nodes + num_voltage_sources;
+        std::map<std::pair<int, int>, double> mutual_terms;
+        for (const auto* k_elem : couplings) {
+            std::vector<int> branches;
+            for (const auto& l_name : k_elem->getInductorNames()) {
+                auto it = inductor_current_map.find(l_name);
+                if (it == inductor_current_map.end()) {
+                    throw std::runtime_error("Coupling " + k_elem->getName() + " references unknown inductor '" + l_name + "'.");
+                }
+                branches.push_back(it->second);
+            }
+            for (size_t a = 0; a < branches.size(); ++a) {
+                for (size_t b = a + 1; b < branches.size(); ++b) {
+                    if (branches[a] == branches[b]) continue;
+                    double m = k_elem->getValue() * std::sqrt(inductances[branches[a]] * inductances[branches[b]]);
+                    mutual_terms[{std::min(branches[a], branches[b]), std::max(branches[a], branches[b])}] += m;
+                }
+            }
+        }
+        std::vector<double> prev_branch_currents(inductances.size(), 0.0);
+        for (const auto& pair : inductor_current_map) {
+            auto it = prev_inductor_currents.find(pair.first);
+            if (it != prev_inductor_currents.end()) prev_branch_currents[pair.second] = it->second;
+        }
+        for (const auto& term : mutual_terms) {
+            const int i = term.first.first, j = term.first.second;
+            const double m_dt = term.second / timeStepIncrement;
+            A_matrix[l_base + i][l_base + j] -= m_dt;
+            A_matrix[l_base + j][l_base + i] -= m_dt;
+            b_vector[l_base + i] -= m_dt * prev_branch_currents[j];
+            b_vector[l_base + j] -= m_dt * prev_branch_currents[i];
+        }
+    }
+
+    // Nonlinear devices are evaluated as one batch over SoA arrays
+    if (!diodes.empty()) {
+        if (!diode_bank.isBoundTo(diodes, num_voltage_nodes)) diode_bank.bind(diodes, node_map);
+        if (!pending_limit_state.empty()) {
+            diode_bank.setLimitState(pending_limit_state);
+            pending_limit_state.clear();
+        }
+        DiodeBank::gatherNodeVoltages(node_map, prev_node_voltages, dense_prev_voltages);
+        diode_bank.evaluate(dense_prev_voltages);
+        diode_bank.stamp(A_matrix, b_vector);
+    } else if (diode_bank.size() > 0) {
+        diode_bank.clear();
+    }
+
     // Log small summary of RHS norm and build time
     double rhs_norm = 0.0; for (double v : b_vector) rhs_norm += v*v; 
     auto build_end = std::chrono::high_resolution_clock::now();
@@ -210,6 +319,14 @@ void MNAMatrix::build(const Circuit& circuit, bool is_transient, double currentT
 const Matrix& MNAMatrix::getA() const { return A_matrix; }
 const Vector& MNAMatrix::getRHS() const { return b_vector; }
 
+void MNAMatrix::recordSourceCurrents(Circuit& circuit, const Vector& x) const {
+    std::map<std::string, double> currents;
+    for (const auto& pair : source_current_columns) {
+        if (pair.second < static_cast<int>(x.size())) currents[pair.first] = x[pair.second];
+    }
+    circuit.updatePreviousSourceCurrents(currents);
+}
+
 
 // --- ComplexMNAMatrix Implementation ---
 void ComplexMNAMatrix::build(const Circuit& circuit, double omega, NodeIndexMap& node_map, std::map<std::string, int>& ac_source_map) {
@@ -218,20 +335,42 @@ void ComplexMNAMatrix::build(const Circuit& circuit, double omega, NodeIndexMap&
     int num_nodes = node_map.size();
     ac_source_map.clear();
     int ac_source_count = 0;
+    std::vector<const MutualInductance*> couplings;
+    std::map<std::string, double> inductances;
     for (const auto& elem : circuit.getElements()) {
         if (elem->getType() == "IndependentVoltageSource" || 
             elem->getType() == "SinusoidalVoltageSource" ||
-            elem->getType() == "ACVoltageSource") {
+            elem->getType() == "ACVoltageSource" ||
+            elem->getType() == "PhaseVoltageSource") {
             ac_source_map[elem->getName()] = ac_source_count++;
+        } else if (elem->getType() == "Inductor") {
+            inductances[elem->getName()] = elem->getValue();
+        } else if (elem->getType() == "MutualInductance") {
+            couplings.push_back(static_cast<const MutualInductance*>(elem.get()));
+        }
+    }
+    // Coupled inductors get a branch-current unknown after the sources so the
+    // jwM terms have a column; uncoupled ones stay plain admittances
+    std::map<std::string, int> coupled_branch_map;
+    for (const auto* k_elem : couplings) {
+        for (const auto& l_name : k_elem->getInductorNames()) {
+            if (!inductances.count(l_name)) {
+                throw std::runtime_error("Coupling " + k_elem->getName() + " references unknown inductor '" + l_name + "'.");
+            }
+            if (!coupled_branch_map.count(l_name)) {
+                const int branch = static_cast<int>(coupled_branch_map.size());
+                coupled_branch_map[l_name] = branch;
+            }
         }
     }
-    int total_unknowns = num_nodes + ac_source_count;
+    const int branch_base = num_nodes + ac_source_count;
+    int total_unknowns = branch_base + static_cast<int>(coupled_branch_map.size());
     A_matrix.assign(total_unknowns, ComplexVector(total_unknowns, {0.0, 0.0}));
     b_vector.assign(total_unknowns, {0.0, 0.0});
     const Complex j(0.0, 1.0);
     for (const auto& elem : circuit.getElements()) {
-        int n1_idx = node_map.count(elem->getNode1Id()) ? node_map.at(elem->getNode1Id()) : -1;
-        int n2_idx = node_map.count(elem->getNode2Id()) ? node_map.at(elem->getNode2Id()) : -1;
+        int n1_idx = elem->node1Row(node_map);
+        int n2_idx = elem->node2Row(node_map);
         Complex admittance = {0.0, 0.0};
         std::string type = elem->getType();
         
@@ -239,6 +378,12 @@ void ComplexMNAMatrix::build(const Circuit& circuit, double omega, NodeIndexMap&
             admittance = 1.0 / elem->getValue();
         } else if (type == "Capacitor") {
             admittance = j * omega * elem->getValue();
+        } else if (type == "Inductor" && coupled_branch_map.count(elem->getName())) {
+            // V1 - V2 - jwL*I = 0 (mutual terms are added below)
+            int l_idx = branch_base + coupled_branch_map.at(elem->getName());
+            if (n1_idx != -1) { A_matrix[n1_idx][l_idx] += 1.0; A_matrix[l_idx][n1_idx] += 1.0; }
+            if (n2_idx != -1) { A_matrix[n2_idx][l_idx] -= 1.0; A_matrix[l_idx][n2_idx] -= 1.0; }
+            A_matrix[l_idx][l_idx] -= j * omega * elem->getValue();
         } else if (type == "Inductor") {
             admittance = (omega > 1e-9) ? 1.0 / (j * omega * elem->getValue()) : 1e12;
 
@@ -252,6 +397,8 @@ void ComplexMNAMatrix::build(const Circuit& circuit, double omega, NodeIndexMap&
             if (type == "ACVoltageSource") {
                 auto* ac_voltage = static_cast<const ACVoltageSource*>(elem.get());
                 b_vector[vs_idx] = ac_voltage->getComplexVoltage();
+            } else if (type == "PhaseVoltageSource") {
+                b_vector[vs_idx] = static_cast<const PhaseVoltageSource*>(elem.get())->getComplexVoltage();
             }
         }
         
@@ -265,6 +412,20 @@ void ComplexMNAMatrix::build(const Circuit& circuit, double omega, NodeIndexMap&
             }
         }
     }
+    // Mutual inductance: V_i = jwL_i*I_i + sum_j jwM_ij*I_j with M_ij = k*sqrt(L_i*L_j)
+    for (const auto* k_elem : couplings) {
+        const auto& names = k_elem->getInductorNames();
+        for (size_t a = 0; a < names.size(); ++a) {
+            for (size_t b = a + 1; b < names.size(); ++b) {
+                if (names[a] == names[b]) continue;
+                const Complex jwm = j * omega * k_elem->getValue() * std::sqrt(inductances.at(names[a]) * inductances.at(names[b]));
+                const int i_idx = branch_base + coupled_branch_map.at(names[a]);
+                const int j_idx = branch_base + coupled_branch_map.at(names[b]);
+                A_matrix[i_idx][j_idx] -= jwm;
+                A_matrix[j_idx][i_idx] -= jwm;
+            }
+        }
+    }
 }
 const ComplexMatrix& ComplexMNAMatrix::getA() const { return A_matrix; }
 ComplexVector& ComplexMNAMatrix::getRHS() { return b_vector; }
@@ -346,6 +507,657 @@ Vector LUDecompositionSolver::solve(const Matrix& A, const Vector& b) const {
     return x;
 }
 
+// --- SparseMatrix Implementation ---
+SparseMatrix SparseMatrix::fromDense(const Matrix& A) {
+    SparseMatrix S;
+    S.n = static_cast<int>(A.size());
+    S.row_ptr.assign(S.n + 1, 0);
+    for (int i = 0; i < S.n; ++i) {
+        for (int j = 0; j < S.n; ++j) {
+            if (A[i][j] != 0.0 || i == j) {
+                S.col.push_back(j);
+                S.val.push_back(A[i][j]);
+            }
+        }
+        S.row_ptr[i + 1] = static_cast<int>(S.col.size());
+    }
+    return S;
+}
+
+void SparseMatrix::multiply(const Vector& x, Vector& y) const {
+    y.assign(n, 0.0);
+    for (int i = 0; i < n; ++i) {
+        double sum = 0.0;
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; ++k) sum += val[k] * x[col[k]];
+        y[i] = sum;
+    }
+}
+
+// --- IterativeSolver Implementation ---
+namespace {
+double dot(const Vector& a, const Vector& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+    return sum;
+}
+
+double norm2(const Vector& a) { return std::sqrt(dot(a, a)); }
+
+// Zero or vanishing pivots are replaced by a small multiple of the row norm so the
+// preconditioner stays usable; Krylov iterations absorb the perturbation.
+double guardPivot(double pivot, double row_norm, int& replaced) {
+    if (std::abs(pivot) > 1e-14 * row_norm) return pivot;
+    ++replaced;
+    const double scale = (row_norm > 0.0) ? 1e-8 * row_norm : 1.0;
+    return (pivot < 0.0) ? -scale : scale;
+}
+}
+
+IterativeSolver::IterativeSolver(IterativeMethod method, Preconditioner preconditioner, double tolerance, int max_iterations)
+    : method(method), preconditioner(preconditioner), tolerance(tolerance), max_iterations(std::max(1, max_iterations)) {}
+
+std::string IterativeSolver::getConfigKey() const {
+    std::stringstream ss;
+    ss << std::setprecision(17) << static_cast<int>(method) << " " << static_cast<int>(preconditioner) << " "
+       << tolerance << " " << max_iterations << " " << restart;
+    if (preconditioner == Preconditioner::ILUT) ss << " " << drop_tolerance << " " << fill;
+    return ss.str();
+}
+
+IterativeSolver::IncompleteLU IterativeSolver::ilu0(const SparseMatrix& A) {
+    IncompleteLU f;
+    f.row_ptr = A.row_ptr;
+    f.col = A.col;
+    f.val = A.val;
+    f.diag.assign(A.n, -1);
+    std::vector<int> position(A.n, -1);
+    int replaced = 0;
+    for (int i = 0; i < A.n; ++i) {
+        double row_norm = 0.0;
+        for (int k = f.row_ptr[i]; k < f.row_ptr[i + 1]; ++k) {
+            position[f.col[k]] = k;
+            row_norm += f.val[k] * f.val[k];
+            if (f.col[k] == i) f.diag[i] = k;
+        }
+        row_norm = std::sqrt(row_norm);
+        // Eliminate with earlier rows, keeping only entries already in the pattern
+        for (int k = f.row_ptr[i]; k < f.diag[i]; ++k) {
+            const int p = f.col[k];
+            f.val[k] /= f.val[f.diag[p]];
+            const double l = f.val[k];
+            for (int m = f.diag[p] + 1; m < f.row_ptr[p + 1]; ++m) {
+                const int at = position[f.col[m]];
+                if (at >= 0) f.val[at] -= l * f.val[m];
+            }
+        }
+        f.val[f.diag[i]] = guardPivot(f.val[f.diag[i]], row_norm, replaced);
+        for (int k = f.row_ptr[i]; k < f.row_ptr[i + 1]; ++k) position[f.col[k]] = -1;
+    }
+    if (replaced > 0) ErrorManager::warn("[Solver-Krylov] ILU(0) replaced " + std::to_string(replaced) + " vanishing pivot(s)");
+    return f;
+}
+
+IterativeSolver::IncompleteLU IterativeSolver::ilut(const SparseMatrix& A, double drop_tolerance, int fill) {
+    const int n = A.n;
+    std::vector<std::vector<std::pair<int, double>>> lower(n), upper(n); // upper[i] starts with the diagonal
+    Vector w(n, 0.0);
+    std::vector<char> present(n, 0);
+    std::vector<int> pattern;
+    int replaced = 0;
+
+    auto keepLargest = [fill](std::vector<std::pair<int, double>>& entries) {
+        if (static_cast<int>(entries.size()) > fill) {
+            std::nth_element(entries.begin(), entries.begin() + fill, entries.end(),
+                [](const std::pair<int, double>& a, const std::pair<int, double>& b) { return std::abs(a.second) > std::abs(b.second); });
+            entries.resize(fill);
+        }
+        std::sort(entries.begin(), entries.end());
+    };
+
+    for (int i = 0; i < n; ++i) {
+        pattern.clear();
+        double row_norm = 0.0;
+        for (int k = A.row_ptr[i]; k < A.row_ptr[i + 1]; ++k) {
+            const int j = A.col[k];
+            w[j] = A.val[k];
+            present[j] = 1;
+            pattern.push_back(j);
+            row_norm += A.val[k] * A.val[k];
+        }
+        row_norm = std::sqrt(row_norm);
+        const double drop = drop_tolerance * row_norm;
+
+        // Lower part in increasing column order; fill created left of the diagonal joins the queue
+        std::vector<int> queue;
+        for (int j : pattern) if (j < i) queue.push_back(j);
+        std::make_heap(queue.begin(), queue.end(), std::greater<int>());
+        std::vector<std::pair<int, double>> l_row;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<int>());
+            const int p = queue.back();
+            queue.pop_back();
+            const double l = w[p] / upper[p][0].second;
+            w[p] = 0.0;
+            if (std::abs(l) < drop) continue;
+            l_row.emplace_back(p, l);
+            for (size_t m = 1; m < upper[p].size(); ++m) {
+                const int j = upper[p][m].first;
+                if (!present[j]) {
+                    present[j] = 1;
+                    w[j] = 0.0;
+                    pattern.push_back(j);
+                    if (j < i) { queue.push_back(j); std::push_heap(queue.begin(), queue.end(), std::greater<int>()); }
+                }
+                w[j] -= l * upper[p][m].second;
+            }
+        }
+
+        std::vector<std::pair<int, double>> u_row;
+        for (int j : pattern) {
+            if (j > i && std::abs(w[j]) >= drop) u_row.emplace_back(j, w[j]);
+        }
+        keepLargest(l_row);
+        keepLargest(u_row);
+        upper[i].reserve(u_row.size() + 1);
+        upper[i].emplace_back(i, guardPivot(w[i], row_norm, replaced));
+        upper[i].insert(upper[i].end(), u_row.begin(), u_row.end());
+        lower[i] = std::move(l_row);
+
+        for (int j : pattern) { w[j] = 0.0; present[j] = 0; }
+    }
+    if (replaced > 0) ErrorManager::warn("[Solver-Krylov] ILUT replaced " + std::to_string(replaced) + " vanishing pivot(s)");
+
+    IncompleteLU f;
+    f.row_ptr.assign(n + 1, 0);
+    f.diag.resize(n);
+    for (int i = 0; i < n; ++i) {
+        for (const auto& e : lower[i]) { f.col.push_back(e.first); f.val.push_back(e.second); }
+        f.diag[i] = static_cast<int>(f.col.size());
+        for (const auto& e : upper[i]) { f.col.push_back(e.first); f.val.push_back(e.second); }
+        f.row_ptr[i + 1] = static_cast<int>(f.col.size());
+    }
+    return f;
+}
+
+void IterativeSolver::IncompleteLU::apply(const Vector& r, Vector& z) const {
+    const int n = static_cast<int>(diag.size());
+    z = r;
+    for (int i = 0; i < n; ++i) {
+        double sum = z[i];
+        for (int k = row_ptr[i]; k < diag[i]; ++k) sum -= val[k] * z[col[k]];
+        z[i] = sum;
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double sum = z[i];
+        for (int k = diag[i] + 1; k < row_ptr[i + 1]; ++k) sum -= val[k] * z[col[k]];
+        z[i] = sum / val[diag[i]];
+    }
+}
+
+void IterativeSolver::precondition(const Vector& r, Vector& z) const {
+    if (preconditioner == Preconditioner::NONE) z = r;
+    else factors.apply(r, z);
+}
+
+bool IterativeSolver::gmres(const SparseMatrix& A, const Vector& b, Vector& x) const {
+    const int n = A.n;
+    const double b_norm = norm2(b);
+    const int m = std::min(restart, n);
+    std::vector<Vector> V(m + 1, Vector(n)), Z(m, Vector(n)); // Z keeps M^-1 v_j for the solution update
+    Matrix H(m + 1, Vector(m, 0.0));
+    Vector cs(m), sn(m), g(m + 1), r(n), w(n);
+
+    last_iterations = 0;
+    while (true) {
+        A.multiply(x, w);
+        for (int i = 0; i < n; ++i) r[i] = b[i] - w[i];
+        double beta = norm2(r);
+        last_residual = beta / b_norm;
+        if (last_residual <= tolerance) return true;
+        if (last_iterations >= max_iterations) return false;
+
+        for (int i = 0; i < n; ++i) V[0][i] = r[i] / beta;
+        std::fill(g.begin(), g.end(), 0.0);
+        g[0] = beta;
+        int k = 0;
+        for (; k < m && last_iterations < max_iterations; ++k, ++last_iterations) {
+            precondition(V[k], Z[k]);
+            A.multiply(Z[k], w);
+            for (int j = 0; j <= k; ++j) { // Modified Gram-Schmidt
+                H[j][k] = dot(w, V[j]);
+                for (int i = 0; i < n; ++i) w[i] -= H[j][k] * V[j][i];
+            }
+            H[k + 1][k] = norm2(w);
+            if (H[k + 1][k] > 0.0) for (int i = 0; i < n; ++i) V[k + 1][i] = w[i] / H[k + 1][k];
+            for (int j = 0; j < k; ++j) {
+                const double t = cs[j] * H[j][k] + sn[j] * H[j + 1][k];
+                H[j + 1][k] = -sn[j] * H[j][k] + cs[j] * H[j + 1][k];
+                H[j][k] = t;
+            }
+            const double d = std::hypot(H[k][k], H[k + 1][k]);
+            cs[k] = (d > 0.0) ? H[k][k] / d : 1.0;
+            sn[k] = (d > 0.0) ? H[k + 1][k] / d : 0.0;
+            H[k][k] = d;
+            H[k + 1][k] = 0.0;
+            g[k + 1] = -sn[k] * g[k];
+            g[k] = cs[k] * g[k];
+            if (std::abs(g[k + 1]) <= tolerance * b_norm || H[k][k] == 0.0) { ++k; ++last_iterations; break; }
+        }
+        // Least-squares update x += Z y with H y = g
+        Vector y(k, 0.0);
+        for (int i = k - 1; i >= 0; --i) {
+            double sum = g[i];
+            for (int j = i + 1; j < k; ++j) sum -= H[i][j] * y[j];
+            y[i] = (H[i][i] != 0.0) ? sum / H[i][i] : 0.0;
+        }
+        for (int j = 0; j < k; ++j) for (int i = 0; i < n; ++i) x[i] += y[j] * Z[j][i];
+        if (k == 0) return false; // No progress possible (breakdown)
+    }
+}
+
+bool IterativeSolver::bicgstab(const SparseMatrix& A, const Vector& b, Vector& x) const {
+    const int n = A.n;
+    const double b_norm = norm2(b);
+    Vector r(n), r_hat, p(n, 0.0), v(n, 0.0), s(n), t(n), p_hat(n), s_hat(n);
+    A.multiply(x, r);
+    for (int i = 0; i < n; ++i) r[i] = b[i] - r[i];
+    r_hat = r;
+    double rho = 1.0, alpha = 1.0, omega = 1.0;
+    last_residual = norm2(r) / b_norm;
+    for (last_iterations = 0; last_iterations < max_iterations; ++last_iterations) {
+        if (last_residual <= tolerance) return true;
+        const double rho_next = dot(r_hat, r);
+        if (rho_next == 0.0 || omega == 0.0) return false; // Breakdown
+        const double beta = (rho_next / rho) * (alpha / omega);
+        rho = rho_next;
+        for (int i = 0; i < n; ++i) p[i] = r[i] + beta * (p[i] - omega * v[i]);
+        precondition(p, p_hat);
+        A.multiply(p_hat, v);
+        const double denominator = dot(r_hat, v);
+        if (denominator == 0.0) return false;
+        alpha = rho / denominator;
+        for (int i = 0; i < n; ++i) s[i] = r[i] - alpha * v[i];
+        if (norm2(s) / b_norm <= tolerance) {
+            for (int i = 0; i < n; ++i) x[i] += alpha * p_hat[i];
+            r = s;
+            last_residual = norm2(s) / b_norm;
+            ++last_iterations;
+            return true;
+        }
+        precondition(s, s_hat);
+        A.multiply(s_hat, t);
+        const double tt = dot(t, t);
+        omega = (tt > 0.0) ? dot(t, s) / tt : 0.0;
+        for (int i = 0; i < n; ++i) {
+            x[i] += alpha * p_hat[i] + omega * s_hat[i];
+            r[i] = s[i] - omega * t[i];
+        }
+        last_residual = norm2(r) / b_norm;
+    }
+    return last_residual <= tolerance;
+}
+
+Vector IterativeSolver::solve(const Matrix& A, const Vector& b) const {
+    const int n = static_cast<int>(A.size());
+    if (n == 0) return {};
+    const double b_norm = norm2(b);
+    if (b_norm == 0.0) {
+        last_iterations = 0;
+        last_residual = 0.0;
+        last_solution.assign(n, 0.0);
+        return last_solution;
+    }
+
+    SparseMatrix S = SparseMatrix::fromDense(A);
+    if (preconditioner != Preconditioner::NONE && (!factors_valid || !S.sameAs(cached_matrix))) {
+        factors = (preconditioner == Preconditioner::ILUT) ? ilut(S, drop_tolerance, fill) : ilu0(S);
+        factors_valid = true;
+        ++preconditioner_builds;
+    }
+    cached_matrix = std::move(S);
+
+    // Warm start from the previous solve (the last time step) when it is a better guess than zero
+    Vector x(n, 0.0);
+    if (static_cast<int>(last_solution.size()) == n) {
+        Vector Ax;
+        cached_matrix.multiply(last_solution, Ax);
+        double r2 = 0.0;
+        for (int i = 0; i < n; ++i) r2 += (b[i] - Ax[i]) * (b[i] - Ax[i]);
+        if (std::sqrt(r2) < b_norm) x = last_solution;
+    }
+
+    const bool converged = (method == IterativeMethod::BICGSTAB) ? bicgstab(cached_matrix, b, x) : gmres(cached_matrix, b, x);
+    {
+        std::stringstream ss;
+        ss << "[Solver-Krylov] n=" << n << ", nnz=" << cached_matrix.val.size()
+           << ", iterations=" << last_iterations << ", residual=" << last_residual;
+        ErrorManager::info(ss.str());
+    }
+    if (!converged || !std::all_of(x.begin(), x.end(), [](double v) { return std::isfinite(v); })) {
+        std::stringstream ss;
+        ss << "[Solver-Krylov] no convergence after " << last_iterations << " iterations (residual "
+           << last_residual << "); using direct LU";
+        ErrorManager::warn(ss.str());
+        x = LUFactors::factor(A).solve(b);
+    }
+    last_solution = x;
+    return x;
+}
+
+// --- MixedPrecisionLUSolver Implementation ---
+bool MixedPrecisionLUSolver::factor(const Matrix& A) const {
+    n = static_cast<int>(A.size());
+    lu.resize(static_cast<size_t>(n) * n);
+    perm.resize(n);
+    for (int i = 0; i < n; ++i) {
+        perm[i] = i;
+        for (int j = 0; j < n; ++j) lu[static_cast<size_t>(i) * n + j] = static_cast<float>(A[i][j]);
+    }
+    for (int k = 0; k < n; ++k) {
+        int pivot_row = k;
+        for (int i = k + 1; i < n; ++i) {
+            if (std::abs(lu[static_cast<size_t>(i) * n + k]) > std::abs(lu[static_cast<size_t>(pivot_row) * n + k])) pivot_row = i;
+        }
+        float* row_k = &lu[static_cast<size_t>(k) * n];
+        if (pivot_row != k) {
+            std::swap_ranges(row_k, row_k + n, &lu[static_cast<size_t>(pivot_row) * n]);
+            std::swap(perm[k], perm[pivot_row]);
+        }
+        const float pivot = row_k[k];
+        if (pivot == 0.0f || !std::isfinite(pivot)) return false;
+        for (int i = k + 1; i < n; ++i) {
+            float* row_i = &lu[static_cast<size_t>(i) * n];
+            if (row_i[k] == 0.0f) continue;
+            const float l = row_i[k] / pivot;
+            row_i[k] = l;
+            for (int j = k + 1; j < n; ++j) row_i[j] -= l * row_k[j];
+        }
+    }
+    return true;
+}
+
+// Triangular solves read the float factors but accumulate in double
+Vector MixedPrecisionLUSolver::solveFactored(const Vector& b) const {
+    Vector x(n);
+    for (int i = 0; i < n; ++i) {
+        const float* row = &lu[static_cast<size_t>(i) * n];
+        double sum = b[perm[i]];
+        for (int j = 0; j < i; ++j) sum -= row[j] * x[j];
+        x[i] = sum;
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        const float* row = &lu[static_cast<size_t>(i) * n];
+        double sum = x[i];
+        for (int j = i + 1; j < n; ++j) sum -= row[j] * x[j];
+        x[i] = sum / row[i];
+    }
+    return x;
+}
+
+Vector MixedPrecisionLUSolver::solve(const Matrix& A, const Vector& b) const {
+    const int size = static_cast<int>(A.size());
+    if (size == 0) return {};
+    last_refinements = 0;
+    last_fell_back = false;
+
+    auto fallBack = [&](const std::string& reason) {
+        const std::string message = "[Solver-MixedLU] " + reason + "; using double-precision LU";
+        if (fallback_warned) {
+            ErrorManager::info(message);
+        } else {
+            ErrorManager::warn(message);
+            fallback_warned = true;
+        }
+        last_fell_back = true;
+        return LUFactors::factor(A).solve(b);
+    };
+
+    if (!factor(A)) return fallBack("single-precision factorisation hit a zero pivot");
+
+    double a_norm_inf = 0.0;
+    for (int i = 0; i < n; ++i) {
+        double row = 0.0;
+        for (int j = 0; j < n; ++j) row += std::abs(A[i][j]);
+        a_norm_inf = std::max(a_norm_inf, row);
+    }
+    // Stop at a normwise backward error of sqrt(n) eps_double, as LAPACK's dsgesv does
+    const double threshold = std::sqrt(static_cast<double>(n)) * std::numeric_limits<double>::epsilon() * a_norm_inf;
+    Vector x = solveFactored(b);
+    Vector r(n);
+    // Stall test runs after the residual test, so a tiny last correction that already
+    // converged is accepted rather than taken for a stall
+    double correction = std::numeric_limits<double>::infinity();
+    double previous_correction = std::numeric_limits<double>::infinity();
+    for (;;) {
+        double r_norm = 0.0, x_norm = 0.0;
+        for (int i = 0; i < n; ++i) {
+            double sum = b[i];
+            const Vector& row = A[i];
+            for (int j = 0; j < n; ++j) sum -= row[j] * x[j];
+            r[i] = sum;
+            r_norm = std::max(r_norm, std::abs(sum));
+            x_norm = std::max(x_norm, std::abs(x[i]));
+        }
+        if (r_norm <= threshold * x_norm) {
+            std::stringstream ss;
+            ss << "[Solver-MixedLU] n=" << n << ", refinements=" << last_refinements;
+            ErrorManager::info(ss.str());
+            return x;
+        }
+        if (last_refinements > 0 && !(correction <= 0.5 * previous_correction)) return fallBack("refinement stalled");
+        if (last_refinements >= max_refinements) return fallBack("refinement did not converge");
+
+        Vector d = solveFactored(r);
+        previous_correction = correction;
+        correction = 0.0;
+        for (int i = 0; i < n; ++i) {
+            x[i] += d[i];
+            correction = std::max(correction, std::abs(d[i]));
+        }
+        ++last_refinements;
+    }
+}
+
+// --- LUFactors Implementation ---
+LUFactors LUFactors::factor(const Matrix& A) {
+    LUFactors f;
+    const int n = static_cast<int>(A.size());
+    f.lu = A;
+    f.perm.resize(n);
+    for (int i = 0; i < n; ++i) f.perm[i] = i;
+    for (int k = 0; k < n; ++k) {
+        int pivot_row = k;
+        for (int i = k + 1; i < n; ++i) {
+            if (std::abs(f.lu[i][k]) > std::abs(f.lu[pivot_row][k])) pivot_row = i;
+        }
+        if (std::abs(f.lu[pivot_row][k]) < 1e-15) throw std::runtime_error("Singular matrix in LU.");
+        if (pivot_row != k) {
+            std::swap(f.lu[k], f.lu[pivot_row]);
+            std::swap(f.perm[k], f.perm[pivot_row]);
+        }
+        const double inv_pivot = 1.0 / f.lu[k][k];
+        for (int i = k + 1; i < n; ++i) {
+            double factor = f.lu[i][k] * inv_pivot;
+            f.lu[i][k] = factor;
+            if (factor == 0.0) continue;
+            for (int j = k + 1; j < n; ++j) f.lu[i][j] -= factor * f.lu[k][j];
+        }
+    }
+    return f;
+}
+
+Vector LUFactors::solve(const Vector& b) const {
+    const int n = static_cast<int>(lu.size());
+    Vector x(n);
+    for (int i = 0; i < n; ++i) {
+        double sum = b[perm[i]];
+        for (int j = 0; j < i; ++j) sum -= lu[i][j] * x[j];
+        x[i] = sum;
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        double sum = x[i];
+        for (int j = i + 1; j < n; ++j) sum -= lu[i][j] * x[j];
+        x[i] = sum / lu[i][i];
+    }
+    return x;
+}
+
+// --- ComplexLUFactors Implementation ---
+ComplexLUFactors ComplexLUFactors::factor(const ComplexMatrix& A) {
+    ComplexLUFactors f;
+    const int n = static_cast<int>(A.size());
+    f.lu = A;
+    f.perm.resize(n);
+    for (int i = 0; i < n; ++i) f.perm[i] = i;
+    for (int k = 0; k < n; ++k) {
+        int pivot_row = k;
+        for (int i = k + 1; i < n; ++i) {
+            if (std::abs(f.lu[i][k]) > std::abs(f.lu[pivot_row][k])) pivot_row = i;
+        }
+        if (std::abs(f.lu[pivot_row][k]) < 1e-12) throw std::runtime_error("Complex matrix is singular.");
+        if (pivot_row != k) {
+            std::swap(f.lu[k], f.lu[pivot_row]);
+            std::swap(f.perm[k], f.perm[pivot_row]);
+        }
+        const Complex inv_pivot = 1.0 / f.lu[k][k];
+        for (int i = k + 1; i < n; ++i) {
+            Complex factor = f.lu[i][k] * inv_pivot;
+            f.lu[i][k] = factor;
+            if (factor == 0.0) continue;
+            for (int j = k + 1; j < n; ++j) f.lu[i][j] -= factor * f.lu[k][j];
+        }
+    }
+    return f;
+}
+
+ComplexVector ComplexLUFactors::solve(const ComplexVector& b) const {
+    const int n = static_cast<int>(lu.size());
+    ComplexVector x(n);
+    for (int i = 0; i < n; ++i) {
+        Complex sum = b[perm[i]];
+        for (int j = 0; j < i; ++j) sum -= lu[i][j] * x[j];
+        x[i] = sum;
+    }
+    for (int i = n - 1; i >= 0; --i) {
+        Complex sum = x[i];
+        for (int j = i + 1; j < n; ++j) sum -= lu[i][j] * x[j];
+        x[i] = sum / lu[i][i];
+    }
+    return x;
+}
+
+// --- LowRankUpdater Implementation ---
+namespace {
+template <typename V>
+typename V::value_type portValue(const V& v, int a, int b) {
+    typename V::value_type value = 0.0;
+    if (a != -1) value += v[a];
+    if (b != -1) value -= v[b];
+    return value;
+}
+}
+
+size_t LowRankUpdater::addPort(int a, int b) {
+    Vector u(factors.lu.size(), 0.0);
+    if (a != -1) u[a] += 1.0;
+    if (b != -1) u[b] -= 1.0;
+    ports.push_back({a, b});
+    columns.push_back(factors.solve(u));
+    deltas.push_back(0.0);
+    return ports.size() - 1;
+}
+
+Vector LowRankUpdater::apply(const Vector& x0) const {
+    std::vector<size_t> active;
+    for (size_t i = 0; i < ports.size(); ++i) if (deltas[i] != 0.0) active.push_back(i);
+    if (active.empty()) return x0;
+
+    const size_t m = active.size();
+    Matrix S(m, Vector(m, 0.0));
+    Vector rhs(m);
+    for (size_t i = 0; i < m; ++i) {
+        const Port& p = ports[active[i]];
+        const double d = deltas[active[i]];
+        for (size_t j = 0; j < m; ++j) S[i][j] = d * portValue(columns[active[j]], p.a, p.b);
+        S[i][i] += 1.0;
+        rhs[i] = d * portValue(x0, p.a, p.b);
+    }
+    const Vector w = LUFactors::factor(S).solve(rhs);
+    Vector x = x0;
+    for (size_t j = 0; j < m; ++j) {
+        const Vector& z = columns[active[j]];
+        for (size_t i = 0; i < x.size(); ++i) x[i] -= w[j] * z[i];
+    }
+    return x;
+}
+
+// --- ComplexLowRankUpdater Implementation ---
+size_t ComplexLowRankUpdater::addPort(int a, int b) {
+    ComplexVector u(factors.lu.size(), 0.0);
+    if (a != -1) u[a] += 1.0;
+    if (b != -1) u[b] -= 1.0;
+    ports.push_back({a, b});
+    columns.push_back(factors.solve(u));
+    deltas.push_back(0.0);
+    return ports.size() - 1;
+}
+
+ComplexVector ComplexLowRankUpdater::apply(const ComplexVector& x0) const {
+    std::vector<size_t> active;
+    for (size_t i = 0; i < ports.size(); ++i) if (deltas[i] != 0.0) active.push_back(i);
+    if (active.empty()) return x0;
+
+    const size_t m = active.size();
+    ComplexMatrix S(m, ComplexVector(m, 0.0));
+    ComplexVector rhs(m);
+    for (size_t i = 0; i < m; ++i) {
+        const Port& p = ports[active[i]];
+        const Complex d = deltas[active[i]];
+        for (size_t j = 0; j < m; ++j) S[i][j] = d * portValue(columns[active[j]], p.a, p.b);
+        S[i][i] += 1.0;
+        rhs[i] = d * portValue(x0, p.a, p.b);
+    }
+    const ComplexVector w = ComplexLUFactors::factor(S).solve(rhs);
+    ComplexVector x = x0;
+    for (size_t j = 0; j < m; ++j) {
+        const ComplexVector& z = columns[active[j]];
+        for (size_t i = 0; i < x.size(); ++i) x[i] -= w[j] * z[i];
+    }
+    return x;
+}
+
+// --- TopologyLUCache Implementation ---
+TopologyLUCache::TopologyLUCache(size_t max_entries) : max_entries(max_entries) {}
+
+Vector TopologyLUCache::solve(const std::string& key, const Matrix& A, const Vector& b) {
+    auto it = entries.find(key);
+    if (it != entries.end()) recency.splice(recency.begin(), recency, it->second.recency);
+    if (it != entries.end() && it->second.A == A) {
+        ++hit_count;
+        return it->second.factors.solve(b);
+    }
+    ++miss_count;
+    if (it == entries.end()) {
+        if (max_entries > 0 && entries.size() >= max_entries) {
+            entries.erase(recency.back());
+            recency.pop_back();
+        }
+        recency.push_front(key);
+        it = entries.emplace(key, Entry{}).first;
+        it->second.recency = recency.begin();
+    }
+    Entry& entry = it->second;
+    entry.factors = LUFactors::factor(A);
+    entry.A = A;
+    return entry.factors.solve(b);
+}
+
+void TopologyLUCache::clear() {
+    entries.clear();
+    recency.clear();
+    hit_count = miss_count = 0;
+}
+
 // --- ComplexLinearSolver Implementation ---
 ComplexVector ComplexLinearSolver::solve(ComplexMatrix A, ComplexVector b) const {
     int n = A.size();
@@ -374,12 +1186,20 @@ ComplexVector ComplexLinearSolver::solve(ComplexMatrix A, ComplexVector b) const
 }
 
 // --- MNASolver Implementation ---
-MNASolver::MNASolver(const MNASolverConfig& config) : config(config) {
-    if (config.use_lu_decomposition) {
-        linear_solver = std::make_unique<LUDecompositionSolver>();
-    } else {
-        linear_solver = std::make_unique<GaussianEliminationSolver>();
+std::unique_ptr<LinearSolver> makeLinearSolver(const MNASolverConfig& config) {
+    if (config.use_iterative_solver) {
+        auto iterative = std::make_unique<IterativeSolver>(config.iterative_method, config.preconditioner,
+                                                           std::max(config.tolerance, 1e-14), config.max_iterations);
+        iterative->setRestart(config.gmres_restart);
+        iterative->setILUT(config.ilut_drop_tolerance, config.ilut_fill);
+        return iterative;
     }
+    if (config.use_lu_decomposition && config.use_mixed_precision) return std::make_unique<MixedPrecisionLUSolver>();
+    if (config.use_lu_decomposition) return std::make_unique<LUDecompositionSolver>();
+    return std::make_unique<GaussianEliminationSolver>();
+}
+
+MNASolver::MNASolver(const MNASolverConfig& config) : linear_solver(makeLinearSolver(config)), config(config) {
     complex_solver = std::make_unique<ComplexLinearSolver>();
 }
 
@@ -444,7 +1264,8 @@ AnalysisResult MNASolver::solveDC(const Circuit& circuit) {
                 elem->getType() == "PhaseVoltageSource" ||
                 elem->getType() == "SinusoidalVoltageSource" ||
                 elem->getType() == "ACVoltageSource" ||
-                elem->getType() == "VoltageControlledVoltageSource") {
+                elem->getType() == "VoltageControlledVoltageSource" ||
+                elem->getType() == "BehavioralVoltageSource") {
                 vs_map[elem->getName()] = vs_idx++;
             } else if (elem->getType() == "Inductor") {
                 l_map[elem->getName()] = l_idx++;
@@ -538,6 +1359,7 @@ AnalysisResult MNASolver::solveTransient(const Circuit& circuit) {
             
             // Update circuit state for next iteration
             updateCircuitState(const_cast<Circuit&>(circuit), solution, node_map, vs_map, l_map);
+            mna_matrix.recordSourceCurrents(const_cast<Circuit&>(circuit), solution);
         }
         
         result.success = true;
@@ -732,13 +1554,7 @@ std::map<std::string, double> MNASolver::extractBranchCurrents(const Vector& sol
 
 void MNASolver::setConfig(const MNASolverConfig& new_config) {
     config = new_config;
-    
-    // Update solver based on new configuration
-    if (config.use_lu_decomposition) {
-        linear_solver = std::make_unique<LUDecompositionSolver>();
-    } else {
-        linear_solver = std::make_unique<GaussianEliminationSolver>();
-    }
+    linear_solver = makeLinearSolver(config);
 }
 
 const MNASolverConfig& MNASolver::getConfig() const {
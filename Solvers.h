@@ -2,9 +2,12 @@
 #include <vector>
 #include <complex>
 #include <map>
+#include <list>
 #include <string>
 #include <memory>
+#include <algorithm>
 #include "Circuit.h"
+#include "DeviceBank.h"
 
 // --- Type Aliases ---
 using ComplexMatrix = std::vector<std::vector<std::complex<double>>>;
@@ -34,11 +37,23 @@ struct AnalysisResult {
     AnalysisResult() : success(false) {}
 };
 
+// --- Iterative solver options ---
+enum class IterativeMethod { GMRES, BICGSTAB };
+enum class Preconditioner { NONE, ILU0, ILUT };
+
 // --- MNA Solver Configuration ---
 struct MNASolverConfig {
     double tolerance = 1e-12;
     int max_iterations = 1000;
     bool use_lu_decomposition = true;
+    bool use_mixed_precision = false;  // Float LU plus refinement; needs use_lu_decomposition
+    // Krylov solve instead of a direct one; tolerance and max_iterations apply to it
+    bool use_iterative_solver = false;
+    IterativeMethod iterative_method = IterativeMethod::GMRES;
+    Preconditioner preconditioner = Preconditioner::ILU0;
+    int gmres_restart = 50;
+    double ilut_drop_tolerance = 1e-4; // Relative to the row norm
+    int ilut_fill = 20;                // Largest entries kept per row in each of L and U
     double transient_timestep = 1e-6;
     double transient_end_time = 1e-3;
     double ac_start_freq = 1.0;
@@ -55,13 +70,32 @@ private:
     // FIX: Renamed variables to match the .cpp file
     Matrix A_matrix;
     Vector b_vector;
+    DiodeBank diode_bank;      // Batched nonlinear device evaluation
+    TimeSourceBank source_bank; // Compiled pulse/sinusoid evaluator
+    Vector dense_prev_voltages;
+    std::vector<double> pending_limit_state;   // Applied when the diode bank is next bound
+    std::vector<double> pending_phasor_state;  // Applied when the source bank is next evaluated
+    std::map<std::string, int> source_current_columns; // Voltage-source branch unknowns of the last build
 
 public:
     MNAMatrix();
     void build(const Circuit& circuit, bool is_transient, double currentTime, double timeStepIncrement);
     const Matrix& getA() const;
     const Vector& getRHS() const;
+    // Stores the voltage-source branch currents of x, a solution of the last build, as
+    // the circuit's previous source currents (behavioural sources linearise I(V) there)
+    void recordSourceCurrents(Circuit& circuit, const Vector& x) const;
     void reset();
+    // Drop compiled device/source state; analyses call this before their first build
+    // so edited parameters are recompiled.
+    void invalidateCaches();
+    const TimeSourceBank& getSourceBank() const;
+    // Nonlinear limiting state for transient checkpoints; a restored state takes
+    // effect on the next build so it survives invalidateCaches().
+    std::vector<double> getDeviceState() const;
+    void restoreDeviceState(const std::vector<double>& state);
+    std::vector<double> getSourceState() const;
+    void restoreSourceState(const std::vector<double>& state);
 };
 
 class ComplexMNAMatrix {
@@ -122,6 +156,8 @@ class LinearSolver {
 public:
     virtual ~LinearSolver() = default;
     virtual Vector solve(const Matrix& A, const Vector& b) const = 0;
+    // Settings that can change the solution, for cache keys (the solver type is keyed separately)
+    virtual std::string getConfigKey() const { return ""; }
 };
 
 class GaussianEliminationSolver : public LinearSolver {
@@ -134,6 +170,183 @@ public:
     Vector solve(const Matrix& A, const Vector& b) const override;
 };
 
+// --- SparseMatrix (Compressed sparse rows, columns sorted within a row) ---
+struct SparseMatrix {
+    int n = 0;
+    std::vector<int> row_ptr, col;
+    std::vector<double> val;
+    // Every diagonal position is stored, zero or not, so incomplete factorisations can fill it
+    static SparseMatrix fromDense(const Matrix& A);
+    void multiply(const Vector& x, Vector& y) const;
+    bool sameAs(const SparseMatrix& other) const {
+        return n == other.n && row_ptr == other.row_ptr && col == other.col && val == other.val;
+    }
+};
+
+// --- IterativeSolver (Preconditioned GMRES / BiCGSTAB) ---
+// For large, mostly resistive grids. Each solve starts from the previous solution
+// of the same size (the last time step), and the incomplete factorisation is
+// rebuilt only when the matrix differs from the one it was built for. A solve
+// that does not reach the tolerance falls back to a direct LU so analyses keep
+// their results. MNA rows of voltage sources have zero diagonals; with nodes
+// ordered first, elimination fills those pivots, which is why the diagonal is
+// always part of the sparsity pattern.
+class IterativeSolver : public LinearSolver {
+private:
+    struct IncompleteLU {
+        std::vector<int> row_ptr, col, diag; // diag[i] indexes U's diagonal in row i
+        std::vector<double> val;             // Unit-lower L left of diag, U from diag on
+        void apply(const Vector& r, Vector& z) const;
+    };
+
+    IterativeMethod method;
+    Preconditioner preconditioner;
+    double tolerance;
+    int max_iterations;
+    int restart = 50;
+    double drop_tolerance = 1e-4;
+    int fill = 20;
+
+    mutable SparseMatrix cached_matrix;
+    mutable IncompleteLU factors;
+    mutable bool factors_valid = false;
+    mutable Vector last_solution;
+    mutable int last_iterations = 0;
+    mutable double last_residual = 0.0;
+    mutable size_t preconditioner_builds = 0;
+
+    static IncompleteLU ilu0(const SparseMatrix& A);
+    static IncompleteLU ilut(const SparseMatrix& A, double drop_tolerance, int fill);
+    void precondition(const Vector& r, Vector& z) const;
+    bool gmres(const SparseMatrix& A, const Vector& b, Vector& x) const;
+    bool bicgstab(const SparseMatrix& A, const Vector& b, Vector& x) const;
+
+public:
+    IterativeSolver(IterativeMethod method = IterativeMethod::GMRES, Preconditioner preconditioner = Preconditioner::ILU0,
+                    double tolerance = 1e-10, int max_iterations = 1000);
+    Vector solve(const Matrix& A, const Vector& b) const override;
+    std::string getConfigKey() const override;
+
+    void setRestart(int m) { restart = std::max(1, m); }
+    void setILUT(double drop, int max_fill) { drop_tolerance = drop; fill = std::max(0, max_fill); factors_valid = false; }
+    int lastIterations() const { return last_iterations; }
+    double lastResidual() const { return last_residual; } // Relative to |b|
+    size_t preconditionerBuilds() const { return preconditioner_builds; }
+};
+
+// --- MixedPrecisionLUSolver (Single-precision LU with double-precision refinement) ---
+// The O(n^3) factorisation runs on a contiguous float copy of A, halving the
+// memory traffic; residuals are formed in double against the original A, so a
+// few correction solves recover double accuracy when cond(A) * eps_float < 1.
+// As in LAPACK's dsgesv there is no up-front condition test: an ill-conditioned
+// A shows up as refinement that stalls (a correction not at most half the last)
+// or runs out of steps, and the solve then falls back to a double LU. The
+// fallback is logged as a warning once per solver, later ones as info.
+class MixedPrecisionLUSolver : public LinearSolver {
+private:
+    int max_refinements;
+
+    mutable std::vector<float> lu; // Row-major n x n, unit-lower L below the diagonal
+    mutable std::vector<int> perm;
+    mutable int n = 0;
+    mutable int last_refinements = 0;
+    mutable bool last_fell_back = false;
+    mutable bool fallback_warned = false;
+
+    bool factor(const Matrix& A) const;
+    Vector solveFactored(const Vector& b) const;
+
+public:
+    explicit MixedPrecisionLUSolver(int max_refinements = 30) : max_refinements(max_refinements) {}
+    Vector solve(const Matrix& A, const Vector& b) const override;
+    std::string getConfigKey() const override { return std::to_string(max_refinements); }
+
+    int lastRefinements() const { return last_refinements; }
+    bool lastFellBack() const { return last_fell_back; }
+};
+
+// Linear solver selected by an MNASolverConfig (iterative, mixed precision, LU or Gaussian)
+std::unique_ptr<LinearSolver> makeLinearSolver(const MNASolverConfig& config);
+
+// --- LUFactors (Dense LU with partial pivoting, reusable across right-hand sides) ---
+struct LUFactors {
+    Matrix lu;             // Unit-lower L below the diagonal, U on and above
+    std::vector<int> perm; // perm[i] = original row of factored row i
+    static LUFactors factor(const Matrix& A);
+    Vector solve(const Vector& b) const;
+};
+
+// --- ComplexLUFactors (Complex counterpart of LUFactors) ---
+struct ComplexLUFactors {
+    ComplexMatrix lu;
+    std::vector<int> perm;
+    static ComplexLUFactors factor(const ComplexMatrix& A);
+    ComplexVector solve(const ComplexVector& b) const;
+};
+
+// --- LowRankUpdater (Sherman-Morrison-Woodbury on a kept factorisation) ---
+// Solves (A0 + sum_i delta_i u_i u_i^T) x = b with u_i = e_a - e_b, the stamp of a
+// two-terminal admittance between rows a and b (-1 for ground). A0 is factored
+// once; each port costs one solve when added, after which changing deltas costs a
+// k x k solve plus O(n k), so small sets of edited elements refresh without a
+// rebuild. Used in the form x = x0 - Z (I + D U^T Z)^{-1} D U^T x0, which stays
+// valid while some deltas are zero.
+class LowRankUpdater {
+private:
+    struct Port { int a, b; };
+    LUFactors factors;
+    std::vector<Port> ports;
+    std::vector<Vector> columns; // A0^{-1} u_i
+    Vector deltas;
+public:
+    explicit LowRankUpdater(const Matrix& A0) : factors(LUFactors::factor(A0)) {}
+    size_t addPort(int a, int b);
+    void setDelta(size_t port, double delta) { deltas.at(port) = delta; }
+    Vector baseSolve(const Vector& b) const { return factors.solve(b); } // A0^{-1} b
+    Vector apply(const Vector& x0) const;                                // Updated solution from a base one
+    Vector solve(const Vector& b) const { return apply(baseSolve(b)); }
+    size_t rank() const { return ports.size(); }
+};
+
+// --- ComplexLowRankUpdater (Complex counterpart of LowRankUpdater) ---
+class ComplexLowRankUpdater {
+private:
+    struct Port { int a, b; };
+    ComplexLUFactors factors;
+    std::vector<Port> ports;
+    std::vector<ComplexVector> columns;
+    ComplexVector deltas;
+public:
+    explicit ComplexLowRankUpdater(const ComplexMatrix& A0) : factors(ComplexLUFactors::factor(A0)) {}
+    size_t addPort(int a, int b);
+    void setDelta(size_t port, Complex delta) { deltas.at(port) = delta; }
+    ComplexVector baseSolve(const ComplexVector& b) const { return factors.solve(b); }
+    ComplexVector apply(const ComplexVector& x0) const;
+    ComplexVector solve(const ComplexVector& b) const { return apply(baseSolve(b)); }
+    size_t rank() const { return ports.size(); }
+};
+
+// --- TopologyLUCache ---
+// One factorisation per topology key (switch configuration and step size), least
+// recently used entry evicted when full.
+// An entry is reused only if the matrix it was factored from is identical, so
+// circuits whose matrix moves every step (nonlinear devices) simply refactor.
+// Comparing the matrix is O(n^2) against O(n^3) for a fresh factorisation.
+class TopologyLUCache {
+private:
+    struct Entry { Matrix A; LUFactors factors; std::list<std::string>::iterator recency; };
+    std::map<std::string, Entry> entries;
+    std::list<std::string> recency; // Most recently used key first; the back is evicted
+    size_t max_entries;
+    size_t hit_count = 0, miss_count = 0;
+public:
+    explicit TopologyLUCache(size_t max_entries = 32);
+    Vector solve(const std::string& key, const Matrix& A, const Vector& b);
+    void clear();
+    size_t hits() const { return hit_count; }
+    size_t misses() const { return miss_count; }
+};
+
 class ComplexLinearSolver {
 public:
     ComplexVector solve(ComplexMatrix A, ComplexVector b) const;
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// --- Symbol identifiers ---
+// Dense 32-bit IDs handed out in insertion order; an ID is never reused while
+// the owning table lives, so arrays indexed by ID stay valid as names are added.
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = 0xFFFFFFFFu;
+
+// --- SymbolTable (Interns names to dense IDs) ---
+class SymbolTable {
+private:
+    std::unordered_map<std::string, SymbolId> ids;
+    std::vector<const std::string*> names; // Keys of `ids`, stable across rehashing
+
+public:
+    SymbolId intern(const std::string& name) {
+        auto result = ids.emplace(name, static_cast<SymbolId>(names.size()));
+        if (result.second) names.push_back(&result.first->first);
+        return result.first->second;
+    }
+    SymbolId find(const std::string& name) const {
+        auto it = ids.find(name);
+        return (it != ids.end()) ? it->second : NO_SYMBOL;
+    }
+    const std::string& name(SymbolId id) const { return *names.at(id); }
+    size_t size() const { return names.size(); }
+    void clear() { ids.clear(); names.clear(); }
+};
@@ -1,10 +1,24 @@
 #include <iostream>
 #include <memory>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <algorithm>
+#include <set>
 #include "Element.h"
 #include "Circuit.h"
 #include "Solvers.h"
 #include "Analyzers.h"
 #include "ErrorManager.h"
+#include "ProjectSerializer.h"
+#include "InputParser.h"
+#include "MonotoneSpline.h"
+#include "ResultCache.h"
+#include "DeviceBank.h"
+#include <cereal/archives/portable_binary.hpp>
 
 int main() {
     try {
@@ -95,6 +109,1164 @@ int main() {
         std::cout << "Number of sweep points: " << sweep_values.size() << "\n";
         std::cout << "Number of DC result variables: " << dc_results.size() << "\n";
         
+        // Test nonlinear device models
+        std::cout << "\nTesting MOSFET and BJT models...\n";
+        Circuit amp;
+        DeviceModelCard nmos{"NM", "NMOS", {{"KP", 2e-5}, {"VTO", 1.0}}};
+        DeviceModelCard npn{"QN", "NPN", {{"IS", 1e-16}, {"BF", 100.0}}};
+        amp.addElement(std::make_unique<IndependentVoltageSource>("VDD", "VDD", "0", 5.0));
+        amp.addElement(std::make_unique<IndependentVoltageSource>("VG", "G", "0", 2.0));
+        amp.addElement(std::make_unique<Resistor>("RD", "VDD", "D", 1000.0));
+        amp.addElement(std::make_unique<Mosfet>("M1", "D", "G", "0", nmos, 10e-6, 1e-6));
+        amp.addElement(std::make_unique<Resistor>("RC", "VDD", "C", 1000.0));
+        amp.addElement(std::make_unique<Resistor>("RB", "VDD", "B", 430e3));
+        amp.addElement(std::make_unique<BipolarTransistor>("Q1", "C", "B", "0", npn));
+        amp.addElement(std::make_unique<Ground>("GND", "0"));
+
+        TransientAnalysis amp_op(1e-6, 1e-6, false);
+        amp_op.analyze(amp, mna, solver);
+        double vd = amp_op.getResults().at("V(D)").front();
+        double ic = amp_op.getResults().at("I(RC)").front();
+        double ib = amp_op.getResults().at("I(RB)").front();
+        std::cout << "MOSFET drain voltage: " << vd << " V (expected 4.9)\n";
+        std::cout << "BJT current gain: " << ic / ib << " (expected 100)\n";
+        if (std::abs(vd - 4.9) > 1e-3 || std::abs(ic / ib - 100.0) > 0.5) {
+            throw std::runtime_error("Nonlinear device operating point mismatch");
+        }
+
+        // Deleting from the middle moves the last element into the freed slot; lookups and
+        // analyses must not notice
+        std::cout << "\nTesting element deletion...\n";
+        auto buildPruned = [](Circuit& c, bool with_extra) {
+            c.addElement(std::make_unique<IndependentVoltageSource>("V1", "IN", "0", 1.0));
+            c.addElement(std::make_unique<Resistor>("R1", "IN", "A", 100.0));
+            if (with_extra) c.addElement(std::make_unique<Resistor>("RX", "A", "0", 10.0));
+            c.addElement(std::make_unique<Capacitor>("C1", "A", "0", 1e-6));
+            c.addElement(std::make_unique<Inductor>("L1", "A", "B", 1e-3));
+            c.addElement(std::make_unique<Resistor>("R2", "B", "0", 50.0));
+            c.addElement(std::make_unique<Ground>("GND", "0"));
+        };
+        Circuit pruned, unpruned;
+        buildPruned(pruned, true);
+        buildPruned(unpruned, false);
+        TransientAnalysis before_delete(1e-5, 1e-3);
+        before_delete.analyze(unpruned, mna, solver);
+        ACSweepAnalysis ac_before_delete("V1", 10.0, 1e5, 10, "DEC");
+        ac_before_delete.analyze(unpruned, mna, solver);
+
+        pruned.deleteElement("RX");
+        const auto& remaining = pruned.getElements();
+        if (remaining.size() != 6 || remaining[2]->getName() != "GND") throw std::runtime_error("Delete did not move the last element into the slot");
+        if (pruned.hasElement("RX") || pruned.getElement("RX")) throw std::runtime_error("Deleted element still found");
+        for (size_t i = 0; i < remaining.size(); ++i) {
+            if (!pruned.hasElement(remaining[i]->getName()) || pruned.getElement(remaining[i]->getName()) != remaining[i].get()) {
+                throw std::runtime_error("Lookup of " + remaining[i]->getName() + " is stale after delete");
+            }
+        }
+        bool rejected = false;
+        try {
+            pruned.deleteElement("RX");
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        if (!rejected) throw std::runtime_error("Deleting a missing element did not throw");
+
+        TransientAnalysis after_delete(1e-5, 1e-3);
+        after_delete.analyze(pruned, mna, solver);
+        ACSweepAnalysis ac_after_delete("V1", 10.0, 1e5, 10, "DEC");
+        ac_after_delete.analyze(pruned, mna, solver);
+        if (after_delete.getTimePoints() != before_delete.getTimePoints()) throw std::runtime_error("Time grid changed after delete");
+        for (const auto& pair : before_delete.getResults()) {
+            const auto& after = after_delete.getResults().at(pair.first);
+            for (size_t i = 0; i < pair.second.size(); ++i) {
+                if (std::abs(after.at(i) - pair.second[i]) > 1e-12 * (1.0 + std::abs(pair.second[i]))) {
+                    throw std::runtime_error("Transient " + pair.first + " differs after delete");
+                }
+            }
+        }
+        for (const auto& pair : ac_before_delete.getComplexResults()) {
+            const auto& after = ac_after_delete.getComplexResults().at(pair.first);
+            for (size_t i = 0; i < pair.second.size(); ++i) {
+                if (std::abs(after.at(i) - pair.second[i]) > 1e-12 * (1.0 + std::abs(pair.second[i]))) {
+                    throw std::runtime_error("AC " + pair.first + " differs after delete");
+                }
+            }
+        }
+
+        // Deleting the last element needs no move; the name can then be reused
+        if (remaining.back()->getName() != "R2") throw std::runtime_error("Unexpected element order after delete");
+        pruned.deleteElement("R2");
+        if (remaining.size() != 5 || remaining[2]->getName() != "GND" || pruned.hasElement("R2")) throw std::runtime_error("Deleting the last element moved another");
+        pruned.addElement(std::make_unique<Resistor>("R2", "B", "0", 50.0));
+        if (remaining.size() != 6 || pruned.getElement("R2") != remaining.back().get()) {
+            throw std::runtime_error("Re-adding a deleted name failed");
+        }
+        std::cout << "Swap-and-pop delete keeps lookups and results intact\n";
+
+        // SPICE deck layer: .include, .param expressions, subcircuit expansion and error positions
+        std::cout << "\nTesting SPICE deck parsing...\n";
+        const std::filesystem::path deck_dir = std::filesystem::temp_directory_path() / "test_simulator_deck";
+        std::filesystem::create_directories(deck_dir);
+        std::ofstream(deck_dir / "parts.inc") << ".param RB={RTOP*2}\n"
+                                                 ".subckt DIV top out PARAMS: RU=1k RL=1k\n"
+                                                 "R1 top mid {RU}\n"
+                                                 "R2 mid out {RU}\n"
+                                                 "R3 out 0 {RL}\n"
+                                                 ".ends\n";
+        std::ofstream(deck_dir / "main.sp") << "divider deck\n"
+                                               ".param VIN=6 RTOP=500\n"
+                                               ".include parts.inc\n"
+                                               "V1 IN 0 {VIN}\n"
+                                               "X1 IN OUT DIV RL={RB}\n"
+                                               "R9 OUT 0 x12\n"
+                                               ".end\n";
+        Circuit deck;
+        InputParser parser;
+        std::ostringstream parse_errors;
+        std::streambuf* saved_cerr = std::cerr.rdbuf(parse_errors.rdbuf());
+        parser.parseFile((deck_dir / "main.sp").string(), deck, mna, solver);
+        std::cerr.rdbuf(saved_cerr);
+        std::filesystem::remove_all(deck_dir);
+
+        if (parser.getParams().at("RB") != 1000.0) throw std::runtime_error(".param expression across .include mismatch");
+        if (!deck.getElement("R.X1.R1") || !deck.getElement("R.X1.R3") || !deck.hasNode("X1.mid") || deck.hasNode("mid")) {
+            throw std::runtime_error("Subcircuit elements or internal nodes not localised");
+        }
+        if (deck.getElement("R.X1.R3")->getValue() != 1000.0 || deck.getElement("R.X1.R1")->getValue() != 1000.0) {
+            throw std::runtime_error("Subcircuit parameter override mismatch");
+        }
+        if (deck.getElement("R9")) throw std::runtime_error("Malformed card was added");
+        if (parse_errors.str().find("line 6, column 10") == std::string::npos) {
+            throw std::runtime_error("Deck error position not reported: " + parse_errors.str());
+        }
+        TransientAnalysis deck_op(1e-6, 1e-6, false);
+        deck_op.analyze(deck, mna, solver);
+        double v_div = deck_op.getResults().at("V(OUT)").front();
+        double v_mid = deck_op.getResults().at("V(X1.mid)").front();
+        std::cout << "Subcircuit divider: V(OUT)=" << v_div << " V, V(X1.mid)=" << v_mid << " V (expected 2, 4)\n";
+        if (std::abs(v_div - 2.0) > 1e-6 || std::abs(v_mid - 4.0) > 1e-6) throw std::runtime_error("Deck circuit solved incorrectly");
+
+        // A deck over 1 MB is tokenised in chunks and its plain-card runs are built on worker
+        // threads; the result must be what the single-threaded path produces. Every line is
+        // LINE_WIDTH bytes so the chunk cuts can be predicted and a '+' continuation placed
+        // right after each of them.
+        std::cout << "\nTesting parallel deck loading...\n";
+        const size_t LINE_WIDTH = 32, deck_lines = 60000;
+        const size_t deck_bytes = LINE_WIDTH * deck_lines;
+        const size_t deck_chunks = std::min<size_t>(deck_bytes / (256 << 10), 64);
+        std::vector<std::string> deck_text(deck_lines);
+        for (size_t i = 2; i < deck_lines; ++i) {
+            deck_text[i] = "R" + std::to_string(i) + " N" + std::to_string(i) + " N" + std::to_string(i + 1) + " 100";
+        }
+        deck_text[0] = "large deck";
+        deck_text[1] = ".param RP=2k";
+        std::set<size_t> continued; // Lines that start a chunk
+        for (size_t c = 1; c < deck_chunks; ++c) {
+            const size_t line = (deck_bytes * c / deck_chunks) / LINE_WIDTH + 1; // The line after the first '\n' at or past the cut
+            continued.insert(line);
+            deck_text[line - 1] = "R" + std::to_string(line - 1) + " N" + std::to_string(line - 1) + " N" + std::to_string(line);
+            deck_text[line] = "+ 100";
+        }
+        const size_t param_line = 20000, duplicate_line = 30000, bad_line = 40000;
+        for (size_t special : {param_line, duplicate_line, bad_line}) {
+            if (continued.count(special) || continued.count(special + 1)) throw std::runtime_error("Test deck layout collides with a chunk cut");
+        }
+        deck_text[param_line] = "R" + std::to_string(param_line) + " N1 N2 {RP}";
+        deck_text[duplicate_line] = "R" + std::to_string(duplicate_line - 5) + " N1 N2 100";
+        deck_text[bad_line] = "R" + std::to_string(bad_line) + " N1 N2 x12";
+        const std::filesystem::path large_deck = std::filesystem::temp_directory_path() / "test_parallel_deck.cir";
+        {
+            std::ofstream out(large_deck, std::ios::out | std::ios::binary | std::ios::trunc);
+            for (const auto& line : deck_text) out << line << std::string(LINE_WIDTH - 1 - line.size(), ' ') << '\n';
+        }
+        auto loadLargeDeck = [&](bool parallel, Circuit& c) {
+            InputParser::clearDeckCache();
+            InputParser::setParallelLoading(parallel);
+            InputParser large_parser;
+            std::ostringstream errors;
+            std::streambuf* saved = std::cerr.rdbuf(errors.rdbuf());
+            large_parser.parseFile(large_deck.string(), c, mna, solver);
+            std::cerr.rdbuf(saved);
+            return errors.str();
+        };
+        Circuit parallel_deck, serial_deck;
+        const std::string parallel_errors = loadLargeDeck(true, parallel_deck);
+        const std::string serial_errors = loadLargeDeck(false, serial_deck);
+        InputParser::setParallelLoading(true);
+        InputParser::clearDeckCache();
+        std::filesystem::remove(large_deck);
+
+        const auto& parallel_elements = parallel_deck.getElements();
+        const auto& serial_elements = serial_deck.getElements();
+        if (parallel_elements.size() != serial_elements.size() || parallel_elements.size() != deck_lines - 2 - continued.size() - 2) {
+            throw std::runtime_error("Parallel and serial decks have different element counts");
+        }
+        for (size_t i = 0; i < serial_elements.size(); ++i) {
+            const Element& a = *parallel_elements[i];
+            const Element& b = *serial_elements[i];
+            if (a.getName() != b.getName() || a.getType() != b.getType() || a.getValue() != b.getValue() ||
+                a.getNode1Id() != b.getNode1Id() || a.getNode2Id() != b.getNode2Id()) {
+                throw std::runtime_error("Parallel deck differs from serial at element " + std::to_string(i) + " (" + a.getName() + ")");
+            }
+        }
+        if (parallel_errors != serial_errors) throw std::runtime_error("Parallel deck errors differ from serial:\n" + parallel_errors + "\n" + serial_errors);
+        for (size_t line : continued) {
+            const Element* joined = parallel_deck.getElement("R" + std::to_string(line - 1));
+            if (!joined || joined->getValue() != 100.0) throw std::runtime_error("Continuation across a chunk cut was lost");
+        }
+        if (parallel_deck.getElement("R" + std::to_string(param_line))->getValue() != 2000.0) throw std::runtime_error("Parameter card in a plain run misparsed");
+        if (parallel_errors.find("line " + std::to_string(duplicate_line + 1) + ", column 1") == std::string::npos ||
+            parallel_errors.find("line " + std::to_string(bad_line + 1) + ",") == std::string::npos || parallel_deck.getElement("R" + std::to_string(bad_line))) {
+            throw std::runtime_error("Duplicate or malformed card not reported at its position:\n" + parallel_errors);
+        }
+        std::cout << "Parallel and serial loading agree on " << parallel_elements.size() << " elements across " << deck_chunks << " chunks\n";
+
+        // Behavioural current source driven by a nonlinear function of a source current:
+        // |I(VS)| = 2 mA, so B1 drives 1e3 * (2 mA)^2 = 4 mA into 1k
+        std::cout << "\nTesting behavioural source on a branch current...\n";
+        Circuit behav;
+        behav.addElement(std::make_unique<IndependentVoltageSource>("VS", "A", "0", 2.0));
+        behav.addElement(std::make_unique<Resistor>("RA", "A", "0", 1000.0));
+        behav.addElement(std::make_unique<BehavioralSource>("B1", "0", "OUT", BehavioralSource::Kind::CURRENT, "1e3 * I(VS) * I(VS)"));
+        behav.addElement(std::make_unique<Resistor>("RO", "OUT", "0", 1000.0));
+        behav.addElement(std::make_unique<Ground>("GND", "0"));
+        TransientAnalysis behav_op(1e-6, 1e-6, false);
+        behav_op.analyze(behav, mna, solver);
+        double v_out = behav_op.getResults().at("V(OUT)").front();
+        std::cout << "Behavioural output: " << v_out << " V (expected 4)\n";
+        if (std::abs(v_out - 4.0) > 1e-6) throw std::runtime_error("Behavioural source linearised at the wrong branch current");
+
+        // Coupled inductors in AC against their T-equivalent (M = k*sqrt(L1*L2) = 1 mH)
+        std::cout << "\nTesting mutual inductance in AC...\n";
+        Circuit coupled, tee;
+        for (Circuit* c : {&coupled, &tee}) {
+            c->addElement(std::make_unique<IndependentVoltageSource>("V1", "IN", "0", 0.0));
+            c->addElement(std::make_unique<Resistor>("R1", "IN", "P", 50.0));
+            c->addElement(std::make_unique<Resistor>("R2", "S", "0", 100.0));
+            c->addElement(std::make_unique<Ground>("GND", "0"));
+        }
+        coupled.addElement(std::make_unique<Inductor>("L1", "P", "0", 2e-3));
+        coupled.addElement(std::make_unique<Inductor>("L2", "S", "0", 8e-3));
+        coupled.addElement(std::make_unique<MutualInductance>("K1", std::vector<std::string>{"L1", "L2"}, 0.25));
+        tee.addElement(std::make_unique<Inductor>("LA", "P", "X", 1e-3));
+        tee.addElement(std::make_unique<Inductor>("LB", "S", "X", 7e-3));
+        tee.addElement(std::make_unique<Inductor>("LM", "X", "0", 1e-3));
+        ACSweepAnalysis ac_coupled("V1", 100.0, 100e3, 10, "DEC"), ac_tee("V1", 100.0, 100e3, 10, "DEC");
+        ac_coupled.analyze(coupled, mna, solver);
+        ac_tee.analyze(tee, mna, solver);
+        const auto& vs_coupled = ac_coupled.getComplexResults().at("V(S)");
+        const auto& vs_tee = ac_tee.getComplexResults().at("V(S)");
+        for (size_t i = 0; i < vs_tee.size(); ++i) {
+            if (std::abs(vs_coupled.at(i) - vs_tee[i]) > 1e-9 * (1.0 + std::abs(vs_tee[i]))) {
+                throw std::runtime_error("Coupled inductor AC response mismatch");
+            }
+        }
+        std::cout << "Secondary voltage at 100 kHz: " << std::abs(vs_coupled.back()) << " V\n";
+
+        // Fritsch-Carlson spline: no overshoot on monotone data, consistent derivative,
+        // interval cache independent of query order, linear extrapolation
+        std::cout << "\nTesting monotone spline and table device...\n";
+        MonotoneCubicSpline spline;
+        const std::vector<double> sx = {0.0, 1.0, 2.0, 3.0, 3.5, 5.0, 8.0};
+        const std::vector<double> sy = {0.0, 0.1, 2.0, 2.0, 2.0, 2.05, 9.0}; // Flat from 2 to 3.5
+        spline.setPoints(sx, sy);
+        for (size_t k = 0; k + 1 < sx.size(); ++k) {
+            if (spline.evaluate(sx[k]) != sy[k]) throw std::runtime_error("Spline misses a knot");
+            for (int j = 1; j < 100; ++j) {
+                const double xq = sx[k] + (sx[k + 1] - sx[k]) * j / 100.0;
+                double slope;
+                const double y = spline.evaluate(xq, slope);
+                if (y < sy[k] || y > sy[k + 1] || slope < 0.0) throw std::runtime_error("Spline overshoots monotone data");
+                if (sy[k] == sy[k + 1] && (y != sy[k] || slope != 0.0)) throw std::runtime_error("Spline leaves a flat segment");
+                const double fd_h = 1e-6;
+                const double fd = (spline.evaluate(xq + fd_h) - spline.evaluate(xq - fd_h)) / (2.0 * fd_h);
+                if (std::abs(slope - fd) > 1e-6 * (1.0 + std::abs(slope))) throw std::runtime_error("Spline derivative disagrees with a finite difference");
+            }
+        }
+        double left_slope, right_slope, probe_slope;
+        spline.evaluate(sx.front(), left_slope);
+        spline.evaluate(sx.back(), right_slope);
+        for (double dx : {1e-9, 0.5, 3.0}) {
+            if (std::abs(spline.evaluate(sx.front() - dx, probe_slope) - (sy.front() - left_slope * dx)) > 1e-12 || probe_slope != left_slope ||
+                std::abs(spline.evaluate(sx.back() + dx, probe_slope) - (sy.back() + right_slope * dx)) > 1e-12 || probe_slope != right_slope) {
+                throw std::runtime_error("Spline is not extended linearly past its ends");
+            }
+        }
+
+        // Queries in a scrambled order (neighbour steps, long jumps, repeats) must give the
+        // same result as a fresh spline for each query
+        std::vector<double> cube_x, cube_y;
+        for (int k = 0; k <= 64; ++k) {
+            cube_x.push_back(-2.0 + k / 16.0 + 0.003 * (k % 3));
+            cube_y.push_back(cube_x.back() * cube_x.back() * cube_x.back() + cube_x.back());
+        }
+        MonotoneCubicSpline cube;
+        cube.setPoints(cube_x, cube_y);
+        const MonotoneCubicSpline pristine = cube;
+        uint32_t lcg = 12345;
+        for (int q = 0; q < 2000; ++q) {
+            lcg = lcg * 1664525u + 1013904223u;
+            double xq;
+            if (q % 4 == 3) xq = cube_x[(lcg >> 8) % cube_x.size()];                         // On a knot
+            else if (q % 4 == 2) xq = -2.0 + 4.1 * ((lcg >> 8) % 100000) / 100000.0;        // Anywhere
+            else xq = -2.0 + (q % 97) / 24.0;                                              // Walking, then wrapping
+            MonotoneCubicSpline fresh = pristine;
+            double cached_slope, fresh_slope;
+            if (cube.evaluate(xq, cached_slope) != fresh.evaluate(xq, fresh_slope) || cached_slope != fresh_slope) {
+                throw std::runtime_error("Spline interval cache returned a different segment");
+            }
+        }
+
+        // A table sampled from an ideal diode must give the diode's operating point
+        const double table_is = 1e-14, table_vt = 0.02585;
+        std::vector<double> table_v, table_i;
+        for (int k = 0; k <= 90; ++k) {
+            table_v.push_back(0.01 * k);
+            table_i.push_back(table_is * (std::exp(table_v.back() / table_vt) - 1.0));
+        }
+        Circuit table_circuit;
+        table_circuit.addElement(std::make_unique<IndependentVoltageSource>("VS", "IN", "0", 5.0));
+        table_circuit.addElement(std::make_unique<Resistor>("R1", "IN", "A", 1000.0));
+        table_circuit.addElement(std::make_unique<TableDevice>("X1", "A", "0", table_v, table_i));
+        table_circuit.addElement(std::make_unique<Ground>("GND", "0"));
+        TransientAnalysis table_op(1e-6, 1e-6, false);
+        table_op.analyze(table_circuit, mna, solver);
+        double v_diode = 0.7;
+        for (int k = 0; k < 50; ++k) {
+            const double e = std::exp(v_diode / table_vt);
+            v_diode -= ((5.0 - v_diode) / 1000.0 - table_is * (e - 1.0)) / (-1.0 / 1000.0 - table_is * e / table_vt);
+        }
+        const double v_table = table_op.getResults().at("V(A)").front();
+        std::cout << "Table device operating point: " << v_table << " V (diode " << v_diode << " V)\n";
+        if (std::abs(v_table - v_diode) > 1e-4) throw std::runtime_error("Table device operating point differs from the sampled diode");
+
+        // Lossless line (Z0 = 50, Td = 1 ns) from a matched 50 ohm source into RL: the step
+        // reaches port 2 after Td and reflects with (RL - Z0) / (RL + Z0)
+        std::cout << "\nTesting transmission line...\n";
+        const double line_td = 1e-9, line_step = 1e-11, edge = 2e-10;
+        auto buildLine = [&](Circuit& c, double rs, double rl, bool pulsed) {
+            if (pulsed) c.addElement(std::make_unique<PulseVoltageSource>("VS", "IN", "0", 0.0, 1.0, edge, line_step, line_step, 1.0, 2.0));
+            else c.addElement(std::make_unique<IndependentVoltageSource>("VS", "IN", "0", 1.0));
+            c.addElement(std::make_unique<Resistor>("RS", "IN", "A", rs));
+            c.addElement(std::make_unique<TransmissionLine>("T1", "A", "0", "B", "0", 50.0, line_td));
+            c.addElement(std::make_unique<Resistor>("RL", "B", "0", rl));
+            c.addElement(std::make_unique<Ground>("GND", "0"));
+        };
+        auto sampleAt = [](const TransientAnalysis& run, const std::string& var, double t) {
+            const auto& times = run.getTimePoints();
+            const size_t i = std::lower_bound(times.begin(), times.end(), t - 1e-15) - times.begin();
+            return run.getResults().at(var).at(i);
+        };
+        for (double rl : {50.0, 150.0}) {
+            Circuit line_circuit;
+            buildLine(line_circuit, 50.0, rl, true);
+            TransientAnalysis line_tran(line_step, 4e-9);
+            line_tran.analyze(line_circuit, mna, solver);
+            const double gamma = (rl - 50.0) / (rl + 50.0);
+            const auto& times = line_tran.getTimePoints();
+            const auto& vb = line_tran.getResults().at("V(B)");
+            const double v_end = 0.5 * (1.0 + gamma);
+            size_t arrival = 0;
+            while (arrival < vb.size() && vb[arrival] < 0.5 * v_end) ++arrival;
+            if (arrival == vb.size() || std::abs(times[arrival] - (edge + line_step / 2 + line_td)) > line_step) {
+                throw std::runtime_error("Line step arrived at the wrong time");
+            }
+            if (std::abs(sampleAt(line_tran, "V(B)", edge + line_td - 5 * line_step)) > 1e-12) throw std::runtime_error("Port 2 moved before Td");
+            const double measured = sampleAt(line_tran, "V(B)", 2.5e-9) / 0.5 - 1.0;
+            if (std::abs(measured - gamma) > 1e-9) throw std::runtime_error("Wrong reflection coefficient at port 2");
+            if (std::abs(sampleAt(line_tran, "V(A)", edge + 2 * line_td - 5 * line_step) - 0.5) > 1e-9 ||
+                std::abs(sampleAt(line_tran, "V(A)", 3.5e-9) - v_end) > 1e-9) {
+                throw std::runtime_error("Reflection returned to port 1 at the wrong time or level");
+            }
+            std::cout << "RL = " << rl << ": arrival " << times[arrival] << " s, reflection " << measured << "\n";
+        }
+
+        // DC treats the line as a short; the transient starts from that operating point
+        Circuit line_dc;
+        buildLine(line_dc, 50.0, 150.0, false);
+        DCSweepAnalysis line_sweep("VS", 0.0, 1.0, 1.0);
+        line_sweep.analyze(line_dc, mna, solver);
+        if (std::abs(line_sweep.getResults().at("V(B)").back() - 0.75) > 1e-6 ||
+            std::abs(line_sweep.getResults().at("V(A)").back() - line_sweep.getResults().at("V(B)").back()) > 1e-6) {
+            throw std::runtime_error("Line is not a short at DC");
+        }
+        TransientAnalysis line_hold(line_step, 5 * line_td);
+        line_hold.analyze(line_dc, mna, solver);
+        for (const char* var : {"V(A)", "V(B)"}) {
+            for (double v : line_hold.getResults().at(var)) {
+                if (std::abs(v - 0.75) > 1e-6) throw std::runtime_error("Line history not seeded from the operating point");
+            }
+        }
+
+        // Mismatched at both ends the line rings for many Td, so the history ring buffer
+        // wraps and evicts; a checkpointed run must resume bit-exactly
+        const std::filesystem::path line_checkpoint = std::filesystem::temp_directory_path() / "test_line.ckpt";
+        Circuit line_whole, line_first, line_second;
+        for (Circuit* c : {&line_whole, &line_first, &line_second}) buildLine(*c, 20.0, 200.0, true);
+        TransientAnalysis line_tran_whole(line_step, 8e-9);
+        line_tran_whole.analyze(line_whole, mna, solver);
+        TransientAnalysis line_tran_first(line_step, 4.5e-9);
+        line_tran_first.setCheckpointing(line_checkpoint.string(), 1e9);
+        line_tran_first.analyze(line_first, mna, solver);
+        std::vector<double> line_state, line_state_again;
+        line_first.getElement("T1")->saveTransientState(line_state);
+        TransmissionLine restored_line("T2", "A", "0", "B", "0", 50.0, line_td);
+        restored_line.restoreTransientState(line_state);
+        restored_line.saveTransientState(line_state_again);
+        if (line_state != line_state_again || line_state.size() < 3 * 100) throw std::runtime_error("Line history did not round-trip");
+        TransientAnalysis line_tran_second(line_step, 8e-9);
+        line_tran_second.resumeFrom(line_checkpoint.string());
+        line_tran_second.analyze(line_second, mna, solver);
+        std::filesystem::remove(line_checkpoint);
+        if (line_tran_second.getTimePoints() != line_tran_whole.getTimePoints() || line_tran_second.getResults() != line_tran_whole.getResults()) {
+            throw std::runtime_error("Resumed line transient differs from the uninterrupted run");
+        }
+
+        // Bursts of closely spaced points (as switch events produce) outgrow the buffer sized
+        // for the step; eviction must never drop a point a later query interpolates from, so a
+        // line sized for a far smaller step records the same waves
+        TransmissionLine line_small("TS", "A", "0", "B", "0", 50.0, line_td), line_large("TL", "A", "0", "B", "0", 50.0, line_td);
+        line_small.beginTransient(1e-10, {});
+        line_large.beginTransient(1e-14, {});
+        double burst_t = 0.0;
+        for (int k = 0; k < 2000; ++k) {
+            burst_t += (k % 50 < 40) ? 1e-10 : 1e-12;
+            const std::map<std::string, double> port_voltages = {{"A", std::sin(3e9 * burst_t)}, {"B", std::cos(7e8 * burst_t)}};
+            line_small.acceptStep(burst_t, port_voltages);
+            line_large.acceptStep(burst_t, port_voltages);
+        }
+        std::vector<double> small_state, large_state;
+        line_small.saveTransientState(small_state);
+        line_large.saveTransientState(large_state);
+        if (small_state[2] <= std::ceil(line_td / 1e-10) + 4 || small_state.size() >= large_state.size() ||
+            !std::equal(small_state.begin() + 3, small_state.end(), large_state.end() - (small_state.size() - 3))) {
+            throw std::runtime_error("Line history eviction dropped a needed point");
+        }
+        std::cout << "Line DC short, operating-point seeding and checkpoint resume verified\n";
+
+        // Voltage-controlled switch on a triangle: VT = 0.5, VH = 0.2, so it closes where the
+        // control rises through 0.7 and opens where it falls through 0.3; both crossings lie
+        // between grid points and bisection must place them within 1e-6 Tstep
+        std::cout << "\nTesting switch events...\n";
+        const DeviceModelCard hysteretic{"SWH", "SW", {{"RON", 1.0}, {"ROFF", 1e6}, {"VT", 0.5}, {"VH", 0.2}}};
+        const double ramp = 1e-3, switch_step = 3e-5;
+        Circuit switched;
+        switched.addElement(std::make_unique<PulseVoltageSource>("VC", "CTRL", "0", 0.0, 1.0, 0.0, ramp, ramp, 0.0, 1.0));
+        switched.addElement(std::make_unique<IndependentVoltageSource>("VS", "IN", "0", 1.0));
+        switched.addElement(std::make_unique<Resistor>("R1", "IN", "OUT", 1000.0));
+        switched.addElement(std::make_unique<Switch>("S1", "OUT", "0", "CTRL", "0", hysteretic));
+        switched.addElement(std::make_unique<Ground>("GND", "0"));
+        TransientAnalysis switched_tran(switch_step, 2.5e-3);
+        switched_tran.analyze(switched, mna, solver);
+        const auto& switch_times = switched_tran.getTimePoints();
+        const auto& switch_out = switched_tran.getResults().at("V(OUT)");
+        auto switchedOn = [&](double t) {
+            const size_t i = std::lower_bound(switch_times.begin(), switch_times.end(), t) - switch_times.begin();
+            return switch_out.at(i) < 0.5;
+        };
+        for (double crossing : {0.7 * ramp, ramp + 0.7 * ramp}) {
+            const size_t i = std::lower_bound(switch_times.begin(), switch_times.end(), crossing) - switch_times.begin();
+            if (i == switch_times.size() || switch_times[i] - crossing > 1e-6 * switch_step + 1e-18) {
+                throw std::runtime_error("Switch event not located at the analytic crossing");
+            }
+            if (switchedOn(crossing - 1e-3 * switch_step) == switchedOn(switch_times[i] + 1e-3 * switch_step)) {
+                throw std::runtime_error("Switch did not change state at the crossing");
+            }
+        }
+        // Inside the hysteresis band (0.3 < vc < 0.7) the state follows the history
+        if (switchedOn(0.5 * ramp) || !switchedOn(0.9 * ramp) || !switchedOn(ramp + 0.5 * ramp) || switchedOn(ramp + 0.8 * ramp)) {
+            throw std::runtime_error("Switch ignored its hysteresis band");
+        }
+        std::cout << "Events located at " << 0.7 * ramp << " s and " << 1.7 * ramp << " s\n";
+
+        // Topology LU cache: factors are reused per key while the matrix is unchanged,
+        // a changed matrix is refactored, and the least recently used key is evicted
+        TopologyLUCache topology_cache(2);
+        const Matrix topo_a = {{4.0, 1.0}, {1.0, 3.0}}, topo_b = {{2.0, 0.0}, {1.0, 5.0}}, topo_c = {{1.0, 2.0}, {3.0, 1.0}};
+        const Vector topo_rhs = {1.0, 2.0};
+        auto expectTopologySolve = [&](const std::string& key, const Matrix& A, size_t hits, size_t misses) {
+            const Vector x = topology_cache.solve(key, A, topo_rhs);
+            const Vector reference = LUDecompositionSolver().solve(A, topo_rhs);
+            for (size_t i = 0; i < x.size(); ++i) {
+                if (std::abs(x[i] - reference[i]) > 1e-14) throw std::runtime_error("Topology cache solved the wrong system");
+            }
+            if (topology_cache.hits() != hits || topology_cache.misses() != misses) {
+                throw std::runtime_error("Topology cache " + key + ": unexpected hit/factorisation count");
+            }
+        };
+        expectTopologySolve("a", topo_a, 0, 1);
+        expectTopologySolve("a", topo_a, 1, 1);
+        expectTopologySolve("b", topo_b, 1, 2);
+        expectTopologySolve("a", topo_c, 1, 3); // Same key, new matrix: refactored
+        expectTopologySolve("c", topo_c, 1, 4); // Evicts b, the least recently used
+        expectTopologySolve("a", topo_c, 2, 4);
+        expectTopologySolve("b", topo_b, 2, 5);
+
+        // Relaxation oscillator: C charges through R until the switch closes at 0.8 V and
+        // discharges until it opens at 0.2 V. Every full step has one of two topologies.
+        const DeviceModelCard relaxation{"SWR", "SW", {{"RON", 1.0}, {"ROFF", 1e9}, {"VT", 0.5}, {"VH", 0.3}}};
+        Circuit oscillator;
+        oscillator.addElement(std::make_unique<IndependentVoltageSource>("VS", "IN", "0", 1.0));
+        oscillator.addElement(std::make_unique<Resistor>("R1", "IN", "C", 1000.0));
+        oscillator.addElement(std::make_unique<Capacitor>("C1", "C", "0", 1e-6));
+        oscillator.addElement(std::make_unique<Switch>("S1", "C", "0", "C", "0", relaxation));
+        oscillator.addElement(std::make_unique<Ground>("GND", "0"));
+        TransientAnalysis oscillator_tran(1e-5, 2e-2, true);
+        oscillator_tran.analyze(oscillator, mna, solver);
+        int discharges = 0;
+        const auto& vc = oscillator_tran.getResults().at("V(C)");
+        for (size_t i = 1; i < vc.size(); ++i) {
+            if (vc[i - 1] >= 0.5 && vc[i] < 0.5) ++discharges;
+        }
+        std::cout << "Relaxation oscillator: " << discharges << " cycles, " << oscillator_tran.getTopologyCacheHits() << " cache hits, "
+                  << oscillator_tran.getTopologyFactorisations() << " factorisations\n";
+        if (discharges < 10 || oscillator_tran.getTopologyFactorisations() != 2 || oscillator_tran.getTopologyCacheHits() < 1900) {
+            throw std::runtime_error("Relaxation oscillator did not reuse its two topology factorisations");
+        }
+
+        // Compiled time sources against the elements' own waveforms: many pulse periods,
+        // phasors across their 64-step resynchronisation, step-size changes, time moving
+        // backwards, and the breakpoint list the exponential integrator splits steps at
+        std::cout << "\nTesting time source bank...\n";
+        const PulseVoltageSource bank_vpulse("VP", "A", "0", -1.0, 2.0, 1e-4, 1e-5, 2e-5, 3e-4, 1e-3);
+        const PulseCurrentSource bank_ipulse("IP", "B", "0", 0.5e-3, 2e-3, 5e-5, 3e-5, 1e-5, 2e-4, 7e-4);
+        const SinusoidalVoltageSource bank_sine("VSIN", "C", "0", 0.5, 2.0, 1e3);
+        const PhaseVoltageSource bank_phase("VPH", "D", "0", 1.5, 2.0 * M_PI * 60.0, 0.3);
+        TimeSourceBank bank;
+        bank.bind({&bank_vpulse, &bank_ipulse, &bank_sine, &bank_phase});
+        auto checkBank = [&](double t) {
+            bank.evaluate(t);
+            const double expected[] = {bank_vpulse.getVoltageAtTime(t), bank_ipulse.getCurrentAtTime(t),
+                                       bank_sine.getVoltageAtTime(t), bank_phase.getVoltageAtTime(t)};
+            const double scale[] = {1e-12, 1e-15, 1e-11, 1e-11};
+            for (size_t i = 0; i < 4; ++i) {
+                if (std::abs(bank.value(i) - expected[i]) > scale[i]) {
+                    throw std::runtime_error("Time source bank slot " + std::to_string(i) + " differs at t=" + std::to_string(t));
+                }
+            }
+        };
+        const double bank_stop = 1e-2;
+        std::vector<double> bank_times;
+        for (int k = 0; k * 1e-6 <= bank_stop; ++k) bank_times.push_back(k * 1e-6);
+        // Split the grid at the pulse breakpoints, as the exponential integrator does
+        const std::vector<double> bank_breaks = bank.getBreakpoints(0.0, bank_stop);
+        bank_times.insert(bank_times.end(), bank_breaks.begin(), bank_breaks.end());
+        std::sort(bank_times.begin(), bank_times.end());
+        for (double t : bank_times) checkBank(t);
+        for (double t : {5e-3, 5e-3, 4.2e-3, 4.2e-3 + 0.7e-6, 4.2e-3 + 1.4e-6, 1e-4, 9.9e-3}) checkBank(t); // Repeats and backward jumps
+
+        // Every slope change of either pulse in the window, and nothing else
+        std::vector<double> kinks;
+        for (int k = 0; k < 10; ++k) {
+            for (double offset : {0.0, 1e-5, 1e-5 + 3e-4, 1e-5 + 3e-4 + 2e-5}) kinks.push_back(1e-4 + k * 1e-3 + offset);
+        }
+        for (int k = 0; 7e-4 * k <= bank_stop; ++k) {
+            for (double offset : {0.0, 5e-5, 5e-5 + 3e-5, 5e-5 + 3e-5 + 2e-4, 5e-5 + 3e-5 + 2e-4 + 1e-5}) {
+                if (7e-4 * k + offset <= bank_stop) kinks.push_back(7e-4 * k + offset);
+            }
+        }
+        auto within = [](const std::vector<double>& sorted, double t) {
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), t - 1e-15);
+            return it != sorted.end() && *it <= t + 1e-15;
+        };
+        std::sort(kinks.begin(), kinks.end());
+        for (double t : kinks) {
+            if (!within(bank_breaks, t)) throw std::runtime_error("Pulse breakpoint missing");
+        }
+        for (double t : bank_breaks) {
+            if (!within(kinks, t)) throw std::runtime_error("Breakpoint where no pulse changes slope");
+        }
+        std::cout << "Bank matches " << bank_times.size() << " evaluations and " << bank_breaks.size() << " breakpoints\n";
+
+        // Project JSON written before WaveformVoltageSource gained class versioning
+        std::cout << "\nTesting pre-series JSON project...\n";
+        const std::string legacy_json = R"JSON({
+    "circuit_elements": [
+        {
+            "polymorphic_id": 2147483649,
+            "polymorphic_name": "WaveformVoltageSource",
+            "ptr_wrapper": {
+                "valid": 1,
+                "data": {
+                    "value0": {
+                        "name": "VW",
+                        "node1_id": "IN",
+                        "node2_id": "0"
+                    },
+                    "voltage_values": [
+                        0.0,
+                        1.0,
+                        0.5
+                    ],
+                    "sampling_rate": 1000.0,
+                    "signal_duration": 0.003,
+                    "start_time": 0.0,
+                    "repeat": true
+                }
+            }
+        },
+        {
+            "polymorphic_id": 2147483650,
+            "polymorphic_name": "Resistor",
+            "ptr_wrapper": {
+                "valid": 1,
+                "data": {
+                    "value0": {
+                        "name": "R1",
+                        "node1_id": "IN",
+                        "node2_id": "0"
+                    },
+                    "resistance": 1000.0
+                }
+            }
+        },
+        {
+            "polymorphic_id": 2147483651,
+            "polymorphic_name": "Ground",
+            "ptr_wrapper": {
+                "valid": 1,
+                "data": {
+                    "value0": {
+                        "name": "GND",
+                        "node1_id": "0",
+                        "node2_id": "0"
+                    }
+                }
+            }
+        }
+    ],
+    "ground_node": "0"
+})JSON";
+        Circuit legacy;
+        ProjectSerializer::loadFromString(legacy, legacy_json);
+        auto* wave = dynamic_cast<WaveformVoltageSource*>(legacy.getElement("VW"));
+        if (!wave || wave->isStreamed() || wave->getVoltageValues() != std::vector<double>{0.0, 1.0, 0.5} ||
+            wave->getSamplingRate() != 1000.0 || !wave->getRepeat() || !legacy.getElement("R1")) {
+            throw std::runtime_error("Pre-series JSON project loaded incorrectly");
+        }
+        std::cout << "Loaded " << legacy.getElements().size() << " elements from pre-series JSON\n";
+
+        // Chunked binary project: TOC layout, lazy sample load and the staleness check
+        std::cout << "\nTesting chunked binary project...\n";
+        const std::filesystem::path project_path = std::filesystem::temp_directory_path() / "test_simulator_project.ckt";
+        std::vector<double> samples(1000);
+        for (size_t i = 0; i < samples.size(); ++i) samples[i] = std::sin(0.01 * static_cast<double>(i));
+        Circuit chunked;
+        chunked.addElement(std::make_unique<WaveformVoltageSource>("VW", "IN", "0", samples, 1000.0, 1.0));
+        chunked.addElement(std::make_unique<Resistor>("R1", "IN", "0", 1000.0));
+        chunked.addElement(std::make_unique<Ground>("GND", "0"));
+        ProjectSerializer::save(chunked, project_path.string());
+        {
+            std::ifstream file(project_path, std::ios::in | std::ios::binary);
+            char magic[8] = {};
+            file.read(magic, sizeof(magic));
+            uint32_t version = 0;
+            std::vector<ProjectChunk> toc;
+            cereal::PortableBinaryInputArchive archive(file);
+            archive(version, toc);
+            if (std::string(magic) != "CKTPROJ" || version != ProjectSerializer::BINARY_VERSION || toc.size() != 2 ||
+                toc[0].tag != "TOPO" || toc[1].tag != "SMPL" || toc[1].offset != toc[0].size ||
+                toc[1].size != samples.size() * sizeof(double)) {
+                throw std::runtime_error("Chunked project table of contents is wrong");
+            }
+        }
+        Circuit reloaded;
+        ProjectSerializer::load(reloaded, project_path.string());
+        auto* lazy = dynamic_cast<WaveformVoltageSource*>(reloaded.getElement("VW"));
+        if (!lazy || !lazy->hasDeferredSamples() || !reloaded.getElement("R1")) {
+            throw std::runtime_error("Chunked project did not defer its samples");
+        }
+        if (lazy->getVoltageValues() != samples || lazy->hasDeferredSamples()) {
+            throw std::runtime_error("Deferred samples read back incorrectly");
+        }
+        // Snapshots are self-contained, so a deferred source reads its samples on the way in
+        ProjectSerializer::load(reloaded, project_path.string());
+        const std::string snapshot = ProjectSerializer::saveToString(reloaded);
+        if (dynamic_cast<WaveformVoltageSource*>(reloaded.getElement("VW"))->hasDeferredSamples()) {
+            throw std::runtime_error("Snapshot left samples deferred");
+        }
+        Circuit restored;
+        ProjectSerializer::loadFromString(restored, snapshot);
+        if (dynamic_cast<WaveformVoltageSource*>(restored.getElement("VW"))->getVoltageValues() != samples) {
+            throw std::runtime_error("Snapshot samples differ");
+        }
+        // A file that changed after loading must not be read from
+        ProjectSerializer::load(reloaded, project_path.string());
+        std::ofstream(project_path, std::ios::out | std::ios::binary | std::ios::app).put('\0');
+        bool stale_rejected = false;
+        try {
+            dynamic_cast<WaveformVoltageSource*>(reloaded.getElement("VW"))->getVoltageValues();
+        } catch (const std::runtime_error&) {
+            stale_rejected = true;
+        }
+        std::filesystem::remove(project_path);
+        if (!stale_rejected) throw std::runtime_error("Stale project file was read");
+        std::cout << "Round-tripped " << samples.size() << " deferred samples\n";
+
+        // Transient checkpoint: a run resumed from its checkpoint matches an uninterrupted one
+        std::cout << "\nTesting transient checkpoint resume...\n";
+        const std::filesystem::path checkpoint_path = std::filesystem::temp_directory_path() / "test_simulator.ckpt";
+        auto buildResumable = [](Circuit& c) {
+            DeviceModelCard sw{"SW", "SW", {{"RON", 1.0}, {"ROFF", 1e6}}};
+            c.addElement(std::make_unique<PulseVoltageSource>("VS", "IN", "0", 0.0, 5.0, 1e-4, 1e-5, 1e-5, 4e-4, 1e-3));
+            c.addElement(std::make_unique<Resistor>("R1", "IN", "A", 100.0));
+            c.addElement(std::make_unique<Capacitor>("C1", "A", "0", 1e-6));
+            c.addElement(std::make_unique<Inductor>("L1", "A", "B", 1e-3));
+            c.addElement(std::make_unique<Switch>("S1", "B", "0", std::vector<double>{5e-4, 1.5e-3}, sw));
+            c.addElement(std::make_unique<BehavioralSource>("B1", "0", "OUT", BehavioralSource::Kind::CURRENT, "1e3 * I(VS) * I(VS)"));
+            c.addElement(std::make_unique<Resistor>("RO", "OUT", "0", 1000.0));
+            c.addElement(std::make_unique<Ground>("GND", "0"));
+        };
+        Circuit whole, first_half, second_half;
+        buildResumable(whole);
+        buildResumable(first_half);
+        buildResumable(second_half);
+        TransientAnalysis tran_whole(1e-5, 2e-3, false);
+        tran_whole.analyze(whole, mna, solver);
+        TransientAnalysis tran_first(1e-5, 1e-3, false);
+        tran_first.setCheckpointing(checkpoint_path.string(), 1e9); // Only the final checkpoint
+        tran_first.analyze(first_half, mna, solver);
+        TransientAnalysis tran_second(1e-5, 2e-3, false);
+        tran_second.resumeFrom(checkpoint_path.string());
+        tran_second.analyze(second_half, mna, solver);
+        if (tran_second.getTimePoints() != tran_whole.getTimePoints() || tran_second.getResults() != tran_whole.getResults()) {
+            throw std::runtime_error("Resumed transient differs from the uninterrupted run");
+        }
+        std::cout << "Resumed run matches over " << tran_whole.getTimePoints().size() << " time points\n";
+
+        // Truncated files, foreign files and unknown versions are refused
+        auto expectCheckpointRejected = [&](const std::string& bytes, const char* what) {
+            std::ofstream(checkpoint_path, std::ios::out | std::ios::binary | std::ios::trunc) << bytes;
+            try {
+                TransientCheckpoint::load(checkpoint_path.string());
+            } catch (const std::runtime_error&) {
+                return;
+            }
+            throw std::runtime_error(std::string("Accepted ") + what + " checkpoint");
+        };
+        std::string checkpoint_bytes;
+        {
+            tran_first.analyze(first_half, mna, solver);
+            std::ifstream file(checkpoint_path, std::ios::in | std::ios::binary);
+            checkpoint_bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::ostringstream future(std::ios::out | std::ios::binary);
+        future.write(checkpoint_bytes.data(), 8);
+        {
+            cereal::PortableBinaryOutputArchive archive(future);
+            archive(TransientCheckpoint::VERSION + 1);
+        }
+        expectCheckpointRejected(checkpoint_bytes.substr(0, checkpoint_bytes.size() / 2), "a truncated");
+        expectCheckpointRejected("not a checkpoint", "a foreign");
+        expectCheckpointRejected(future.str() + checkpoint_bytes.substr(8 + 5), "a newer");
+        std::filesystem::remove(checkpoint_path);
+        std::cout << "Corrupt and wrong-version checkpoints rejected\n";
+
+        // Periodic steady state against the last period of a long transient on the same grid
+        std::cout << "\nTesting periodic steady state...\n";
+        auto comparePSS = [&](Circuit& c, const std::string& var, int periods, double tolerance, const char* label) {
+            const double period = 1e-3;
+            const int steps = 100;
+            PSSAnalysis pss(period, steps);
+            pss.analyze(c, mna, solver);
+            if (!pss.hasConverged()) throw std::runtime_error(std::string("PSS did not converge for the ") + label);
+            TransientAnalysis settle(period / steps, periods * period, false);
+            settle.analyze(c, mna, solver);
+            const auto& periodic = pss.getResults().at(var);
+            const auto& settled = settle.getResults().at(var);
+            const size_t offset = settled.size() - periodic.size();
+            double worst = 0.0;
+            for (size_t k = 0; k < periodic.size(); ++k) worst = std::max(worst, std::abs(periodic[k] - settled[offset + k]));
+            std::cout << label << ": max |PSS - transient| = " << worst << " V after " << pss.getNewtonIterations()
+                      << " Newton iterations\n";
+            if (worst > tolerance) throw std::runtime_error(std::string("PSS waveform differs from the settled transient for the ") + label);
+        };
+        Circuit rlc;
+        rlc.addElement(std::make_unique<SinusoidalVoltageSource>("VS", "IN", "0", 0.0, 1.0, 1e3));
+        rlc.addElement(std::make_unique<Resistor>("R1", "IN", "A", 10.0));
+        rlc.addElement(std::make_unique<Inductor>("L1", "A", "B", 1e-3));
+        rlc.addElement(std::make_unique<Capacitor>("C1", "B", "0", 10e-6));
+        rlc.addElement(std::make_unique<Ground>("GND", "0"));
+        comparePSS(rlc, "V(B)", 40, 1e-6, "series RLC");
+        Circuit rectifier;
+        rectifier.addElement(std::make_unique<SinusoidalVoltageSource>("VS", "IN", "0", 0.0, 5.0, 1e3));
+        rectifier.addElement(std::make_unique<Resistor>("RS", "IN", "A", 10.0));
+        rectifier.addElement(std::make_unique<Diode>("D1", "A", "OUT", "D"));
+        rectifier.addElement(std::make_unique<Capacitor>("C1", "OUT", "0", 100e-6)); // 10 periods of RC: not settled by warm-up
+        rectifier.addElement(std::make_unique<Resistor>("RL", "OUT", "0", 100.0));
+        rectifier.addElement(std::make_unique<Ground>("GND", "0"));
+        comparePSS(rectifier, "V(OUT)", 150, 1e-6, "half-wave rectifier");
+        // Phi must depend on the state alone: junction limiting state may not leak between periods
+        PSSAnalysis rectifier_pss(1e-3, 100);
+        rectifier_pss.analyze(rectifier, mna, solver);
+        const Vector steady = rectifier_pss.getPeriodicState();
+        // Kicked states put several volts across the junction, so voltage limiting engages
+        for (size_t kicked = 0; kicked < steady.size(); ++kicked) {
+            Vector start_up(steady.size(), -6.0);
+            start_up[kicked] = 6.0;
+            const Vector phi_first = rectifier_pss.periodMap(rectifier, mna, solver, start_up);
+            const Vector phi_again = rectifier_pss.periodMap(rectifier, mna, solver, start_up);
+            const Vector phi_steady = rectifier_pss.periodMap(rectifier, mna, solver, steady);
+            double steady_drift = 0.0;
+            for (size_t i = 0; i < steady.size(); ++i) steady_drift = std::max(steady_drift, std::abs(phi_steady[i] - steady[i]));
+            if (phi_first != phi_again || steady_drift > 1e-6) {
+                throw std::runtime_error("PSS period map is not a function of the state alone");
+            }
+        }
+
+        // Phase sweep by superposition against a full AC solve at every phase point
+        std::cout << "\nTesting phase sweep superposition...\n";
+        Circuit phased;
+        phased.addElement(std::make_unique<PhaseVoltageSource>("P1", "IN", "0", 2.0, 2 * M_PI * 1e3, 0.0));
+        phased.addElement(std::make_unique<Resistor>("R1", "IN", "A", 100.0));
+        phased.addElement(std::make_unique<Capacitor>("C1", "A", "0", 1e-6));
+        phased.addElement(std::make_unique<Inductor>("L1", "A", "B", 10e-3));
+        phased.addElement(std::make_unique<Resistor>("R2", "B", "0", 50.0));
+        phased.addElement(std::make_unique<ACVoltageSource>("V2", "S", "0", 1.0, 30.0, 1e3));
+        phased.addElement(std::make_unique<Resistor>("R3", "S", "A", 200.0));
+        phased.addElement(std::make_unique<Ground>("GND", "0"));
+        PhaseSweepAnalysis phase_sweep("P1", -180.0, 180.0, 1e3, 13);
+        phase_sweep.analyze(phased, mna, solver);
+        auto* swept = static_cast<PhaseVoltageSource*>(phased.getElement("P1"));
+        ComplexLinearSolver complex_solver;
+        for (size_t i = 0; i < phase_sweep.getPhasePoints().size(); ++i) {
+            swept->setPhase(phase_sweep.getPhasePoints()[i] * M_PI / 180.0);
+            ComplexMNAMatrix full;
+            NodeIndexMap full_nodes;
+            std::map<std::string, int> full_sources;
+            full.build(phased, 2 * M_PI * 1e3, full_nodes, full_sources);
+            ComplexVector x = complex_solver.solve(full.getA(), full.getRHS());
+            for (const auto& pair : full_nodes) {
+                const Complex expected = x[pair.second];
+                const Complex actual = phase_sweep.getComplexResults().at("V(" + pair.first + ")").at(i);
+                if (std::abs(actual - expected) > 1e-9 * (1.0 + std::abs(expected))) {
+                    throw std::runtime_error("Phase sweep differs from the full solve at " +
+                                             std::to_string(phase_sweep.getPhasePoints()[i]) + " degrees");
+                }
+            }
+        }
+        std::cout << "Superposition matches " << phase_sweep.getPhasePoints().size() << " full solves\n";
+
+        // Exponential integrator on femtofarad RC and RLC step responses: exact against the
+        // closed form, and within backward Euler's first-order error of the companion-model run
+        std::cout << "\nTesting exponential integrator...\n";
+        auto compareExponential = [&](Circuit& c, double t_step, double t_stop, double be_tolerance,
+                                      const std::function<double(double)>& exact, const char* label) {
+            TransientAnalysis exponential(t_step, t_stop, true), euler(t_step, t_stop, true);
+            exponential.setMethod(TransientMethod::EXPONENTIAL);
+            exponential.analyze(c, mna, solver);
+            euler.analyze(c, mna, solver);
+            const auto& v_exp = exponential.getResults().at("V(OUT)");
+            const auto& v_be = euler.getResults().at("V(OUT)");
+            if (v_exp.size() != v_be.size()) throw std::runtime_error(std::string("Exponential and Euler grids differ for the ") + label);
+            double exact_error = 0.0, euler_gap = 0.0;
+            for (size_t k = 0; k < v_exp.size(); ++k) {
+                exact_error = std::max(exact_error, std::abs(v_exp[k] - exact(exponential.getTimePoints()[k])));
+                euler_gap = std::max(euler_gap, std::abs(v_exp[k] - v_be[k]));
+            }
+            std::cout << label << ": max error " << exact_error << " V, max |exp - BE| " << euler_gap << " V\n";
+            if (exact_error > 1e-8 || euler_gap > be_tolerance) {
+                throw std::runtime_error(std::string("Exponential integrator is inaccurate for the ") + label);
+            }
+        };
+        Circuit rc_fast;
+        rc_fast.addElement(std::make_unique<IndependentVoltageSource>("VS", "IN", "0", 1.0));
+        rc_fast.addElement(std::make_unique<Resistor>("R1", "IN", "OUT", 1000.0));
+        rc_fast.addElement(std::make_unique<Capacitor>("C1", "OUT", "0", 1e-15));
+        rc_fast.addElement(std::make_unique<Ground>("GND", "0"));
+        const double tau = 1e-12;
+        // BE lags the exact response by about (h / 2 tau) e^-1 of the step
+        compareExponential(rc_fast, 1e-14, 5e-12, 2e-3, [&](double t) { return 1.0 - std::exp(-t / tau); }, "RC");
+        Circuit rlc_fast;
+        rlc_fast.addElement(std::make_unique<IndependentVoltageSource>("VS", "IN", "0", 1.0));
+        rlc_fast.addElement(std::make_unique<Resistor>("R1", "IN", "A", 10.0));
+        rlc_fast.addElement(std::make_unique<Inductor>("L1", "A", "OUT", 10e-9));
+        rlc_fast.addElement(std::make_unique<Capacitor>("C1", "OUT", "0", 10e-12));
+        rlc_fast.addElement(std::make_unique<Ground>("GND", "0"));
+        const double alpha = 10.0 / (2 * 10e-9), omega_d = std::sqrt(1.0 / (10e-9 * 10e-12) - alpha * alpha);
+        compareExponential(rlc_fast, 1e-12, 1e-8, 5e-2, [&](double t) {
+            return 1.0 - std::exp(-alpha * t) * (std::cos(omega_d * t) + alpha / omega_d * std::sin(omega_d * t));
+        }, "RLC");
+
+        // Krylov solvers on a resistive grid MNA system (a voltage source gives a zero pivot)
+        std::cout << "\nTesting iterative solvers...\n";
+        Circuit grid;
+        const int grid_size = 8;
+        auto gridNode = [](int r, int c) { return "G" + std::to_string(r) + "_" + std::to_string(c); };
+        for (int r = 0; r < grid_size; ++r) {
+            for (int c = 0; c < grid_size; ++c) {
+                if (c + 1 < grid_size) grid.addElement(std::make_unique<Resistor>("RH" + gridNode(r, c), gridNode(r, c), gridNode(r, c + 1), 1000.0 + 10.0 * r));
+                if (r + 1 < grid_size) grid.addElement(std::make_unique<Resistor>("RV" + gridNode(r, c), gridNode(r, c), gridNode(r + 1, c), 1000.0 + 10.0 * c));
+            }
+        }
+        grid.addElement(std::make_unique<IndependentVoltageSource>("VG", gridNode(0, 0), "0", 1.0));
+        grid.addElement(std::make_unique<IndependentCurrentSource>("IG", "0", gridNode(grid_size - 1, grid_size - 1), 1e-3));
+        grid.addElement(std::make_unique<Resistor>("RGND", gridNode(grid_size - 1, 0), "0", 500.0));
+        grid.addElement(std::make_unique<Ground>("GND", "0"));
+        mna.build(grid, false, 0.0, 0.0);
+        const Vector grid_reference = LUFactors::factor(mna.getA()).solve(mna.getRHS());
+        for (IterativeMethod method : {IterativeMethod::GMRES, IterativeMethod::BICGSTAB}) {
+            for (Preconditioner preconditioner : {Preconditioner::NONE, Preconditioner::ILU0, Preconditioner::ILUT}) {
+                MNASolverConfig config;
+                config.use_iterative_solver = true;
+                config.iterative_method = method;
+                config.preconditioner = preconditioner;
+                config.max_iterations = 2000;
+                std::unique_ptr<LinearSolver> krylov = makeLinearSolver(config);
+                const Vector x = krylov->solve(mna.getA(), mna.getRHS());
+                const auto* iterative = dynamic_cast<const IterativeSolver*>(krylov.get());
+                double worst = 0.0;
+                for (size_t i = 0; i < x.size(); ++i) worst = std::max(worst, std::abs(x[i] - grid_reference[i]));
+                const std::string label = std::string(method == IterativeMethod::GMRES ? "GMRES" : "BiCGSTAB") + "/" +
+                    (preconditioner == Preconditioner::NONE ? "none" : preconditioner == Preconditioner::ILU0 ? "ILU(0)" : "ILUT");
+                std::cout << label << ": " << iterative->lastIterations() << " iterations, max |x - x_LU| = " << worst << "\n";
+                // A residual above the tolerance means the result came from the LU fallback
+                if (iterative->lastResidual() > config.tolerance || worst > 1e-6) {
+                    throw std::runtime_error(label + " did not reproduce the LU solution");
+                }
+            }
+        }
+
+        // Mixed-precision LU: refinement converges on a badly column-scaled but benign matrix
+        // (no up-front condition gate), and falls back to double LU on a Hilbert matrix
+        std::cout << "\nTesting mixed-precision LU...\n";
+        const std::vector<double> column_scale = {1.0, 1e3, 1e-3, 1e6, 1e-6, 1.0};
+        const size_t scaled_n = column_scale.size();
+        Matrix scaled(scaled_n, Vector(scaled_n));
+        Vector scaled_rhs(scaled_n, 0.0);
+        for (size_t i = 0; i < scaled_n; ++i) {
+            for (size_t j = 0; j < scaled_n; ++j) {
+                const double gap = static_cast<double>(i > j ? i - j : j - i);
+                scaled[i][j] = (1.0 / (1.0 + gap) + (i == j ? 3.0 : 0.0)) * column_scale[j];
+                scaled_rhs[i] += scaled[i][j]; // Solution is all ones
+            }
+        }
+        MixedPrecisionLUSolver mixed;
+        Vector mixed_x = mixed.solve(scaled, scaled_rhs);
+        // Normwise backward error |b - A x| / (|A| |x|), infinity norms
+        double residual_norm = 0.0, a_norm = 0.0, x_norm = 0.0;
+        for (size_t i = 0; i < scaled_n; ++i) {
+            double residual = scaled_rhs[i], row_sum = 0.0;
+            for (size_t j = 0; j < scaled_n; ++j) {
+                residual -= scaled[i][j] * mixed_x[j];
+                row_sum += std::abs(scaled[i][j]);
+            }
+            residual_norm = std::max(residual_norm, std::abs(residual));
+            a_norm = std::max(a_norm, row_sum);
+            x_norm = std::max(x_norm, std::abs(mixed_x[i]));
+        }
+        const double backward_error = residual_norm / (a_norm * x_norm);
+        std::cout << "Column-scaled system: " << mixed.lastRefinements() << " refinements, backward error " << backward_error << "\n";
+        if (mixed.lastFellBack() || mixed.lastRefinements() < 1 ||
+            backward_error > std::sqrt(static_cast<double>(scaled_n)) * std::numeric_limits<double>::epsilon()) {
+            throw std::runtime_error("Mixed-precision refinement did not converge on a well-posed system");
+        }
+        const size_t hilbert_n = 12;
+        Matrix hilbert(hilbert_n, Vector(hilbert_n));
+        Vector hilbert_rhs(hilbert_n, 1.0);
+        for (size_t i = 0; i < hilbert_n; ++i) {
+            for (size_t j = 0; j < hilbert_n; ++j) hilbert[i][j] = 1.0 / static_cast<double>(i + j + 1);
+        }
+        for (int attempt = 0; attempt < 2; ++attempt) { // The second fallback is logged as info, not a warning
+            mixed_x = mixed.solve(hilbert, hilbert_rhs);
+            if (!mixed.lastFellBack() || mixed_x != LUFactors::factor(hilbert).solve(hilbert_rhs)) {
+                throw std::runtime_error("Mixed-precision LU did not fall back on an ill-conditioned system");
+            }
+        }
+        std::cout << "Hilbert system fell back to double LU after " << mixed.lastRefinements() << " refinements\n";
+
+        // Live tuning (Sherman-Morrison-Woodbury) after retuning a resistor, a capacitor and
+        // an inductor, against full AC and DC sweeps of the edited circuit
+        std::cout << "\nTesting live tuning updates...\n";
+        Circuit tuned;
+        tuned.addElement(std::make_unique<IndependentVoltageSource>("V1", "IN", "0", 1.0));
+        tuned.addElement(std::make_unique<Resistor>("R1", "IN", "A", 100.0));
+        tuned.addElement(std::make_unique<Capacitor>("C1", "A", "0", 1e-6));
+        tuned.addElement(std::make_unique<Inductor>("L1", "A", "B", 10e-3));
+        tuned.addElement(std::make_unique<Resistor>("R2", "B", "0", 50.0));
+        tuned.addElement(std::make_unique<Resistor>("R3", "A", "0", 1000.0));
+        tuned.addElement(std::make_unique<Ground>("GND", "0"));
+        ACSweepAnalysis ac_live("V1", 10.0, 100e3, 10, "DEC");
+        DCSweepAnalysis dc_live("V1", 0.0, 5.0, 0.5);
+        ac_live.startLiveTuning(tuned);
+        dc_live.startLiveTuning(tuned, mna);
+        const std::vector<std::pair<std::string, double>> edits = {{"R1", 220.0}, {"C1", 4.7e-6}, {"L1", 2.2e-3}, {"R3", 330.0}};
+        for (const auto& edit : edits) {
+            Element* edited = tuned.getElement(edit.first);
+            edited->setValue(edit.second);
+            if (!ac_live.retune(tuned, *edited) || !dc_live.retune(tuned, mna, *edited)) {
+                throw std::runtime_error("Live tuning refused to retune " + edit.first);
+            }
+            ACSweepAnalysis ac_full("V1", 10.0, 100e3, 10, "DEC");
+            DCSweepAnalysis dc_full("V1", 0.0, 5.0, 0.5);
+            ac_full.analyze(tuned, mna, solver);
+            dc_full.analyze(tuned, mna, solver);
+            if (ac_live.getComplexResults().empty() || dc_live.getResults().empty()) throw std::runtime_error("Live tuning produced no results");
+            for (const auto& pair : ac_live.getComplexResults()) {
+                const auto& full = ac_full.getComplexResults().at(pair.first);
+                for (size_t i = 0; i < full.size(); ++i) {
+                    if (std::abs(pair.second.at(i) - full[i]) > 1e-9 * (1.0 + std::abs(full[i]))) {
+                        throw std::runtime_error("Live AC " + pair.first + " differs after retuning " + edit.first);
+                    }
+                }
+            }
+            if (dc_live.getSweepValues() != dc_full.getSweepValues()) throw std::runtime_error("Live DC sweep points differ");
+            for (const auto& pair : dc_live.getResults()) {
+                const auto& full = dc_full.getResults().at(pair.first);
+                for (size_t i = 0; i < full.size(); ++i) {
+                    if (std::abs(pair.second.at(i) - full[i]) > 1e-9 * (1.0 + std::abs(full[i]))) {
+                        throw std::runtime_error("Live DC " + pair.first + " differs after retuning " + edit.first);
+                    }
+                }
+            }
+        }
+        std::cout << "Live AC and DC results match full sweeps after " << edits.size() << " edits\n";
+
+        std::cout << "\nTesting result cache...\n";
+        auto buildCached = [](Circuit& c, bool reversed, bool with_scratch) {
+            std::vector<std::unique_ptr<Element>> parts;
+            parts.push_back(std::make_unique<IndependentVoltageSource>("V1", "IN", "0", 2.0));
+            parts.push_back(std::make_unique<Resistor>("R1", "IN", "OUT", 1000.0));
+            if (with_scratch) parts.push_back(std::make_unique<Resistor>("RX", "IN", "0", 10.0));
+            parts.push_back(std::make_unique<Capacitor>("C1", "OUT", "0", 1e-6));
+            parts.push_back(std::make_unique<Resistor>("R2", "OUT", "0", 2000.0));
+            parts.push_back(std::make_unique<Ground>("GND", "0"));
+            if (reversed) std::reverse(parts.begin(), parts.end());
+            for (auto& part : parts) c.addElement(std::move(part));
+            if (with_scratch) c.deleteElement("RX"); // Swap-and-pop moves the last element into its slot
+        };
+        Circuit cached_a, cached_b, cached_c;
+        buildCached(cached_a, false, false);
+        buildCached(cached_b, true, false);
+        buildCached(cached_c, false, true);
+        TransientAnalysis cached_tran(1e-5, 1e-3);
+        const uint64_t key_a = ResultCache::key(cached_a, cached_tran, solver);
+        if (key_a == 0) throw std::runtime_error("Cacheable circuit produced no key");
+        if (ResultCache::key(cached_b, cached_tran, solver) != key_a) throw std::runtime_error("Cache key depends on insertion order");
+        if (ResultCache::key(cached_c, cached_tran, solver) != key_a) throw std::runtime_error("Cache key depends on a deleted element");
+        cached_b.getElement("R1")->setValue(1000.0 * (1.0 + 1e-12));
+        if (ResultCache::key(cached_b, cached_tran, solver) == key_a) throw std::runtime_error("Cache key ignores a value change");
+        if (ResultCache::key(cached_a, TransientAnalysis(1e-5, 2e-3), solver) == key_a) throw std::runtime_error("Cache key ignores Tstop");
+        if (ResultCache::key(cached_a, cached_tran, GaussianEliminationSolver()) == key_a) throw std::runtime_error("Cache key ignores the solver type");
+        if (ResultCache::key(cached_a, cached_tran, IterativeSolver(IterativeMethod::GMRES, Preconditioner::ILU0, 1e-10)) ==
+            ResultCache::key(cached_a, cached_tran, IterativeSolver(IterativeMethod::GMRES, Preconditioner::ILU0, 1e-4))) {
+            throw std::runtime_error("Cache key ignores the iterative tolerance");
+        }
+        if (ResultCache::key(cached_a, cached_tran, MixedPrecisionLUSolver(30)) == ResultCache::key(cached_a, cached_tran, MixedPrecisionLUSolver(0))) {
+            throw std::runtime_error("Cache key ignores the refinement limit");
+        }
+
+        ResultCache result_cache;
+        if (result_cache.analyze(cached_tran, cached_a, mna, solver) || result_cache.size() != 1) throw std::runtime_error("First run was not stored");
+        TransientAnalysis cached_tran_again(1e-5, 1e-3);
+        if (!result_cache.analyze(cached_tran_again, cached_c, mna, solver)) throw std::runtime_error("Equivalent circuit missed the cache");
+        if (cached_tran_again.getResults() != cached_tran.getResults() || cached_tran_again.getTimePoints() != cached_tran.getTimePoints()) {
+            throw std::runtime_error("Cached transient differs from the run that stored it");
+        }
+        DCSweepAnalysis missing_source("VMISSING", 0.0, 1.0, 0.5);
+        result_cache.analyze(missing_source, cached_a, mna, solver);
+        if (result_cache.size() != 1) throw std::runtime_error("Failed DC sweep was cached");
+
+        auto sized = [](const std::string& settings, size_t points) {
+            auto r = std::make_shared<CachedResult>();
+            r->analysis = settings;
+            r->axis.assign(points, 1.0);
+            r->real["V(OUT)"].assign(points, 0.5);
+            return r;
+        };
+        const size_t entry_bytes = sized("A", 1000)->byteSize();
+        ResultCache lru_cache(entry_bytes * 2 + entry_bytes / 2); // Room for two entries
+        lru_cache.store(1, sized("A", 1000));
+        lru_cache.store(2, sized("B", 1000));
+        if (!lru_cache.find(1, "A")) throw std::runtime_error("LRU lost an entry within budget");
+        lru_cache.store(3, sized("C", 1000)); // Evicts 2, the least recently used
+        if (lru_cache.size() != 2 || lru_cache.bytes() > entry_bytes * 2 + entry_bytes / 2) throw std::runtime_error("LRU exceeds its byte budget");
+        if (lru_cache.find(2, "B") || !lru_cache.find(1, "A") || !lru_cache.find(3, "C")) throw std::runtime_error("LRU evicted the wrong entry");
+        if (lru_cache.find(1, "B")) throw std::runtime_error("Settings mismatch under the same key was returned");
+        lru_cache.store(4, sized("D", 10000)); // Larger than the whole budget: not held in memory
+        if (lru_cache.find(4, "D") || lru_cache.size() != 2) throw std::runtime_error("Oversized entry displaced the LRU");
+
+        const std::string cache_dir = (std::filesystem::temp_directory_path() / "result_cache_test").string();
+        std::filesystem::remove_all(cache_dir);
+        {
+            ResultCache disk_cache;
+            disk_cache.setDiskDirectory(cache_dir);
+            auto stored = sized("TRAN disk", 64);
+            stored->complex["V(IN)"] = {Complex(1.0, -2.0), Complex(0.25, 3.0)};
+            stored->complete = false;
+            disk_cache.store(42, stored);
+            disk_cache.clear();
+            auto loaded = disk_cache.find(42, "TRAN disk");
+            if (!loaded || loaded->axis != stored->axis || loaded->real != stored->real || loaded->complex != stored->complex || loaded->complete) {
+                throw std::runtime_error("Disk round trip changed the result");
+            }
+            disk_cache.clear();
+            if (disk_cache.find(42, "TRAN other")) throw std::runtime_error("Disk entry returned for different settings");
+            ResultCache restarted;
+            restarted.setDiskDirectory(cache_dir);
+            if (!restarted.find(42, "TRAN disk")) throw std::runtime_error("Disk entry lost across cache instances");
+        }
+        std::filesystem::remove_all(cache_dir);
+        std::cout << "Result cache keys, LRU budget and disk store behave\n";
+
+        // Test the batched device math kernels and a diode to ground
+        std::cout << "\nTesting device math kernels...\n";
+        double exp_err = 0.0, log_err = 0.0;
+        for (int i = 0; i <= 200000; ++i) {
+            const double x = std::min(DeviceMath::EXP_ARG_LIMIT, -DeviceMath::EXP_ARG_LIMIT + 2 * DeviceMath::EXP_ARG_LIMIT * i / 200000.0 + 1e-7 * (i % 7));
+            exp_err = std::max(exp_err, std::abs(DeviceMath::fastExp(x) / std::exp(x) - 1.0));
+        }
+        std::vector<double> log_points;
+        for (int i = 0; i <= 200000; ++i) log_points.push_back(std::pow(10.0, -300.0 + 600.0 * i / 200000.0));
+        for (int i = 1; i <= 2000; ++i) {
+            log_points.push_back(1.0 + i * 1e-9);
+            log_points.push_back(1.0 - i * 1e-9);
+            log_points.push_back(0.5 * std::sqrt(2.0) * (1.0 + (i - 1000) * 1e-12));
+            log_points.push_back(std::sqrt(2.0) * (1.0 + (i - 1000) * 1e-12));
+        }
+        log_points.push_back(5e-320);
+        log_points.push_back(std::numeric_limits<double>::denorm_min());
+        for (double x : log_points) {
+            if (x == 1.0) continue;
+            log_err = std::max(log_err, std::abs(DeviceMath::fastLog(x) / std::log(x) - 1.0));
+        }
+        if (exp_err >= 1e-14) throw std::runtime_error("fastExp relative error above 1e-14");
+        if (log_err >= 3e-15) throw std::runtime_error("fastLog relative error above 3e-15");
+        if (DeviceMath::fastLog(1.0) != 0.0) throw std::runtime_error("fastLog(1) is not zero");
+        std::cout << "Max relative error: fastExp " << exp_err << ", fastLog " << log_err << "\n";
+
+        // Forward-biased diodes with the cathode and the anode on ground; defaults Is = 1e-12, n = 1, Vt = 0.026
+        Circuit diode_circuit;
+        diode_circuit.addElement(std::make_unique<IndependentVoltageSource>("VP", "P", "0", 5.0));
+        diode_circuit.addElement(std::make_unique<Resistor>("RP", "P", "A", 1000.0));
+        diode_circuit.addElement(std::make_unique<Diode>("DA", "A", "0", "D"));
+        diode_circuit.addElement(std::make_unique<IndependentVoltageSource>("VN", "N", "0", -2.0));
+        diode_circuit.addElement(std::make_unique<Resistor>("RN", "N", "K", 1000.0));
+        diode_circuit.addElement(std::make_unique<Diode>("DK", "0", "K", "D"));
+        diode_circuit.addElement(std::make_unique<Ground>("GND", "0"));
+        auto diodeVoltage = [](double source) {
+            double v = 0.0;
+            for (int iter = 0; iter < 200; ++iter) {
+                const double f = (source - v) / 1000.0 - 1e-12 * (std::exp(v / 0.026) - 1.0);
+                const double df = -1.0 / 1000.0 - 1e-12 / 0.026 * std::exp(v / 0.026);
+                const double dv = std::max(-0.05, std::min(0.05, -f / df));
+                v += dv;
+                if (std::abs(dv) < 1e-15) break;
+            }
+            return v;
+        };
+        // A DC sweep takes one linearisation per point, so the Newton operating point of a transient is checked
+        TransientAnalysis diode_op(1e-6, 1e-5);
+        diode_op.analyze(diode_circuit, mna, solver);
+        if (diode_op.getResults().at("V(A)").size() != 11) throw std::runtime_error("Diode transient stopped early");
+        const double v_anode = diodeVoltage(5.0), v_cathode = -diodeVoltage(2.0);
+        for (size_t i = 0; i < diode_op.getResults().at("V(A)").size(); ++i) {
+            if (std::abs(diode_op.getResults().at("V(A)")[i] - v_anode) > 1e-6) throw std::runtime_error("Diode to ground has the wrong operating point");
+            if (std::abs(diode_op.getResults().at("V(K)")[i] - v_cathode) > 1e-6) throw std::runtime_error("Diode from ground has the wrong operating point");
+        }
+        std::cout << "Diode operating points: " << diode_op.getResults().at("V(A)").front() << " V and " << diode_op.getResults().at("V(K)").front()
+                  << " V (analytic " << v_anode << " V and " << v_cathode << " V)\n";
+
         std::cout << "\n=== All tests passed successfully! ===\n";
         
     } catch (const std::exception& e) {